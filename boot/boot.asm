@@ -1,6 +1,12 @@
 [BITS 16]
 [ORG 0x7C00]
 
+; خريطة الذاكرة (E820) تُحفظ هنا لتقرأها النواة - انظر E820_MAP_ADDR في memory.h
+E820_MAP        equ 0x500       ; التوقيع ثم عدد المدخلات ثم المدخلات
+E820_ENTRY_SIZE equ 24
+E820_MAX        equ 64
+SMAP            equ 0x534D4150  ; 'SMAP'
+
 start:
     ; إعداد المقاطع
     xor ax, ax
@@ -9,6 +15,9 @@ start:
     mov ss, ax
     mov sp, 0x7C00
     
+    ; اكتشاف الذاكرة قبل أي شيء آخر
+    call detect_memory
+    
     ; مسح الشاشة
     call clear_screen
     
@@ -19,6 +28,39 @@ start:
     ; حلقة لا نهائية للحفاظ على تشغيل النظام
     jmp $
     
+; اكتشاف الذاكرة عبر BIOS: int 0x15, eax=0xE820
+; عند النجاح: [E820_MAP] = 'SMAP' و [E820_MAP+4] = عدد المدخلات
+detect_memory:
+    mov dword [E820_MAP], 0
+    mov dword [E820_MAP + 4], 0
+    mov di, E820_MAP + 8
+    xor ebx, ebx
+    xor bp, bp
+.next:
+    mov eax, 0xE820
+    mov edx, SMAP
+    mov ecx, E820_ENTRY_SIZE
+    mov dword [di + 20], 1  ; سمات ACPI: المدخل صالح إذا لم يكتبها BIOS
+    int 0x15
+    jc .done                ; غير مدعوم أو انتهت القائمة
+    cmp eax, SMAP
+    jne .done
+    jcxz .skip              ; تجاهل المدخلات الفارغة
+    inc bp
+    add di, E820_ENTRY_SIZE
+.skip:
+    test ebx, ebx           ; ebx = 0 بعد آخر مدخل
+    jz .done
+    cmp bp, E820_MAX
+    jb .next
+.done:
+    mov [E820_MAP + 4], bp
+    test bp, bp
+    jz .ret
+    mov dword [E820_MAP], SMAP
+.ret:
+    ret
+    
 clear_screen:
     ; تعيين وضع الفيديو لمسح الشاشة
     mov ah, 0x00        ; وظيفة تعيين وضع الفيديو
@@ -0,0 +1,140 @@
+#include "acpi.h"
+#include "memory.h"
+
+static madt_info_t madt_info;
+static bool madt_found = false;
+
+// مجموع كل البايتات يجب أن يكون صفراً
+static bool acpi_checksum(const void* table, uint32_t length) {
+    const uint8_t* bytes = (const uint8_t*)table;
+    uint8_t sum = 0;
+    
+    for (uint32_t i = 0; i < length; i++) {
+        sum += bytes[i];
+    }
+    return sum == 0;
+}
+
+static acpi_rsdp_t* acpi_scan_rsdp(uint32_t start, uint32_t end) {
+    for (uint32_t addr = start; addr < end; addr += ACPI_RSDP_ALIGN) {
+        acpi_rsdp_t* rsdp = (acpi_rsdp_t*)addr;
+    
+        if (memcmp(rsdp->signature, "RSD PTR ", 8) == 0 &&
+            acpi_checksum(rsdp, sizeof(acpi_rsdp_t))) {
+            return rsdp;
+        }
+    }
+    return NULL;
+}
+
+static acpi_rsdp_t* acpi_find_rsdp(void) {
+    uint32_t ebda = (uint32_t)(*(volatile uint16_t*)ACPI_EBDA_SEGMENT_PTR) << 4;
+    acpi_rsdp_t* rsdp = NULL;
+    
+    if (ebda) {
+        rsdp = acpi_scan_rsdp(ebda, ebda + ACPI_EBDA_SEARCH_SIZE);
+    }
+    if (!rsdp) {
+        rsdp = acpi_scan_rsdp(ACPI_BIOS_START, ACPI_BIOS_END);
+    }
+    return rsdp;
+}
+
+// البحث في RSDT (عناوين 32 بت تكفي هذه النواة، حتى مع وجود XSDT)
+static acpi_sdt_header_t* acpi_find_table(acpi_rsdp_t* rsdp, const char* signature) {
+    acpi_sdt_header_t* rsdt = (acpi_sdt_header_t*)rsdp->rsdt_address;
+    uint32_t* entries = (uint32_t*)(rsdt + 1);
+    uint32_t count;
+    
+    if (memcmp(rsdt->signature, "RSDT", 4) != 0 || !acpi_checksum(rsdt, rsdt->length)) {
+        return NULL;
+    }
+    
+    count = (rsdt->length - sizeof(acpi_sdt_header_t)) / sizeof(uint32_t);
+    for (uint32_t i = 0; i < count; i++) {
+        acpi_sdt_header_t* table = (acpi_sdt_header_t*)entries[i];
+    
+        if (memcmp(table->signature, signature, 4) == 0 &&
+            acpi_checksum(table, table->length)) {
+            return table;
+        }
+    }
+    return NULL;
+}
+
+// نسخ المعالجات و IOAPIC الأول وتجاوزات IRQ ISA
+static void acpi_parse_madt(acpi_madt_t* madt) {
+    uint8_t* ptr = (uint8_t*)(madt + 1);
+    uint8_t* end = (uint8_t*)madt + madt->header.length;
+    
+    memset(&madt_info, 0, sizeof(madt_info));
+    madt_info.lapic_address = madt->lapic_address;
+    
+    // بدون تجاوز: IRQ ISA n هو GSI n، حافة وقطبية عالية
+    for (uint32_t irq = 0; irq < ISA_IRQS; irq++) {
+        madt_info.isa_gsi[irq] = irq;
+    }
+    
+    while (ptr + sizeof(madt_entry_t) <= end) {
+        madt_entry_t* entry = (madt_entry_t*)ptr;
+    
+        if (entry->length < sizeof(madt_entry_t)) {
+            break;
+        }
+    
+        if (entry->type == MADT_LOCAL_APIC) {
+            madt_lapic_t* lapic = (madt_lapic_t*)entry;
+            if ((lapic->flags & MADT_LAPIC_ENABLED) && madt_info.cpu_count < MAX_CPUS) {
+                madt_info.cpu_apic_ids[madt_info.cpu_count++] = lapic->apic_id;
+            }
+        } else if (entry->type == MADT_IO_APIC && !madt_info.ioapic_address) {
+            madt_ioapic_t* ioapic = (madt_ioapic_t*)entry;
+            madt_info.ioapic_address = ioapic->address;
+            madt_info.ioapic_id = ioapic->ioapic_id;
+            madt_info.ioapic_gsi_base = ioapic->gsi_base;
+        } else if (entry->type == MADT_INT_OVERRIDE) {
+            madt_override_t* override = (madt_override_t*)entry;
+            if (override->bus == 0 && override->source < ISA_IRQS) {
+                madt_info.isa_gsi[override->source] = override->gsi;
+                madt_info.isa_flags[override->source] = override->flags;
+            }
+        }
+        ptr += entry->length;
+    }
+}
+
+/**
+ * البحث عن RSDP وقراءة MADT
+ */
+void init_acpi(void) {
+    acpi_rsdp_t* rsdp = acpi_find_rsdp();
+    acpi_sdt_header_t* madt;
+    
+    if (!rsdp) {
+        print_string("[ACPI] RSDP not found\n");
+        return;
+    }
+    
+    madt = acpi_find_table(rsdp, "APIC");
+    if (!madt) {
+        print_string("[ACPI] MADT not found\n");
+        return;
+    }
+    
+    acpi_parse_madt((acpi_madt_t*)madt);
+    madt_found = true;
+    
+    print_string("[ACPI] MADT: ");
+    print_number(madt_info.cpu_count);
+    print_string(" CPUs, LAPIC ");
+    print_hex(madt_info.lapic_address);
+    if (madt_info.ioapic_address) {
+        print_string(", IOAPIC ");
+        print_hex(madt_info.ioapic_address);
+    }
+    print_string("\n");
+}
+
+const madt_info_t* acpi_get_madt(void) {
+    return madt_found ? &madt_info : NULL;
+}
@@ -0,0 +1,102 @@
+#ifndef ACPI_H
+#define ACPI_H
+
+#include "kernel.h"
+
+// البحث عن RSDP: أول 1KB من EBDA ثم منطقة BIOS
+#define ACPI_EBDA_SEGMENT_PTR 0x40E     // مقطع EBDA في منطقة بيانات BIOS
+#define ACPI_EBDA_SEARCH_SIZE 1024
+#define ACPI_BIOS_START 0xE0000
+#define ACPI_BIOS_END 0x100000
+#define ACPI_RSDP_ALIGN 16
+
+// أنواع مدخلات MADT
+#define MADT_LOCAL_APIC 0
+#define MADT_IO_APIC 1
+#define MADT_INT_OVERRIDE 2
+#define MADT_LAPIC_ENABLED 0x1          // المعالج قابل للاستخدام
+
+// أعلام تجاوز المقاطعة (MPS INTI flags)
+#define MADT_POLARITY_MASK 0x3
+#define MADT_POLARITY_LOW 0x3
+#define MADT_TRIGGER_MASK 0xC
+#define MADT_TRIGGER_LEVEL 0xC
+
+#define ISA_IRQS 16
+
+// Root System Description Pointer (ACPI 1.0)
+typedef struct {
+    char signature[8];          // "RSD PTR "
+    uint8_t checksum;
+    char oem_id[6];
+    uint8_t revision;
+    uint32_t rsdt_address;
+} __attribute__((packed)) acpi_rsdp_t;
+
+// رأس كل جداول ACPI
+typedef struct {
+    char signature[4];
+    uint32_t length;            // طول الجدول مع الرأس
+    uint8_t revision;
+    uint8_t checksum;
+    char oem_id[6];
+    char oem_table_id[8];
+    uint32_t oem_revision;
+    uint32_t creator_id;
+    uint32_t creator_revision;
+} __attribute__((packed)) acpi_sdt_header_t;
+
+// Multiple APIC Description Table ("APIC")، تتبعه مدخلات متغيرة الطول
+typedef struct {
+    acpi_sdt_header_t header;
+    uint32_t lapic_address;
+    uint32_t flags;
+} __attribute__((packed)) acpi_madt_t;
+
+typedef struct {
+    uint8_t type;
+    uint8_t length;
+} __attribute__((packed)) madt_entry_t;
+
+typedef struct {
+    madt_entry_t entry;
+    uint8_t processor_id;
+    uint8_t apic_id;
+    uint32_t flags;
+} __attribute__((packed)) madt_lapic_t;
+
+typedef struct {
+    madt_entry_t entry;
+    uint8_t ioapic_id;
+    uint8_t reserved;
+    uint32_t address;
+    uint32_t gsi_base;
+} __attribute__((packed)) madt_ioapic_t;
+
+typedef struct {
+    madt_entry_t entry;
+    uint8_t bus;
+    uint8_t source;             // IRQ ISA
+    uint32_t gsi;
+    uint16_t flags;
+} __attribute__((packed)) madt_override_t;
+
+// ما تحتاجه النواة من MADT (الجداول قد تكون خارج الذاكرة المربوطة بعد الترقيم)
+typedef struct {
+    uint32_t lapic_address;
+    uint32_t cpu_count;
+    uint8_t cpu_apic_ids[MAX_CPUS];
+    uint32_t ioapic_address;            // 0 = لا يوجد IOAPIC
+    uint8_t ioapic_id;
+    uint32_t ioapic_gsi_base;
+    uint32_t isa_gsi[ISA_IRQS];         // IRQ ISA -> GSI بعد التجاوزات
+    uint16_t isa_flags[ISA_IRQS];       // القطبية ونوع الإطلاق
+} madt_info_t;
+
+// قراءة جداول ACPI - قبل init_paging لأنها تقرأ الذاكرة الفيزيائية مباشرة
+void init_acpi(void);
+
+// معلومات MADT أو NULL إذا لم يوجد الجدول
+const madt_info_t* acpi_get_madt(void);
+
+#endif // ACPI_H
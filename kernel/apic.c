@@ -0,0 +1,305 @@
+#include "apic.h"
+#include "acpi.h"
+#include "cpu.h"
+#include "clock.h"
+#include "paging.h"
+#include "scheduler.h"
+#include "smp.h"
+
+volatile uint32_t* lapic_base = NULL;
+static volatile uint32_t* ioapic_base = NULL;
+static bool apic_active = false;
+
+// مؤقت LAPIC: موعد TSC إن توفر، وإلا عداد LAPIC المعاير
+// المعايرة مشتركة، ووضع كل مؤقت ومواعيده في cpu_t (smp.h)
+static bool tsc_deadline = false;
+static uint32_t tsc_per_tick = 0;           // دورات TSC لكل tick
+static uint32_t lapic_per_tick = 0;         // عدات LAPIC (قسمة 16) لكل tick
+
+static inline uint32_t lapic_read(uint32_t reg) {
+    return lapic_base[reg / 4];
+}
+
+static inline void lapic_write(uint32_t reg, uint32_t value) {
+    lapic_base[reg / 4] = value;
+}
+
+static uint32_t ioapic_read(uint32_t reg) {
+    ioapic_base[IOAPIC_REGSEL / 4] = reg;
+    return ioapic_base[IOAPIC_WINDOW / 4];
+}
+
+static void ioapic_write(uint32_t reg, uint32_t value) {
+    ioapic_base[IOAPIC_REGSEL / 4] = reg;
+    ioapic_base[IOAPIC_WINDOW / 4] = value;
+}
+
+// عدد مدخلات إعادة التوجيه في IOAPIC
+static uint32_t ioapic_pins(void) {
+    return ((ioapic_read(IOAPIC_VERSION) >> 16) & 0xFF) + 1;
+}
+
+// قياس سرعة عداد LAPIC مقابل TSC المعاير (لا حاجة له مع TSC-deadline)
+static uint32_t lapic_timer_calibrate(void) {
+    uint64_t wait = (uint64_t)get_tsc_khz() * LAPIC_CALIBRATE_MS;
+    uint64_t start;
+    uint32_t elapsed;
+    
+    lapic_write(LAPIC_TIMER_DIVIDE, LAPIC_TIMER_DIV16);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_TIMER_INITIAL, 0xFFFFFFFF);
+    
+    start = rdtsc();
+    while (rdtsc() - start < wait);
+    
+    elapsed = 0xFFFFFFFF - lapic_read(LAPIC_TIMER_CURRENT);
+    lapic_write(LAPIC_TIMER_INITIAL, 0);
+    
+    return (uint32_t)div_u64((uint64_t)elapsed * (1000 / HZ), LAPIC_CALIBRATE_MS);
+}
+
+// تفعيل LAPIC لهذا المعالج: المتجه الزائف، وإخفاء LINT0 (مقاطعات 8259)
+static void lapic_enable(void) {
+    wrmsr(MSR_APIC_BASE, rdmsr(MSR_APIC_BASE) | MSR_APIC_BASE_ENABLE);
+    
+    lapic_write(LAPIC_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS_VECTOR);
+    lapic_write(LAPIC_LVT_LINT0, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_LVT_LINT1, LAPIC_LVT_NMI);
+    lapic_write(LAPIC_LVT_ERROR, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_LVT_MASKED);
+    
+    // ESR يُصفر بكتابتين متتاليتين، ثم قبول كل الأولويات
+    lapic_write(LAPIC_ESR, 0);
+    lapic_write(LAPIC_ESR, 0);
+    lapic_write(LAPIC_TPR, 0);
+    lapic_write(LAPIC_EOI, 0);
+}
+
+/**
+ * الانتقال من 8259 إلى LAPIC و IOAPIC
+ * المتطلبات: MADT فيه IOAPIC، و APIC و MSR في CPUID، و TSC معاير
+ * (المعايرة والنبضة الديناميكية تقيسان الزمن به)
+ */
+void init_apic(void) {
+    const madt_info_t* madt = acpi_get_madt();
+    uint32_t flags;
+    
+    if (!madt || !madt->ioapic_address ||
+        !cpu_has(features_edx, CPUID_EDX_APIC) || !cpu_has(features_edx, CPUID_EDX_MSR) ||
+        !get_tsc_khz()) {
+        print_string("[APIC] Not available, using 8259 PIC\n");
+        return;
+    }
+    
+    if (!map_mmio(madt->lapic_address, LAPIC_MMIO_SIZE) ||
+        !map_mmio(madt->ioapic_address, IOAPIC_MMIO_SIZE)) {
+        print_string("[APIC] Registers outside the device window, using 8259 PIC\n");
+        return;
+    }
+    
+    flags = irq_save();
+    
+    lapic_base = (volatile uint32_t*)madt->lapic_address;
+    ioapic_base = (volatile uint32_t*)madt->ioapic_address;
+    
+    // المعايرة قبل إخفاء 8259 حتى يبقى صالحاً إذا فشلت
+    tsc_per_tick = get_tsc_khz() * (1000 / HZ);
+    tsc_deadline = cpu_has(features_ecx, CPUID_ECX_TSC_DEADLINE);
+    if (!tsc_deadline) {
+        wrmsr(MSR_APIC_BASE, rdmsr(MSR_APIC_BASE) | MSR_APIC_BASE_ENABLE);
+        lapic_per_tick = lapic_timer_calibrate();
+        if (!lapic_per_tick) {
+            lapic_base = NULL;
+            irq_restore(flags);
+            print_string("[APIC] LAPIC timer not counting, using 8259 PIC\n");
+            return;
+        }
+    }
+    
+    set_idt_entry(LAPIC_SPURIOUS_VECTOR, (uintptr_t)apic_spurious, 0x08, INTERRUPT_GATE);
+    disable_pic();
+    lapic_enable();
+    
+    // كل المداخل مخفية حتى يُوجه IRQ له معالج
+    for (uint32_t pin = 0; pin < ioapic_pins(); pin++) {
+        ioapic_write(IOAPIC_REDIR_TABLE + pin * 2, IOAPIC_REDIR_MASKED);
+        ioapic_write(IOAPIC_REDIR_TABLE + pin * 2 + 1, 0);
+    }
+    ioapic_route_irq(ISA_IRQ_KEYBOARD, IRQ_KEYBOARD);
+    
+    // IRQ0 من PIT يبقى مخفياً: الـ tick من مؤقت LAPIC
+    if (tsc_deadline) {
+        lapic_write(LAPIC_LVT_TIMER, LAPIC_TIMER_TSC_DEADLINE | LAPIC_TIMER_VECTOR);
+    }
+    
+    apic_active = true;
+    irq_restore(flags);
+    
+    print_apic_info();
+}
+
+bool apic_enabled(void) {
+    return apic_active;
+}
+
+/**
+ * رقم LAPIC للمعالج الحالي
+ */
+uint32_t lapic_id(void) {
+    return lapic_base ? lapic_read(LAPIC_ID) >> 24 : 0;
+}
+
+/**
+ * توجيه IRQ ISA إلى متجه على المعالج الحالي، مع تجاوزات MADT
+ * (GSI مختلف أو قطبية ونوع إطلاق غير الافتراضي)
+ */
+void ioapic_route_irq(uint32_t irq, uint8_t vector) {
+    const madt_info_t* madt = acpi_get_madt();
+    uint32_t pin = madt->isa_gsi[irq] - madt->ioapic_gsi_base;
+    uint16_t flags = madt->isa_flags[irq];
+    uint32_t low = vector;
+    
+    if ((flags & MADT_POLARITY_MASK) == MADT_POLARITY_LOW) {
+        low |= IOAPIC_REDIR_ACTIVE_LOW;
+    }
+    if ((flags & MADT_TRIGGER_MASK) == MADT_TRIGGER_LEVEL) {
+        low |= IOAPIC_REDIR_LEVEL;
+    }
+    
+    ioapic_write(IOAPIC_REDIR_TABLE + pin * 2 + 1, lapic_id() << 24);
+    ioapic_write(IOAPIC_REDIR_TABLE + pin * 2, low);
+}
+
+/**
+ * تفعيل LAPIC على معالج إضافي بنفس وضع مؤقت BSP
+ * (التقسيم يُضبط هنا لأن المعايرة جرت على BSP فقط)
+ */
+void lapic_init_ap(void) {
+    lapic_enable();
+    lapic_write(LAPIC_TIMER_DIVIDE, LAPIC_TIMER_DIV16);
+    if (tsc_deadline) {
+        lapic_write(LAPIC_LVT_TIMER, LAPIC_TIMER_TSC_DEADLINE | LAPIC_TIMER_VECTOR);
+    }
+}
+
+/**
+ * إرسال IPI وانتظار تسليمه
+ * ICR سجلان: المقاطعات معطلة حتى لا يكتب معالج مقاطعة بينهما
+ */
+void lapic_send_ipi(uint8_t apic_id, uint32_t command) {
+    uint32_t flags = irq_save();
+    
+    lapic_write(LAPIC_ICR_HIGH, (uint32_t)apic_id << 24);
+    lapic_write(LAPIC_ICR_LOW, command);
+    while (lapic_read(LAPIC_ICR_LOW) & LAPIC_ICR_PENDING) {
+        asm volatile("pause");
+    }
+    
+    irq_restore(flags);
+}
+
+/**
+ * tick دوري بـ HZ
+ * مع TSC-deadline لا يوجد وضع دوري: يُسلح الموعد التالي في كل مقاطعة
+ */
+void lapic_timer_periodic(void) {
+    cpu_t* cpu = this_cpu();
+    
+    cpu->timer_periodic = true;
+    
+    if (tsc_deadline) {
+        cpu->timer_deadline = rdtsc() + tsc_per_tick;
+        wrmsr(MSR_TSC_DEADLINE, cpu->timer_deadline);
+        return;
+    }
+    
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_TIMER_PERIODIC | LAPIC_TIMER_VECTOR);
+    lapic_write(LAPIC_TIMER_INITIAL, lapic_per_tick);
+}
+
+/**
+ * مقاطعة واحدة بعد ticks (ينهي الوضع الدوري)
+ */
+void lapic_timer_oneshot(uint32_t ticks) {
+    cpu_t* cpu = this_cpu();
+    
+    cpu->timer_periodic = false;
+    cpu->timer_armed = rdtsc();
+    
+    if (tsc_deadline) {
+        wrmsr(MSR_TSC_DEADLINE, cpu->timer_armed + (uint64_t)ticks * tsc_per_tick);
+        return;
+    }
+    
+    cpu->oneshot_count = ticks * lapic_per_tick;
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_TIMER_VECTOR);
+    lapic_write(LAPIC_TIMER_INITIAL, cpu->oneshot_count);
+}
+
+/**
+ * عدد الـ ticks الكاملة منذ برمجة one-shot
+ */
+uint32_t lapic_timer_elapsed(void) {
+    cpu_t* cpu = this_cpu();
+    
+    if (tsc_deadline) {
+        return (uint32_t)div_u64(rdtsc() - cpu->timer_armed, tsc_per_tick);
+    }
+    return (cpu->oneshot_count - lapic_read(LAPIC_TIMER_CURRENT)) / lapic_per_tick;
+}
+
+/**
+ * أطول one-shot: العداد 32 بت يحدد المدى بدون TSC-deadline
+ */
+uint32_t lapic_timer_max_ticks(void) {
+    if (!tsc_deadline && 0xFFFFFFFF / lapic_per_tick < LAPIC_TIMER_MAX_TICKS) {
+        return 0xFFFFFFFF / lapic_per_tick;
+    }
+    return LAPIC_TIMER_MAX_TICKS;
+}
+
+/**
+ * من مقاطعة المؤقت: الموعد التالي بعد السابق بـ tick بالضبط فلا ينجرف
+ * وإذا فاتت ticks (مقاطعات معطلة طويلاً) يُحسب من الآن
+ */
+void lapic_timer_tick(void) {
+    cpu_t* cpu = this_cpu();
+    uint64_t now;
+    
+    if (!apic_active || !tsc_deadline || !cpu->timer_periodic) {
+        return;
+    }
+    
+    now = rdtsc();
+    cpu->timer_deadline += tsc_per_tick;
+    if (cpu->timer_deadline <= now) {
+        cpu->timer_deadline = now + tsc_per_tick;
+    }
+    wrmsr(MSR_TSC_DEADLINE, cpu->timer_deadline);
+}
+
+/**
+ * طباعة وحدة التحكم بالمقاطعات ومصدر الـ tick
+ */
+void print_apic_info(void) {
+    if (!apic_active) {
+        print_string("[APIC] Disabled, 8259 PIC + PIT\n");
+        return;
+    }
+    
+    print_string("[APIC] LAPIC ");
+    print_number(lapic_id());
+    print_string(" version ");
+    print_hex(lapic_read(LAPIC_VERSION) & 0xFF);
+    print_string(", IOAPIC ");
+    print_number(acpi_get_madt()->ioapic_id);
+    print_string(" (");
+    print_number(ioapic_pins());
+    print_string(" pins), timer ");
+    if (tsc_deadline) {
+        print_string("TSC-deadline\n");
+    } else {
+        print_number(lapic_per_tick);
+        print_string(" counts/tick\n");
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef APIC_H
+#define APIC_H
+
+#include "kernel.h"
+#include "interrupt.h"
+
+// سجلات Local APIC (إزاحات MMIO من عنوان MADT)
+#define LAPIC_ID 0x020
+#define LAPIC_VERSION 0x030
+#define LAPIC_TPR 0x080
+#define LAPIC_EOI 0x0B0
+#define LAPIC_SVR 0x0F0
+#define LAPIC_ESR 0x280
+#define LAPIC_ICR_LOW 0x300
+#define LAPIC_ICR_HIGH 0x310
+#define LAPIC_LVT_TIMER 0x320
+#define LAPIC_LVT_LINT0 0x350
+#define LAPIC_LVT_LINT1 0x360
+#define LAPIC_LVT_ERROR 0x370
+#define LAPIC_TIMER_INITIAL 0x380
+#define LAPIC_TIMER_CURRENT 0x390
+#define LAPIC_TIMER_DIVIDE 0x3E0
+#define LAPIC_MMIO_SIZE 0x400
+
+#define LAPIC_SVR_ENABLE 0x100
+#define LAPIC_LVT_MASKED 0x10000
+#define LAPIC_LVT_NMI 0x400
+#define LAPIC_TIMER_PERIODIC 0x20000
+#define LAPIC_TIMER_TSC_DEADLINE 0x40000
+#define LAPIC_TIMER_DIV16 0x3
+
+// ICR: نوع الرسالة وحالتها
+#define LAPIC_ICR_FIXED 0x000
+#define LAPIC_ICR_INIT 0x500
+#define LAPIC_ICR_STARTUP 0x600         // المتجه = صفحة بداية التنفيذ تحت 1MB
+#define LAPIC_ICR_PENDING 0x1000        // لم تُسلم بعد
+#define LAPIC_ICR_ASSERT 0x4000
+#define LAPIC_ICR_LEVEL 0x8000
+
+// IOAPIC: سجل اختيار ونافذة بيانات
+#define IOAPIC_REGSEL 0x00
+#define IOAPIC_WINDOW 0x10
+#define IOAPIC_MMIO_SIZE 0x20
+#define IOAPIC_VERSION 0x01
+#define IOAPIC_REDIR_TABLE 0x10         // مدخلان 32 بت لكل GSI
+#define IOAPIC_REDIR_MASKED 0x10000
+#define IOAPIC_REDIR_LEVEL 0x8000
+#define IOAPIC_REDIR_ACTIVE_LOW 0x2000
+
+// المتجهات: مؤقت LAPIC يأخذ متجه IRQ0 فيبقى timer_handler كما هو
+#define LAPIC_TIMER_VECTOR IRQ_TIMER
+#define LAPIC_SPURIOUS_VECTOR 0xFF
+#define ISA_IRQ_KEYBOARD 1
+
+#define LAPIC_CALIBRATE_MS 10
+#define LAPIC_TIMER_MAX_TICKS HZ        // أطول نوم one-shot (النقطة كل ثانية توقظ قبله أصلاً)
+
+// معالج المتجه الزائف في interrupt_asm.s (بلا EOI)
+extern void apic_spurious();
+
+// سجلات LAPIC المربوطة (NULL ما دام PIC مستخدماً)
+extern volatile uint32_t* lapic_base;
+
+// تهيئة LAPIC و IOAPIC بدل 8259 - بعد init_paging (ربط MMIO)
+// يبقى PIC إذا لم يوجد MADT أو APIC أو TSC معاير
+void init_apic(void);
+bool apic_enabled(void);
+uint32_t lapic_id(void);
+void ioapic_route_irq(uint32_t irq, uint8_t vector);
+
+// تفعيل LAPIC ومؤقته على معالج إضافي (بعد init_apic على BSP)
+void lapic_init_ap(void);
+void lapic_send_ipi(uint8_t apic_id, uint32_t command);
+
+// EOI بكتابة MMIO واحدة بدل منفذ أو اثنين
+static inline void lapic_eoi(void) {
+    lapic_base[LAPIC_EOI / 4] = 0;
+}
+
+// مؤقت LAPIC: دوري بـ HZ، أو one-shot للنبضة الديناميكية (حالته لكل معالج)
+void lapic_timer_periodic(void);
+void lapic_timer_oneshot(uint32_t ticks);
+uint32_t lapic_timer_elapsed(void);     // ticks كاملة منذ برمجة one-shot
+uint32_t lapic_timer_max_ticks(void);
+void lapic_timer_tick(void);            // إعادة تسليح موعد TSC الدوري
+void print_apic_info(void);
+
+#endif // APIC_H
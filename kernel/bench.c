@@ -0,0 +1,1069 @@
+#include "bench.h"
+#include "kernel.h"
+#include "memory.h"
+#include "cpu.h"
+#include "task.h"
+#include "paging.h"
+#include "syscall.h"
+#include "interrupt.h"
+#include "scheduler.h"
+#include "timer.h"
+#include "clock.h"
+#include "apic.h"
+#include "smp.h"
+
+/**
+ * تشغيل جميع اختبارات الأداء
+ */
+void run_benchmarks(void) {
+    print_string("\n=== Benchmarks ===\n");
+    bench_frame_allocator();
+    bench_buddy_allocator();
+    bench_kfree_latency();
+    bench_mem_routines();
+    bench_fork();
+    bench_page_coloring();
+    bench_context_switch();
+    bench_scheduler();
+    bench_task_table();
+    bench_fairness();
+    bench_tickless();
+    bench_timers();
+    bench_clock();
+    bench_eoi();
+}
+
+/**
+ * طباعة نتيجة قياس بالدورات لكل عملية
+ */
+void bench_report(const char* label, uint64_t cycles, uint32_t ops) {
+    print_string("  ");
+    print_string(label);
+    print_string(": ");
+    print_number((uint32_t)div_u64(cycles, ops ? ops : 1));
+    print_string(" cycles/op");
+    if (get_tsc_khz()) {
+        print_string(" (");
+        print_number((uint32_t)div_u64(cycles_to_ns(cycles), ops ? ops : 1));
+        print_string(" ns)");
+    }
+    print_string("\n");
+}
+
+/**
+ * قياس مخصص الإطارات على عدد معين من الإطارات
+ * يعمل على نسخة مستقلة حتى لا يلمس ذاكرة النظام الفعلية
+ */
+static void bench_frames(const char* title, uint32_t frame_count) {
+    uint32_t words = (frame_count + BITS_PER_WORD - 1) / BITS_PER_WORD;
+    uint32_t summary_words = (words + BITS_PER_WORD - 1) / BITS_PER_WORD;
+    uint32_t* bitmap = (uint32_t*)kmalloc(words * sizeof(uint32_t));
+    uint32_t* summary = (uint32_t*)kmalloc(summary_words * sizeof(uint32_t));
+    frame_allocator_t fa;
+    volatile uint32_t sink = 0;
+    uint64_t start;
+    uint32_t i;
+    
+    print_string("[BENCH] frame allocator, ");
+    print_string(title);
+    print_string("\n");
+    
+    if (!bitmap || !summary) {
+        print_string("  not enough memory\n");
+        kfree(bitmap);
+        kfree(summary);
+        return;
+    }
+    
+    frame_allocator_init(&fa, bitmap, summary, frame_count);
+    
+    // تخصيص كل الإطارات
+    start = rdtsc();
+    for (i = 0; i < frame_count; i++) {
+        sink += frame_alloc(&fa);
+    }
+    bench_report("alloc", rdtsc() - start, frame_count);
+    
+    // البحث: عنوان -> PFN -> حالة الإطار
+    start = rdtsc();
+    for (i = 0; i < frame_count; i++) {
+        sink += frame_is_free(&fa, ADDR_TO_PFN(PFN_TO_ADDR(i)));
+    }
+    bench_report("lookup", rdtsc() - start, frame_count);
+    
+    // التحرير من أعلى الذاكرة (أسوأ حالة للبحث الخطي)
+    start = rdtsc();
+    for (i = frame_count; i-- > 0; ) {
+        frame_free(&fa, i);
+    }
+    bench_report("free", rdtsc() - start, frame_count);
+    
+    // تحرير وتخصيص آخر إطار والذاكرة ممتلئة
+    for (i = 0; i < frame_count; i++) {
+        frame_alloc(&fa);
+    }
+    start = rdtsc();
+    for (i = 0; i < 1000; i++) {
+        frame_free(&fa, frame_count - 1);
+        sink += frame_alloc(&fa);
+    }
+    bench_report("free+alloc (top frame)", rdtsc() - start, 1000);
+    
+    kfree(bitmap);
+    kfree(summary);
+}
+
+/**
+ * قياس مخصص الإطارات بالحجم الحالي (16MB) وبحجم 1GB
+ */
+void bench_frame_allocator(void) {
+    bench_frames("16MB", 0x1000000 / PAGE_SIZE);
+    bench_frames("1GB", 0x40000000 / PAGE_SIZE);
+}
+
+/**
+ * قياس alloc_pages/free_pages لعدة رتب على المخصص الفعلي
+ * التحرير بترتيب عكسي يجبر على سلسلة دمج كاملة في كل مرة
+ */
+void bench_buddy_allocator(void) {
+    static void* blocks[64];
+    static const uint32_t orders[] = { 0, 2, 4, 6 };
+    uint64_t alloc_cycles, free_cycles, start;
+    uint32_t i, o, count;
+    memory_stats_t* stats;
+    
+    print_string("[BENCH] buddy allocator\n");
+    
+    for (o = 0; o < sizeof(orders) / sizeof(orders[0]); o++) {
+        count = 0;
+        
+        start = rdtsc();
+        for (i = 0; i < 64; i++) {
+            blocks[i] = alloc_pages(orders[o]);
+            if (blocks[i]) {
+                count++;
+            }
+        }
+        alloc_cycles = rdtsc() - start;
+        
+        start = rdtsc();
+        for (i = 64; i-- > 0; ) {
+            free_pages(blocks[i], orders[o]);
+        }
+        free_cycles = rdtsc() - start;
+        
+        print_string("  order ");
+        print_number(orders[o]);
+        print_string("\n");
+        bench_report("alloc_pages", alloc_cycles, count);
+        bench_report("free_pages", free_cycles, count);
+    }
+    
+    stats = get_memory_stats();
+    print_string("  fragmentation per order (%):");
+    for (o = 0; o < BUDDY_MAX_ORDER; o++) {
+        print_string(" ");
+        print_number(stats->order_fragmentation[o]);
+    }
+    print_string("\n");
+}
+
+/**
+ * قياس زمن kfree للكتل الكبيرة مع ازدياد عدد الكائنات الحية
+ * مع boundary tags يجب أن يبقى الزمن ثابتاً مهما زاد العدد
+ */
+void bench_kfree_latency(void) {
+    static void* blocks[1024];
+    static const uint32_t live_counts[] = { 16, 64, 256, 1024 };
+    uint64_t cycles;
+    uint64_t start;
+    uint32_t c, i, n, step, timed;
+    
+    print_string("[BENCH] kfree latency vs live objects (2100 B blocks)\n");
+    
+    for (c = 0; c < sizeof(live_counts) / sizeof(live_counts[0]); c++) {
+        n = live_counts[c];
+        for (i = 0; i < n; i++) {
+            blocks[i] = kmalloc(2100);
+        }
+        
+        // تحرير 16 كتلة موزعة على كامل المجموعة
+        step = n / 16;
+        timed = 0;
+        cycles = 0;
+        for (i = 0; i < n; i += step) {
+            if (!blocks[i]) {
+                continue;
+            }
+            start = rdtsc();
+            kfree(blocks[i]);
+            cycles += rdtsc() - start;
+            blocks[i] = 0;
+            timed++;
+        }
+        
+        print_string("  live ");
+        print_number(n);
+        print_string("\n");
+        bench_report("kfree", cycles, timed);
+        
+        for (i = 0; i < n; i++) {
+            kfree(blocks[i]);
+        }
+    }
+}
+
+typedef void* (*bench_copy_fn)(void*, const void*, uint32_t);
+typedef void* (*bench_fill_fn)(void*, int, uint32_t);
+typedef int (*bench_cmp_fn)(const void*, const void*, uint32_t);
+
+/**
+ * تكرار دالة نسخ على حجم معين وطباعة الدورات لكل استدعاء
+ */
+static void bench_copy(const char* label, bench_copy_fn fn, void* dst, const void* src, uint32_t size, uint32_t iterations) {
+    uint64_t start = rdtsc();
+    uint32_t i;
+    
+    for (i = 0; i < iterations; i++) {
+        fn(dst, src, size);
+    }
+    bench_report(label, rdtsc() - start, iterations);
+}
+
+static void bench_fill(const char* label, bench_fill_fn fn, void* dst, uint32_t size, uint32_t iterations) {
+    uint64_t start = rdtsc();
+    uint32_t i;
+    
+    for (i = 0; i < iterations; i++) {
+        fn(dst, (int)i, size);
+    }
+    bench_report(label, rdtsc() - start, iterations);
+}
+
+static void bench_cmp(const char* label, bench_cmp_fn fn, const void* a, const void* b, uint32_t size, uint32_t iterations) {
+    volatile int sink = 0;
+    uint64_t start = rdtsc();
+    uint32_t i;
+    
+    for (i = 0; i < iterations; i++) {
+        sink += fn(a, b, size);
+    }
+    bench_report(label, rdtsc() - start, iterations);
+}
+
+/**
+ * مقارنة تطبيقات memcpy/memset/memcmp (بايت، rep، SSE2) من 16B إلى 1MB
+ * المخازن من alloc_pages(8) حتى تتسع لأكبر حجم
+ */
+void bench_mem_routines(void) {
+    static const uint32_t sizes[] = { 16, 256, 4096, 65536, 0x100000 };
+    uint8_t* src = (uint8_t*)alloc_pages(8);
+    uint8_t* dst = (uint8_t*)alloc_pages(8);
+    uint32_t s, size, iterations;
+    
+    print_string("[BENCH] memory routines (cycles per call)\n");
+    
+    if (!src || !dst) {
+        print_string("  not enough memory\n");
+        free_pages(src, 8);
+        free_pages(dst, 8);
+        return;
+    }
+    
+    memset_rep(src, 0x5A, 0x100000);
+    memset_rep(dst, 0x5A, 0x100000);
+    
+    for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size = sizes[s];
+        // عدد تكرارات أقل للأحجام الكبيرة حتى لا يطول الاختبار
+        iterations = size >= 65536 ? 16 : 1024;
+        
+        print_string("  size ");
+        print_number(size);
+        print_string("\n");
+        
+        bench_copy("memcpy bytes", memcpy_bytes, dst, src, size, iterations);
+        bench_copy("memcpy rep", memcpy_rep, dst, src, size, iterations);
+        if (cpu_info.sse_enabled) {
+            bench_copy("memcpy sse2", memcpy_sse2, dst, src, size, iterations);
+        }
+        
+        bench_fill("memset bytes", memset_bytes, dst, size, iterations);
+        bench_fill("memset rep", memset_rep, dst, size, iterations);
+        if (cpu_info.sse_enabled) {
+            bench_fill("memset sse2", memset_sse2, dst, size, iterations);
+        }
+        
+        // مخازن متساوية: أسوأ حالة تقرأ الحجم كاملاً
+        memcpy(dst, src, size);
+        bench_cmp("memcmp bytes", memcmp_bytes, dst, src, size, iterations);
+        bench_cmp("memcmp words", memcmp_words, dst, src, size, iterations);
+    }
+    
+    free_pages(src, 8);
+    free_pages(dst, 8);
+}
+
+// الابن يُحصد قبل أن يعمل (المقاطعات معطلة طوال القياس)
+static void bench_fork_child(void) {
+}
+
+/**
+ * قياس fork+exit مقابل حجم ذاكرة المهمة
+ * مع COW يجب أن يتناسب الزمن مع عدد الجداول لا مع عدد البايتات
+ * المقاطعات معطلة حتى لا يغير المؤقت المهمة الحالية أثناء القياس
+ */
+void bench_fork(void) {
+    static const uint32_t sizes_kb[] = { 0, 64, 1024, 4096 };
+    syscall_params_t params;
+    task_t* parent = current_task;
+    task_t* child;
+    uint64_t fork_cycles, cow_cycles, start;
+    uint32_t flags, s, i, size, forks, copies;
+    bool cow_measured;
+    
+    print_string("[BENCH] fork+exit vs task memory\n");
+    
+    if (!parent) {
+        return;
+    }
+    
+    flags = irq_save();
+    
+    for (s = 0; s < sizeof(sizes_kb) / sizeof(sizes_kb[0]); s++) {
+        size = sizes_kb[s] * 1024;
+        
+        // حجز الكومة ولمسها كلها حتى تُربط صفحاتها
+        params.ebx = parent->brk_start + size;
+        sys_brk(&params);
+        if (parent->brk != parent->brk_start + size) {
+            print_string("  brk failed\n");
+            break;
+        }
+        memset((void*)parent->brk_start, 0xA5, size);
+        
+        fork_cycles = 0;
+        cow_cycles = 0;
+        forks = 0;
+        for (i = 0; i < 16; i++) {
+            start = rdtsc();
+            child = fork_task((void*)bench_fork_child);
+            if (!child) {
+                break;
+            }
+            reap_task(child);
+            fork_cycles += rdtsc() - start;
+            forks++;
+        }
+        
+        // كتابة بعد fork والطفل حي: نسخ صفحة كاملة
+        child = size ? fork_task((void*)bench_fork_child) : 0;
+        cow_measured = child != 0;
+        if (child) {
+            copies = get_paging_stats()->cow_copies;
+            start = rdtsc();
+            *(volatile uint32_t*)parent->brk_start = i;
+            cow_cycles = rdtsc() - start;
+            // بدون CR0.WP تمر الكتابة بلا خطأ ويقيس الرقم كتابة عادية
+            cow_measured = get_paging_stats()->cow_copies != copies;
+            reap_task(child);
+        }
+        
+        print_string("  heap ");
+        print_number(sizes_kb[s]);
+        print_string(" KB\n");
+        bench_report("fork+exit", fork_cycles, forks);
+        if (cow_measured) {
+            bench_report("first write (cow copy)", cow_cycles, 1);
+        } else if (child) {
+            print_string("  first write: no cow copy\n");
+        }
+        
+        params.ebx = parent->brk_start;
+        sys_brk(&params);
+    }
+    
+    irq_restore(flags);
+}
+
+#define COLOR_BENCH_MAX_PAGES 512   // حتى L2 بحجم 2MB
+#define COLOR_BENCH_POOL (COLOR_BENCH_MAX_PAGES * 2)
+#define COLOR_BENCH_PASSES 8
+
+// هل يمكن قراءة عداد LLC misses؟ (الحدث المعماري موجود + MSR)
+static bool pmc_available(void) {
+    return cpu_info.perfmon_llc_misses && cpu_has(features_edx, CPUID_EDX_MSR);
+}
+
+/**
+ * المرور على صفحات مجموعة العمل عدة مرات، سطراً سطراً
+ * يطبع الدورات لكل سطر و LLC misses إن أمكن
+ */
+static void bench_touch_pages(const char* label, uint8_t** pages, uint32_t count, uint32_t line) {
+    volatile uint32_t sink = 0;
+    uint64_t start, cycles, misses = 0;
+    uint32_t pass, i, offset, lines;
+    bool pmc = pmc_available();
+    
+    // مرور أول لتسخين الكاش وال TLB
+    for (i = 0; i < count; i++) {
+        for (offset = 0; offset < PAGE_SIZE; offset += line) {
+            sink += pages[i][offset];
+        }
+    }
+    
+    if (pmc) {
+        wrmsr(MSR_PMC0, 0);
+        wrmsr(MSR_PERFEVTSEL0, PERFEVT_LLC_MISSES | PERFEVT_USR | PERFEVT_OS | PERFEVT_EN);
+    }
+    start = rdtsc();
+    for (pass = 0; pass < COLOR_BENCH_PASSES; pass++) {
+        for (i = 0; i < count; i++) {
+            for (offset = 0; offset < PAGE_SIZE; offset += line) {
+                sink += pages[i][offset];
+            }
+        }
+    }
+    cycles = rdtsc() - start;
+    if (pmc) {
+        misses = rdpmc(0);
+        wrmsr(MSR_PERFEVTSEL0, 0);
+    }
+    
+    lines = count * (PAGE_SIZE / line) * COLOR_BENCH_PASSES;
+    print_string("  ");
+    print_string(label);
+    print_string(": ");
+    print_number((uint32_t)div_u64(cycles, lines));
+    print_string(" cycles/line");
+    if (pmc) {
+        print_string(", LLC misses ");
+        print_number((uint32_t)misses);
+    }
+    print_string("\n");
+}
+
+/**
+ * مقارنة مجموعة عمل بحجم L2 بصفحات عشوائية الألوان مقابل صفحات ملونة
+ * الخط الأساسي يختار الصفحات عشوائياً من مجمع أكبر ليحاكي ذاكرة مجزأة
+ * ملاحظة: محاكي QEMU بدون KVM لا يحاكي الكاش، فالفرق يظهر على عتاد حقيقي فقط
+ */
+void bench_page_coloring(void) {
+    static uint8_t* pool[COLOR_BENCH_POOL];
+    static uint8_t* pages[COLOR_BENCH_MAX_PAGES];
+    uint32_t count, pooled, i, j, seed = 12345;
+    uint32_t line = cpu_info.l2_line ? cpu_info.l2_line : 64;
+    uint8_t* tmp;
+    
+    print_string("[BENCH] page coloring\n");
+    
+    if (cpu_info.cache_colors < 2) {
+        print_string("  L2 geometry unknown, skipped\n");
+        return;
+    }
+    
+    count = cpu_info.l2_size / PAGE_SIZE;
+    if (count > COLOR_BENCH_MAX_PAGES) {
+        count = COLOR_BENCH_MAX_PAGES;
+    }
+    
+    // الخط الأساسي: أول count صفحة بعد خلط المجمع
+    for (pooled = 0; pooled < count * 2; pooled++) {
+        pool[pooled] = alloc_page();
+        if (!pool[pooled]) {
+            break;
+        }
+    }
+    if (pooled < count) {
+        print_string("  not enough memory\n");
+    } else {
+        for (i = pooled - 1; i > 0; i--) {
+            seed = seed * 1103515245 + 12345;
+            j = (seed >> 16) % (i + 1);
+            tmp = pool[i];
+            pool[i] = pool[j];
+            pool[j] = tmp;
+        }
+        bench_touch_pages("random colors", pool, count, line);
+    }
+    for (i = 0; i < pooled; i++) {
+        free_page(pool[i]);
+    }
+    
+    // الصفحات الملونة: لون مختلف لكل صفحة بالتدوير
+    for (i = 0; i < count; i++) {
+        pages[i] = alloc_page_color(i);
+        if (!pages[i]) {
+            break;
+        }
+    }
+    if (i == count) {
+        bench_touch_pages("colored", pages, count, line);
+    } else {
+        print_string("  not enough memory\n");
+    }
+    while (i-- > 0) {
+        free_page(pages[i]);
+    }
+    
+    // إعادة صفحات قوائم الألوان إذا لم يكن التلوين مستخدماً
+    if (!page_coloring_enabled()) {
+        set_page_coloring(false);
+    }
+}
+
+#define PINGPONG_ROUNDS 10000
+
+static task_t* ping_task;
+static volatile bool pong_done;
+
+// الطرف الثاني: يعيد التبديل فوراً إلى المهمة التي بدلت إليه
+static void bench_pong(void) {
+    disable_interrupts();           // task_start فعّلها، والقياس بلا مؤقت
+    
+    while (!pong_done) {
+        switch_to_task(ping_task);
+    }
+    
+    // الانتهاء بدون جدولة حتى يعود التحكم إلى القياس مباشرة
+    current_task->state = TASK_ZOMBIE;
+    switch_to_task(ping_task);
+}
+
+/**
+ * ping-pong بين مهمتين عبر switch_to_task
+ * كل جولة تبديلان كاملان (مكدس + سجلات، بلا تحميل CR3 لأن الدليل مشترك)
+ */
+void bench_context_switch(void) {
+    task_t* pong;
+    uint64_t start, cycles;
+    uint32_t flags, i;
+    
+    print_string("[BENCH] context switch\n");
+    
+    ping_task = current_task;
+    pong_done = false;
+    pong = create_task("pong", (void*)bench_pong);
+    if (!pong) {
+        return;
+    }
+    
+    flags = irq_save();
+    switch_to_task(pong);           // تسخين: أول تشغيل يمر عبر task_start
+    
+    start = rdtsc();
+    for (i = 0; i < PINGPONG_ROUNDS; i++) {
+        switch_to_task(pong);
+    }
+    cycles = rdtsc() - start;
+    
+    pong_done = true;
+    switch_to_task(pong);
+    irq_restore(flags);
+    reap_task(pong);
+    
+    bench_report("switch", cycles, PINGPONG_ROUNDS * 2);
+}
+
+#define SCHED_BENCH_MAX_TASKS 1000
+#define SCHED_BENCH_PICKS 10000
+
+/**
+ * زمن اختيار المهمة التالية مقابل عدد المهام الجاهزة
+ * طابور خاص بمهام وهمية: كل اختيار = peek + إخراج + إعادة بشريحة منتهية
+ * (فتنتقل إلى المصفوفة المنتهية وتُبدل المصفوفتان كل دورة)
+ * للمقارنة: المسح الخطي للقائمة كما كان find_highest_priority_task يفعل
+ */
+void bench_scheduler(void) {
+    static const uint32_t counts[] = { 2, 10, 100, SCHED_BENCH_MAX_TASKS };
+    static runqueue_t rq;
+    task_t* tasks = (task_t*)kmalloc(SCHED_BENCH_MAX_TASKS * sizeof(task_t));
+    volatile uint32_t sink = 0;
+    uint64_t start, pick_cycles, scan_cycles;
+    uint32_t c, i, n, seed = 1;
+    task_t* task;
+    task_t* best;
+    
+    print_string("[BENCH] scheduler pick-next\n");
+    
+    if (!tasks) {
+        print_string("  not enough memory\n");
+        return;
+    }
+    
+    for (c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        n = counts[c];
+        
+        runqueue_init(&rq);
+        for (i = 0; i < n; i++) {
+            seed = seed * 1103515245 + 12345;
+            tasks[i].priority = MIN_PRIORITY + (seed >> 16) % PRIO_LEVELS;
+            tasks[i].time_slice = 1;
+            tasks[i].run_array = 0;
+            tasks[i].state = TASK_READY;
+            tasks[i].next = (i + 1 < n) ? &tasks[i + 1] : 0;
+            runqueue_enqueue(&rq, &tasks[i]);
+        }
+        
+        start = rdtsc();
+        for (i = 0; i < SCHED_BENCH_PICKS; i++) {
+            task = runqueue_peek(&rq);
+            runqueue_dequeue(&rq, task);
+            task->time_slice = 0;
+            runqueue_enqueue(&rq, task);
+        }
+        pick_cycles = rdtsc() - start;
+        
+        start = rdtsc();
+        for (i = 0; i < SCHED_BENCH_PICKS; i++) {
+            best = 0;
+            for (task = tasks; task; task = task->next) {
+                if (task->state == TASK_READY && (!best || task->priority < best->priority)) {
+                    best = task;
+                }
+            }
+            sink += best->priority;
+        }
+        scan_cycles = rdtsc() - start;
+        
+        print_string("  ");
+        print_number(n);
+        print_string(" tasks\n");
+        bench_report("bitmap pick", pick_cycles, SCHED_BENCH_PICKS);
+        bench_report("linear scan", scan_cycles, SCHED_BENCH_PICKS);
+    }
+    
+    kfree(tasks);
+}
+
+#define TASK_BENCH_MAX 1024
+#define TASK_BENCH_LOOKUPS 10000
+
+static void bench_idle_entry(void) {
+}
+
+/**
+ * إنشاء مهام حقيقية والبحث عنها وتحريرها مع ازدياد عددها
+ * مع bitmap المعرفات وجدول hash يجب أن تبقى التكلفة لكل عملية ثابتة
+ * المقاطعات معطلة فلا تعمل المهام المنشأة أبداً
+ */
+void bench_task_table(void) {
+    static const uint32_t counts[] = { 16, 128, TASK_BENCH_MAX };
+    static task_t* tasks[TASK_BENCH_MAX];
+    volatile uint32_t sink = 0;
+    uint64_t create_cycles, find_cycles, reap_cycles, start;
+    uint32_t flags, c, i, n, seed = 7;
+    
+    print_string("[BENCH] task table\n");
+    
+    flags = irq_save();
+    
+    for (c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        start = rdtsc();
+        for (n = 0; n < counts[c]; n++) {
+            tasks[n] = alloc_task("bench", (void*)bench_idle_entry);
+            if (!tasks[n]) {
+                break;
+            }
+        }
+        create_cycles = rdtsc() - start;
+        
+        start = rdtsc();
+        for (i = 0; n && i < TASK_BENCH_LOOKUPS; i++) {
+            seed = seed * 1103515245 + 12345;
+            sink += (uint32_t)find_task(tasks[(seed >> 16) % n]->pid);
+        }
+        find_cycles = rdtsc() - start;
+        
+        start = rdtsc();
+        for (i = 0; i < n; i++) {
+            reap_task(tasks[i]);
+        }
+        reap_cycles = rdtsc() - start;
+        
+        print_string("  ");
+        print_number(n);
+        print_string(" tasks\n");
+        bench_report("create", create_cycles, n);
+        bench_report("find_task", find_cycles, TASK_BENCH_LOOKUPS);
+        bench_report("reap", reap_cycles, n);
+        
+        if (n < counts[c]) {
+            print_string("  out of memory\n");
+            break;
+        }
+    }
+    
+    irq_restore(flags);
+}
+
+#define FAIR_BENCH_CPU_TASKS 3
+#define FAIR_BENCH_TICKS (2 * HZ)
+
+static volatile bool fair_done;
+static volatile uint32_t fair_bursts;
+
+// مهمة حسابية لا تتخلى عن المعالج أبداً
+static void bench_fair_cpu(void) {
+    while (!fair_done) {
+        for (volatile int i = 0; i < 1000; i++);
+    }
+}
+
+// مهمة تفاعلية: دفعة عمل قصيرة ثم تتخلى عن المعالج
+static void bench_fair_interactive(void) {
+    while (!fair_done) {
+        for (volatile int i = 0; i < 1000; i++);
+        fair_bursts++;
+        yield();
+    }
+}
+
+static void bench_fair_run(const char* label, sched_policy_t policy) {
+    task_t* tasks[FAIR_BENCH_CPU_TASKS + 1];
+    uint32_t ms[FAIR_BENCH_CPU_TASKS + 1];
+    uint32_t total = 0, max = 0, min = 0xFFFFFFFF;
+    uint32_t flags, i, n = 0;
+    bool running;
+    
+    set_scheduling_policy(policy);
+    fair_done = false;
+    fair_bursts = 0;
+    
+    // لا تعمل المهام قبل أن تنام المهمة الرئيسية (مؤقت النوم يوقظها)
+    flags = irq_save();
+    for (i = 0; i < FAIR_BENCH_CPU_TASKS; i++) {
+        tasks[n] = alloc_task("cpu", (void*)bench_fair_cpu);
+        if (tasks[n]) {
+            n++;
+        }
+    }
+    tasks[n] = alloc_task("interactive", (void*)bench_fair_interactive);
+    if (tasks[n]) {
+        n++;
+    }
+    task_sleep(FAIR_BENCH_TICKS);
+    irq_restore(flags);
+    
+    // انتظار خروج العمال ثم تحريرهم
+    fair_done = true;
+    do {
+        running = false;
+        for (i = 0; i < n; i++) {
+            running |= tasks[i]->state != TASK_ZOMBIE;
+        }
+        if (running) {
+            yield();
+        }
+    } while (running);
+    
+    for (i = 0; i < n; i++) {
+        ms[i] = (uint32_t)div_u64(tasks[i]->sum_exec_runtime, 1000000);
+        total += ms[i];
+    }
+    
+    print_string("  ");
+    print_string(label);
+    print_string(": cpu shares %");
+    for (i = 0; i < n; i++) {
+        print_string(" ");
+        print_number(total ? ms[i] * 100 / total : 0);
+        if (i < FAIR_BENCH_CPU_TASKS) {
+            if (ms[i] > max) max = ms[i];
+            if (ms[i] < min) min = ms[i];
+        }
+    }
+    print_string(", interactive bursts ");
+    print_number(fair_bursts);
+    print_string(", max/min x100 ");
+    if (min && min != 0xFFFFFFFF) {
+        print_number(max * 100 / min);
+    } else {
+        print_string("inf");
+    }
+    print_string("\n");
+    
+    for (i = 0; i < n; i++) {
+        reap_task(tasks[i]);
+    }
+}
+
+/**
+ * عدالة توزيع المعالج: 3 مهام حسابية ومهمة تفاعلية لمدة ثانيتين
+ * مع كل سياسة، النسبة max/min بين المهام الحسابية المتساوية (100 = عدالة تامة)
+ * المؤقت مفعل هنا والمهمة الرئيسية نائمة طوال القياس
+ */
+void bench_fairness(void) {
+    sched_policy_t old = scheduler.policy;
+    
+    print_string("[BENCH] scheduler fairness\n");
+    
+    bench_fair_run("round robin", SCHED_ROUND_ROBIN);
+    bench_fair_run("fair", SCHED_FAIR);
+    
+    set_scheduling_policy(old);
+}
+
+/**
+ * ثانية خمول مع المؤقت الدوري ثم مع النبضة الديناميكية
+ * كل مقاطعة مؤقت أثناء الخمول استيقاظ للمعالج (وخروج VM تحت المحاكاة)
+ */
+void bench_tickless(void) {
+    static const bool modes[] = { false, true };
+    bool old = tick_nohz_enabled();
+    uint32_t i, start, irqs, saved;
+    
+    print_string("[BENCH] tickless idle (1s)\n");
+    
+    for (i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        set_tick_nohz(modes[i]);
+        irqs = get_timer_interrupts();
+        saved = get_ticks_saved();
+        start = get_timer_ticks();
+        
+        while (get_timer_ticks() - start < HZ) {
+            tick_nohz_idle();
+        }
+        
+        print_string(modes[i] ? "  nohz: " : "  periodic: ");
+        print_number(get_timer_ticks() - start);
+        print_string(" ticks, ");
+        print_number(get_timer_interrupts() - irqs);
+        print_string(" timer interrupts, ");
+        print_number(get_ticks_saved() - saved);
+        print_string(" ticks saved\n");
+    }
+    
+    set_tick_nohz(old);
+}
+
+#define TIMER_BENCH_MAX 50000
+#define TIMER_BENCH_SPAN 16384      // 2^14 tick: مستويان من العجلة مع cascade
+
+static volatile uint32_t timer_bench_fired;
+
+static void bench_timer_fn(uint32_t data) {
+    timer_bench_fired += data;
+}
+
+/**
+ * عجلة التوقيت مع ازدياد عدد المؤقتات: إضافة وحذف وتكلفة الـ tick
+ * عجلة خاصة تُدار يدوياً فلا ننتظر الوقت الحقيقي
+ * يجب أن تبقى التكلفة لكل عملية ولكل tick شبه ثابتة مهما زاد العدد
+ */
+void bench_timers(void) {
+    static const uint32_t counts[] = { 1000, 10000, TIMER_BENCH_MAX };
+    static timer_base_t base;
+    ktimer_t* timers = (ktimer_t*)kmalloc(TIMER_BENCH_MAX * sizeof(ktimer_t));
+    uint64_t start, add_cycles, del_cycles, run_cycles, tick_cycles, worst;
+    uint32_t c, i, n, tick, seed = 11;
+    
+    print_string("[BENCH] timer wheel\n");
+    
+    if (!timers) {
+        print_string("  not enough memory\n");
+        return;
+    }
+    
+    for (c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        n = counts[c];
+        timer_base_init(&base, 0);
+        timer_bench_fired = 0;
+        
+        start = rdtsc();
+        for (i = 0; i < n; i++) {
+            seed = seed * 1103515245 + 12345;
+            setup_timer(&timers[i], bench_timer_fn, 1);
+            timers[i].expires = 1 + (seed >> 8) % TIMER_BENCH_SPAN;
+            timer_base_add(&base, &timers[i]);
+        }
+        add_cycles = rdtsc() - start;
+        
+        // كل الـ ticks حتى انتهاء آخر مؤقت، مع أسوأ tick (يشمل cascade)
+        run_cycles = 0;
+        worst = 0;
+        for (tick = 1; tick <= TIMER_BENCH_SPAN; tick++) {
+            start = rdtsc();
+            timer_base_run(&base, tick);
+            tick_cycles = rdtsc() - start;
+            run_cycles += tick_cycles;
+            if (tick_cycles > worst) {
+                worst = tick_cycles;
+            }
+        }
+        
+        // إعادة التفعيل ثم الإلغاء قبل الانتهاء (المهلات التي لا تنقضي)
+        for (i = 0; i < n; i++) {
+            timers[i].expires = tick + 1 + i % TIMER_BENCH_SPAN;
+            timer_base_add(&base, &timers[i]);
+        }
+        start = rdtsc();
+        for (i = 0; i < n; i++) {
+            timer_base_del(&base, &timers[i]);
+        }
+        del_cycles = rdtsc() - start;
+        
+        print_string("  ");
+        print_number(n);
+        print_string(" timers (");
+        print_number(timer_bench_fired);
+        print_string(" fired)\n");
+        bench_report("add", add_cycles, n);
+        bench_report("del", del_cycles, n);
+        bench_report("tick", run_cycles, TIMER_BENCH_SPAN);
+        bench_report("worst tick", worst, 1);
+    }
+    
+    kfree(timers);
+}
+
+#define CLOCK_BENCH_READS 10000
+
+/**
+ * تكلفة قراءة الساعة الرتيبة ودقتها (أصغر فرق غير صفري بين قراءتين متتاليتين)
+ * ومقارنتها بالـ tick الذي كان المصدر الوحيد للوقت
+ */
+void bench_clock(void) {
+    uint64_t start, cycles, prev, now, resolution = ~0ull;
+    uint32_t i;
+    
+    print_string("[BENCH] clock\n");
+    
+    start = rdtsc();
+    for (i = 0; i < CLOCK_BENCH_READS; i++) {
+        ktime_get_ns();
+    }
+    cycles = rdtsc() - start;
+    bench_report("ktime_get_ns", cycles, CLOCK_BENCH_READS);
+    
+    prev = ktime_get_ns();
+    for (i = 0; i < CLOCK_BENCH_READS; i++) {
+        now = ktime_get_ns();
+        if (now != prev && now - prev < resolution) {
+            resolution = now - prev;
+        }
+        prev = now;
+    }
+    
+    print_string("  resolution: ");
+    print_number(resolution == ~0ull ? 0 : (uint32_t)resolution);
+    print_string(" ns (tick: ");
+    print_number(NSEC_PER_TICK);
+    print_string(" ns)\n");
+}
+
+#define EOI_BENCH_OPS 10000
+
+/**
+ * تكلفة EOI: منفذ 8259 مقابل كتابة MMIO إلى LAPIC
+ * (بلا مقاطعة قيد الخدمة كلتاهما بلا أثر)
+ */
+void bench_eoi(void) {
+    uint64_t start;
+    uint32_t flags, i;
+    
+    print_string("[BENCH] EOI\n");
+    flags = irq_save();
+    
+    start = rdtsc();
+    for (i = 0; i < EOI_BENCH_OPS; i++) {
+        outb(PIC1_COMMAND, PIC_EOI);
+    }
+    bench_report("8259 EOI", rdtsc() - start, EOI_BENCH_OPS);
+    
+    if (apic_enabled()) {
+        start = rdtsc();
+        for (i = 0; i < EOI_BENCH_OPS; i++) {
+            lapic_eoi();
+        }
+        bench_report("LAPIC EOI", rdtsc() - start, EOI_BENCH_OPS);
+    } else {
+        print_string("  LAPIC EOI: APIC disabled\n");
+    }
+    
+    irq_restore(flags);
+}
+
+#define SMP_BENCH_ITERATIONS 20000000
+
+static volatile uint32_t smp_bench_done;
+static volatile uint64_t smp_bench_end;
+static volatile uint32_t smp_bench_sink;
+
+// عمل حسابي في السجلات فقط: لا ذاكرة مشتركة ولا أقفال حتى النهاية
+static void bench_smp_worker(void) {
+    uint32_t x = 1, flags, i;
+    uint64_t now;
+    
+    for (i = 0; i < SMP_BENCH_ITERATIONS; i++) {
+        x = x * 1103515245 + 12345;
+        asm volatile("" : "+r" (x));
+    }
+    
+    flags = irq_save();
+    now = ktime_get_ns();
+    if (now > smp_bench_end) {
+        smp_bench_end = now;
+    }
+    smp_bench_sink += x;
+    smp_bench_done++;
+    irq_restore(flags);
+}
+
+/**
+ * توسع العمل الحسابي مع عدد المعالجات: n مهمة متساوية على n معالج
+ * الزمن المثالي ثابت، والتسريع = n * زمن مهمة واحدة / الزمن الفعلي (100 = خطي لكل معالج)
+ * المهام توزع عند الإنشاء على أقل المعالجات حملاً، والخاملة تسرق الباقي
+ */
+void bench_smp_scaling(void) {
+    task_t* tasks[MAX_CPUS];
+    uint64_t start;
+    uint32_t flags, i, n, count, us, single_us = 0;
+    
+    print_string("[BENCH] SMP scaling (CPU-bound)\n");
+    
+    for (n = 1; n <= (uint32_t)nr_cpus_online; n++) {
+        smp_bench_done = 0;
+        smp_bench_end = 0;
+        count = 0;
+        
+        // كل المهام تُنشأ قبل أن يبدأ أي منها (المعالجات التي أوقظت تنتظر القفل)
+        flags = irq_save();
+        start = ktime_get_ns();
+        for (i = 0; i < n; i++) {
+            tasks[count] = alloc_task("smp", (void*)bench_smp_worker);
+            if (tasks[count]) {
+                count++;
+            }
+        }
+        irq_restore(flags);
+        
+        while (smp_bench_done < count) {
+            task_sleep(1);
+        }
+        us = (uint32_t)div_u64(smp_bench_end - start, 1000);
+        
+        for (i = 0; i < count; i++) {
+            while (tasks[i]->state != TASK_ZOMBIE) {
+                yield();
+            }
+            reap_task(tasks[i]);
+        }
+        
+        if (count < n) {
+            print_string("  out of memory\n");
+            break;
+        }
+        if (n == 1) {
+            single_us = us;
+        }
+        
+        print_string("  ");
+        print_number(n);
+        print_string(" CPUs: ");
+        print_number(us);
+        print_string(" us, speedup x100 ");
+        print_number(us ? (uint32_t)div_u64((uint64_t)single_us * n * 100, us) : 0);
+        print_string("\n");
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "kernel.h"
+
+// اختبارات الأداء داخل النواة - تُبنى فقط مع make BENCH=1
+void run_benchmarks(void);
+
+// اختبارات الأداء لكل نظام فرعي
+void bench_frame_allocator(void);
+void bench_buddy_allocator(void);
+void bench_kfree_latency(void);
+void bench_mem_routines(void);
+void bench_fork(void);
+void bench_page_coloring(void);
+void bench_context_switch(void);
+void bench_scheduler(void);
+void bench_task_table(void);
+void bench_fairness(void);
+void bench_tickless(void);
+void bench_timers(void);
+void bench_clock(void);
+void bench_eoi(void);
+void bench_smp_scaling(void);       // بعد smp_boot
+
+// دوال مساعدة
+void bench_report(const char* label, uint64_t cycles, uint32_t ops);
+
+#endif // BENCH_H
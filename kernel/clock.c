@@ -0,0 +1,230 @@
+#include "clock.h"
+#include "cpu.h"
+#include "scheduler.h"
+#include "interrupt.h"
+#include "memory.h"
+
+// معاملات التحويل من المعايرة
+static uint32_t tsc_khz = 0;
+static uint32_t tsc_mult = 0;       // ns لكل دورة × 2^tsc_shift
+static uint32_t tsc_shift = 0;
+static uint64_t tsc_base = 0;       // TSC عند بداية الوقت الرتيب
+
+// وقت الحائط عند قراءة RTC
+static uint32_t boot_epoch = 0;
+static uint64_t boot_epoch_ns = 0;  // ktime_get_ns عند القراءة
+static rtc_time_t boot_rtc;
+
+// (a * mul) >> shift بوسيط 96 بت، بضربين 32×32 فقط
+static inline uint64_t mul_u64_u32_shr(uint64_t a, uint32_t mul, unsigned int shift) {
+    uint32_t ah = (uint32_t)(a >> 32);
+    uint32_t al = (uint32_t)a;
+    uint64_t ret = ((uint64_t)al * mul) >> shift;
+    
+    if (ah) {
+        ret += ((uint64_t)ah * mul) << (32 - shift);
+    }
+    return ret;
+}
+
+// قياس واحد: دورات TSC خلال CLOCK_CALIBRATE_MS من عد القناة 2
+// (لا تولد مقاطعة، فتبقى القناة 0 على حالها)
+static uint64_t tsc_measure(void) {
+    uint32_t latch = PIT_BASE_FREQUENCY * CLOCK_CALIBRATE_MS / 1000;
+    uint8_t gate = inb(PIT_GATE_PORT);
+    uint64_t start, end;
+    uint32_t loops = 0;
+    
+    // البوابة مفتوحة ومكبر الصوت مفصول
+    outb(PIT_GATE_PORT, (gate & ~PIT_GATE_SPEAKER) | PIT_GATE_ENABLE);
+    outb(PIT_COMMAND_PORT, PIT_CH2_ONESHOT);
+    outb(PIT_CHANNEL2_PORT, latch & 0xFF);
+    outb(PIT_CHANNEL2_PORT, (latch >> 8) & 0xFF);
+    
+    start = rdtsc();
+    while (!(inb(PIT_GATE_PORT) & PIT_GATE_OUTPUT)) {
+        // قناة 2 لا تعد (بعض الأجهزة الافتراضية): لا معايرة
+        if (++loops == 0x1000000) {
+            outb(PIT_GATE_PORT, gate);
+            return 0;
+        }
+    }
+    end = rdtsc();
+    
+    outb(PIT_GATE_PORT, gate);
+    return end - start;
+}
+
+// تردد TSC بالـ kHz: أصغر قياس من عدة محاولات (0 إذا فشلت)
+static uint32_t calibrate_tsc(void) {
+    uint64_t best = 0, cycles;
+    uint32_t flags = irq_save();
+    
+    for (int i = 0; i < CLOCK_CALIBRATE_RUNS; i++) {
+        cycles = tsc_measure();
+        if (!cycles) {
+            best = 0;
+            break;
+        }
+        if (!best || cycles < best) {
+            best = cycles;
+        }
+    }
+    
+    irq_restore(flags);
+    return (uint32_t)div_u64(best, CLOCK_CALIBRATE_MS);
+}
+
+static uint8_t cmos_read(uint8_t reg) {
+    outb(CMOS_ADDRESS_PORT, reg);
+    return inb(CMOS_DATA_PORT);
+}
+
+static uint32_t bcd_to_bin(uint32_t value) {
+    return (value & 0x0F) + (value >> 4) * 10;
+}
+
+static void rtc_read_raw(rtc_time_t* time) {
+    // لا قراءة أثناء تحديث RTC لقيمه
+    while (cmos_read(RTC_STATUS_A) & RTC_UPDATE_IN_PROGRESS);
+    
+    time->second = cmos_read(RTC_SECONDS);
+    time->minute = cmos_read(RTC_MINUTES);
+    time->hour = cmos_read(RTC_HOURS);
+    time->day = cmos_read(RTC_DAY);
+    time->month = cmos_read(RTC_MONTH);
+    time->year = cmos_read(RTC_YEAR);
+}
+
+// قراءة RTC مرتين حتى تتطابق القراءتان (تحديث بين القراءات يغير بعض الحقول)
+static void rtc_read(rtc_time_t* time) {
+    rtc_time_t check;
+    uint8_t status;
+    bool pm;
+    
+    rtc_read_raw(time);
+    do {
+        check = *time;
+        rtc_read_raw(time);
+    } while (memcmp(&check, time, sizeof(check)) != 0);
+    
+    status = cmos_read(RTC_STATUS_B);
+    pm = (time->hour & RTC_HOUR_PM) != 0;
+    time->hour &= ~RTC_HOUR_PM;
+    
+    if (!(status & RTC_BINARY)) {
+        time->second = bcd_to_bin(time->second);
+        time->minute = bcd_to_bin(time->minute);
+        time->hour = bcd_to_bin(time->hour);
+        time->day = bcd_to_bin(time->day);
+        time->month = bcd_to_bin(time->month);
+        time->year = bcd_to_bin(time->year);
+    }
+    if (!(status & RTC_24_HOUR)) {
+        time->hour = (time->hour % 12) + (pm ? 12 : 0);
+    }
+    
+    // سنتان رقميتان: 70-99 هي 1970-1999
+    time->year += time->year < 70 ? 2000 : 1900;
+}
+
+// عدد الأيام منذ 1970-01-01 (خوارزمية days_from_civil)
+static uint32_t days_since_epoch(uint32_t year, uint32_t month, uint32_t day) {
+    uint32_t era, yoe, doy, doe;
+    
+    year -= month <= 2;
+    era = year / 400;
+    yoe = year - era * 400;
+    doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+/**
+ * معايرة TSC وقراءة وقت الحائط من RTC
+ */
+void init_clock(void) {
+    if (cpu_has(features_edx, CPUID_EDX_TSC)) {
+        tsc_khz = calibrate_tsc();
+    }
+    if (tsc_khz) {
+        // ns لكل دورة = 10^6 / kHz، بأكبر إزاحة يتسع ناتجها في 32 بت
+        tsc_shift = CLOCK_SHIFT_MAX;
+        while (tsc_shift > 0 &&
+               div_u64((uint64_t)NSEC_PER_MSEC << tsc_shift, tsc_khz) > 0xFFFFFFFFu) {
+            tsc_shift--;
+        }
+        tsc_mult = (uint32_t)div_u64((uint64_t)NSEC_PER_MSEC << tsc_shift, tsc_khz);
+        tsc_base = rdtsc();
+    }
+    
+    rtc_read(&boot_rtc);
+    boot_epoch_ns = ktime_get_ns();
+    boot_epoch = days_since_epoch(boot_rtc.year, boot_rtc.month, boot_rtc.day) * 86400 +
+                 boot_rtc.hour * 3600 + boot_rtc.minute * 60 + boot_rtc.second;
+    
+    print_clock_info();
+}
+
+/**
+ * تحويل دورات TSC إلى نانوثانية
+ */
+uint64_t cycles_to_ns(uint64_t cycles) {
+    return mul_u64_u32_shr(cycles, tsc_mult, tsc_shift);
+}
+
+/**
+ * الوقت الرتيب بالنانوثانية: قراءة TSC وضرب وإزاحة
+ * بدون TSC معاير يرجع إلى دقة الـ tick
+ */
+uint64_t ktime_get_ns(void) {
+    if (!tsc_khz) {
+        return (uint64_t)get_timer_ticks() * NSEC_PER_TICK;
+    }
+    return cycles_to_ns(rdtsc() - tsc_base);
+}
+
+/**
+ * وقت الحائط بالثواني منذ 1970
+ */
+uint32_t get_real_seconds(void) {
+    return boot_epoch + (uint32_t)div_u64(ktime_get_ns() - boot_epoch_ns, NSEC_PER_SEC);
+}
+
+uint32_t get_tsc_khz(void) {
+    return tsc_khz;
+}
+
+static void print_two_digits(uint32_t value) {
+    print_char('0' + value / 10 % 10);
+    print_char('0' + value % 10);
+}
+
+/**
+ * طباعة مصدر الوقت ووقت الإقلاع
+ */
+void print_clock_info(void) {
+    print_string("[CLOCK] ");
+    if (tsc_khz) {
+        print_string("TSC ");
+        print_number(tsc_khz / 1000);
+        print_string(".");
+        print_number(tsc_khz / 100 % 10);
+        print_string(" MHz");
+    } else {
+        print_string("no TSC, tick resolution");
+    }
+    print_string(", RTC ");
+    print_number(boot_rtc.year);
+    print_char('-');
+    print_two_digits(boot_rtc.month);
+    print_char('-');
+    print_two_digits(boot_rtc.day);
+    print_char(' ');
+    print_two_digits(boot_rtc.hour);
+    print_char(':');
+    print_two_digits(boot_rtc.minute);
+    print_char(':');
+    print_two_digits(boot_rtc.second);
+    print_string(" UTC\n");
+}
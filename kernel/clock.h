@@ -0,0 +1,63 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include "kernel.h"
+
+// مصدر الوقت: TSC معاير مقابل القناة 2 من PIT عند الإقلاع
+// التحويل ns = (cycles * mult) >> shift بلا قسمة في المسار السريع
+// shift أكبر قيمة تبقي mult تحت 2^32 (تُحسب عند المعايرة): خطأ التقريب أقل من 2^-31
+#define NSEC_PER_SEC 1000000000u
+#define NSEC_PER_MSEC 1000000u
+#define CLOCK_SHIFT_MAX 32          // حد mul_u64_u32_shr
+#define CLOCK_CALIBRATE_MS 50       // أقصى ما يتسع له عداد PIT ذو 16 بت (~55ms)
+#define CLOCK_CALIBRATE_RUNS 3      // أصغر قياس يستبعد المقاطعات وتأخير VM
+
+// القناة 2 من PIT وبوابتها (منفذ مكبر الصوت)
+#define PIT_CHANNEL2_PORT 0x42
+#define PIT_GATE_PORT 0x61
+#define PIT_GATE_ENABLE 0x01
+#define PIT_GATE_SPEAKER 0x02
+#define PIT_GATE_OUTPUT 0x20
+#define PIT_CH2_ONESHOT 0xB0        // Channel 2, lobyte/hibyte, mode 0
+
+// CMOS RTC
+#define CMOS_ADDRESS_PORT 0x70
+#define CMOS_DATA_PORT 0x71
+#define RTC_SECONDS 0x00
+#define RTC_MINUTES 0x02
+#define RTC_HOURS 0x04
+#define RTC_DAY 0x07
+#define RTC_MONTH 0x08
+#define RTC_YEAR 0x09
+#define RTC_STATUS_A 0x0A
+#define RTC_STATUS_B 0x0B
+#define RTC_UPDATE_IN_PROGRESS 0x80 // في STATUS_A
+#define RTC_24_HOUR 0x02            // في STATUS_B
+#define RTC_BINARY 0x04             // في STATUS_B (وإلا BCD)
+#define RTC_HOUR_PM 0x80
+
+typedef struct {
+    uint32_t year;
+    uint32_t month;
+    uint32_t day;
+    uint32_t hour;
+    uint32_t minute;
+    uint32_t second;
+} rtc_time_t;
+
+// تهيئة الساعة: معايرة TSC وقراءة RTC
+void init_clock(void);
+
+// وقت رتيب بالنانوثانية منذ الإقلاع (ticks المؤقت إذا لم يتوفر TSC)
+uint64_t ktime_get_ns(void);
+
+// وقت الحائط بالثواني منذ 1970 (RTC عند الإقلاع + الوقت الرتيب)
+uint32_t get_real_seconds(void);
+
+// تحويل فرق دورات TSC إلى نانوثانية
+uint64_t cycles_to_ns(uint64_t cycles);
+
+uint32_t get_tsc_khz(void);         // 0 = لا يوجد TSC معاير
+void print_clock_info(void);
+
+#endif // CLOCK_H
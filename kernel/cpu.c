@@ -0,0 +1,181 @@
+#include "cpu.h"
+#include "memory.h"
+#include "kernel.h"
+
+// معلومات المعالج الحالي
+cpu_info_t cpu_info;
+
+// فحص دعم CPUID: المعالج يسمح بتغيير بت ID (21) في EFLAGS
+static bool detect_cpuid(void) {
+    uint32_t before, after;
+    
+    asm volatile(
+        "pushfl\n\t"
+        "pushfl\n\t"
+        "popl %0\n\t"
+        "movl %0, %1\n\t"
+        "xorl $0x200000, %1\n\t"
+        "pushl %1\n\t"
+        "popfl\n\t"
+        "pushfl\n\t"
+        "popl %1\n\t"
+        "popfl"
+        : "=&r" (before), "=&r" (after));
+    
+    return ((before ^ after) & 0x200000) != 0;
+}
+
+// تفعيل SSE: إلغاء محاكاة FPU وإعلام المعالج بأن النظام يحفظ سجلات XMM
+static void enable_sse(void) {
+    uint32_t cr0, cr4;
+    
+    asm volatile("mov %%cr0, %0" : "=r" (cr0));
+    cr0 &= ~(CR0_EM | CR0_TS);
+    cr0 |= CR0_MP;
+    asm volatile("mov %0, %%cr0" : : "r" (cr0));
+    
+    asm volatile("mov %%cr4, %0" : "=r" (cr4));
+    cr4 |= CR4_OSFXSR | CR4_OSXMMEXCPT;
+    asm volatile("mov %0, %%cr4" : : "r" (cr4));
+    
+    asm volatile("fninit");
+    cpu_info.sse_enabled = true;
+}
+
+// ترميز الترابط في CPUID 0x80000006 (AMD)
+static const uint16_t amd_l2_ways[16] = {
+    0, 1, 2, 0, 4, 0, 8, 0, 16, 0, 32, 48, 64, 96, 128, 0
+};
+
+// هندسة L2: leaf 4 إذا توفر، وإلا 0x80000006
+static void detect_cache_geometry(void) {
+    uint32_t eax, ebx, ecx, edx;
+    uint32_t i, type, colors;
+    
+    if (cpu_info.max_leaf >= CPUID_CACHE_LEAF) {
+        for (i = 0; ; i++) {
+            cpuid(CPUID_CACHE_LEAF, i, &eax, &ebx, &ecx, &edx);
+            type = eax & 0x1F;
+            if (type == 0) {
+                break;
+            }
+            if (((eax >> 5) & 0x7) == 2 && (type == CACHE_TYPE_DATA || type == CACHE_TYPE_UNIFIED)) {
+                cpu_info.l2_ways = ((ebx >> 22) & 0x3FF) + 1;
+                cpu_info.l2_line = (ebx & 0xFFF) + 1;
+                cpu_info.l2_size = cpu_info.l2_ways * (((ebx >> 12) & 0x3FF) + 1) *
+                                   cpu_info.l2_line * (ecx + 1);
+                break;
+            }
+        }
+    }
+    
+    if (cpu_info.l2_size == 0) {
+        cpuid(CPUID_EXT_BASE, 0, &eax, &ebx, &ecx, &edx);
+        if (eax >= CPUID_EXT_L2) {
+            cpuid(CPUID_EXT_L2, 0, &eax, &ebx, &ecx, &edx);
+            cpu_info.l2_size = (ecx >> 16) * 1024;
+            cpu_info.l2_ways = amd_l2_ways[(ecx >> 12) & 0xF];
+            cpu_info.l2_line = ecx & 0xFF;
+        }
+    }
+    
+    // عدد الألوان: الصفحات التي تغطي مجموعة واحدة من كل مسار (قوة للعدد 2)
+    if (cpu_info.l2_size && cpu_info.l2_ways) {
+        colors = cpu_info.l2_size / (cpu_info.l2_ways * PAGE_SIZE);
+        cpu_info.cache_colors = colors ? 1u << bit_scan_reverse(colors) : 1;
+    } else {
+        cpu_info.cache_colors = 1;
+    }
+    
+    if (cpu_info.max_leaf >= CPUID_PERFMON_LEAF) {
+        cpuid(CPUID_PERFMON_LEAF, 0, &eax, &ebx, &ecx, &edx);
+        cpu_info.perfmon_version = eax & 0xFF;
+        // EAX[31:24] عدد البتات الصالحة في EBX، والبت المضبوط يعني أن الحدث غير موجود
+        cpu_info.perfmon_llc_misses = cpu_info.perfmon_version >= 1 &&
+            ((eax >> 24) & 0xFF) > PERFMON_EVENT_LLC_MISSES &&
+            !(ebx & (1u << PERFMON_EVENT_LLC_MISSES));
+    }
+}
+
+/**
+ * تهيئة معلومات المعالج وتفعيل الميزات التي تحتاجها النواة
+ */
+void init_cpu(void) {
+    uint32_t eax, ebx, ecx, edx;
+    
+    cpu_info.has_cpuid = detect_cpuid();
+    if (!cpu_info.has_cpuid) {
+        print_string("[CPU] CPUID غير مدعوم\n");
+        return;
+    }
+    
+    cpuid(0, 0, &eax, &ebx, &ecx, &edx);
+    cpu_info.max_leaf = eax;
+    memcpy(&cpu_info.vendor[0], &ebx, 4);
+    memcpy(&cpu_info.vendor[4], &edx, 4);
+    memcpy(&cpu_info.vendor[8], &ecx, 4);
+    cpu_info.vendor[12] = '\0';
+    
+    if (cpu_info.max_leaf >= 1) {
+        cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+        cpu_info.stepping = eax & 0xF;
+        cpu_info.model = (eax >> 4) & 0xF;
+        cpu_info.family = (eax >> 8) & 0xF;
+        if (cpu_info.family == 0xF) {
+            cpu_info.family += (eax >> 20) & 0xFF;
+        }
+        if (cpu_info.family == 0x6 || cpu_info.family >= 0xF) {
+            cpu_info.model += ((eax >> 16) & 0xF) << 4;
+        }
+        cpu_info.features_edx = edx;
+        cpu_info.features_ecx = ecx;
+    }
+    
+    if (cpu_has(features_edx, CPUID_EDX_SSE2) && cpu_has(features_edx, CPUID_EDX_FXSR)) {
+        enable_sse();
+    }
+    
+    detect_cache_geometry();
+    
+    print_cpu_info();
+}
+
+/**
+ * طباعة معلومات المعالج
+ */
+void print_cpu_info(void) {
+    print_string("[CPU] ");
+    print_string(cpu_info.vendor);
+    print_string(" family ");
+    print_number(cpu_info.family);
+    print_string(" model ");
+    print_number(cpu_info.model);
+    if (cpu_info.sse_enabled) {
+        print_string(" SSE2");
+    }
+    if (cpu_has(features_edx, CPUID_EDX_PSE)) {
+        print_string(" PSE");
+    }
+    if (cpu_has(features_edx, CPUID_EDX_TSC)) {
+        print_string(" TSC");
+    }
+    if (cpu_has(features_edx, CPUID_EDX_APIC)) {
+        print_string(" APIC");
+    }
+    if (cpu_has(features_ecx, CPUID_ECX_TSC_DEADLINE)) {
+        print_string(" TSC-DEADLINE");
+    }
+    print_string("\n");
+    
+    if (cpu_info.l2_size) {
+        print_string("[CPU] L2 ");
+        print_number(cpu_info.l2_size / 1024);
+        print_string(" KB, ");
+        print_number(cpu_info.l2_ways);
+        print_string("-way, ");
+        print_number(cpu_info.l2_line);
+        print_string(" B lines, ");
+        print_number(cpu_info.cache_colors);
+        print_string(" page colors\n");
+    }
+}
@@ -0,0 +1,110 @@
+#ifndef CPU_H
+#define CPU_H
+
+#include "kernel.h"
+
+// بتات CPUID.1:EDX
+#define CPUID_EDX_FPU   (1 << 0)
+#define CPUID_EDX_PSE   (1 << 3)    // صفحات 4MB
+#define CPUID_EDX_TSC   (1 << 4)    // عداد الدورات
+#define CPUID_EDX_MSR   (1 << 5)
+#define CPUID_EDX_APIC  (1 << 9)    // Local APIC
+#define CPUID_EDX_PGE   (1 << 13)   // صفحات عامة
+#define CPUID_EDX_FXSR  (1 << 24)   // fxsave/fxrstor
+#define CPUID_EDX_SSE   (1 << 25)
+#define CPUID_EDX_SSE2  (1 << 26)
+
+// بتات CPUID.1:ECX
+#define CPUID_ECX_SSE3  (1 << 0)
+#define CPUID_ECX_TSC_DEADLINE (1 << 24)    // مؤقت LAPIC بموعد TSC
+
+// بتات سجلات التحكم
+#define CR0_MP (1 << 1)             // مراقبة المعالج المساعد
+#define CR0_EM (1 << 2)             // محاكاة FPU
+#define CR0_TS (1 << 3)             // تبديل المهام
+#define CR0_WP (1 << 16)            // احترام الصفحات للقراءة فقط في الحلقة 0 (COW)
+#define CR0_PG (1u << 31)           // تفعيل الترقيم (paging)
+#define CR4_PSE (1 << 4)            // صفحات 4MB
+#define CR4_PGE (1 << 7)            // صفحات عامة لا تُمسح عند تغيير CR3
+#define CR4_OSFXSR (1 << 9)         // النظام يدعم fxsave/SSE
+#define CR4_OSXMMEXCPT (1 << 10)    // النظام يعالج استثناءات SIMD
+
+// CPUID leaf 4 (Intel) و 0x80000006 (AMD): هندسة الذاكرة المؤقتة
+#define CPUID_CACHE_LEAF 4
+#define CPUID_EXT_BASE 0x80000000
+#define CPUID_EXT_L2 0x80000006
+#define CACHE_TYPE_DATA 1
+#define CACHE_TYPE_UNIFIED 3
+
+// عدادات الأداء المعمارية (CPUID leaf 0xA)
+#define CPUID_PERFMON_LEAF 0xA
+#define PERFMON_EVENT_LLC_MISSES 4          // بت في EBX: 1 = الحدث غير متاح
+#define MSR_PERFEVTSEL0 0x186
+#define MSR_PMC0 0xC1
+#define PERFEVT_LLC_MISSES 0x412E   // event 0x2E, umask 0x41
+#define PERFEVT_USR (1 << 16)
+#define PERFEVT_OS (1 << 17)
+#define PERFEVT_EN (1 << 22)
+
+// MSRs الخاصة بـ Local APIC
+#define MSR_APIC_BASE 0x1B
+#define MSR_APIC_BASE_BSP (1 << 8)          // هذا المعالج هو معالج الإقلاع
+#define MSR_APIC_BASE_ENABLE (1 << 11)      // تفعيل APIC عموماً
+#define MSR_TSC_DEADLINE 0x6E0
+
+// معلومات المعالج
+typedef struct {
+    bool has_cpuid;             // هل التعليمة CPUID مدعومة؟
+    char vendor[13];            // اسم المصنع
+    uint32_t max_leaf;          // أعلى leaf مدعوم
+    uint32_t family;            // العائلة
+    uint32_t model;             // الطراز
+    uint32_t stepping;          // المراجعة
+    uint32_t features_edx;      // CPUID.1:EDX
+    uint32_t features_ecx;      // CPUID.1:ECX
+    bool sse_enabled;           // هل فُعّل SSE في CR0/CR4؟
+    uint32_t l2_size;           // حجم L2 بالبايت (0 إذا لم يُعرف)
+    uint32_t l2_ways;           // درجة الترابط
+    uint32_t l2_line;           // حجم السطر
+    uint32_t cache_colors;      // ألوان الصفحات في L2: الحجم / (الترابط * حجم الصفحة)
+    uint32_t perfmon_version;   // إصدار عدادات الأداء المعمارية (0 = غير متاحة)
+    bool perfmon_llc_misses;    // حدث LLC misses المعماري موجود
+} cpu_info_t;
+
+// معلومات المعالج الحالي
+extern cpu_info_t cpu_info;
+
+// فحص ميزة: cpu_has(features_edx, CPUID_EDX_SSE2)
+#define cpu_has(reg, flag) ((cpu_info.reg & (flag)) != 0)
+
+// تنفيذ CPUID
+static inline void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t* eax,
+                         uint32_t* ebx, uint32_t* ecx, uint32_t* edx) {
+    asm volatile("cpuid"
+                 : "=a" (*eax), "=b" (*ebx), "=c" (*ecx), "=d" (*edx)
+                 : "a" (leaf), "c" (subleaf));
+}
+
+// قراءة وكتابة MSR
+static inline uint64_t rdmsr(uint32_t msr) {
+    uint32_t lo, hi;
+    asm volatile("rdmsr" : "=a" (lo), "=d" (hi) : "c" (msr));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static inline void wrmsr(uint32_t msr, uint64_t value) {
+    asm volatile("wrmsr" : : "c" (msr), "a" ((uint32_t)value), "d" ((uint32_t)(value >> 32)));
+}
+
+// قراءة عداد أداء
+static inline uint64_t rdpmc(uint32_t counter) {
+    uint32_t lo, hi;
+    asm volatile("rdpmc" : "=a" (lo), "=d" (hi) : "c" (counter));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+// دوال المعالج
+void init_cpu(void);
+void print_cpu_info(void);
+
+#endif // CPU_H
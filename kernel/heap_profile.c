@@ -0,0 +1,236 @@
+#include "heap_profile.h"
+#include "interrupt.h"
+#include "kernel.h"
+
+#ifdef CONFIG_HEAP_PROFILE
+
+// تخصيص حي: من أين جاء ومتى
+typedef struct {
+    uint32_t ptr;               // 0 = خانة فارغة
+    uint32_t size;              // الحجم الممنوح
+    uint32_t site;              // فهرس موقع الاستدعاء
+    uint64_t birth;             // rdtsc عند التخصيص
+} heap_live_t;
+
+// الجداول ثابتة لأن المحلل لا يستطيع استخدام kmalloc نفسه
+static heap_site_t sites[PROFILE_MAX_SITES];
+static heap_live_t live[PROFILE_MAX_LIVE];
+static heap_size_bucket_t size_buckets[PROFILE_SIZE_BUCKETS];
+static uint32_t dropped_sites = 0;
+static uint32_t dropped_live = 0;
+
+// hash مضاعف لعناوين محاذاة على 8 بايت على الأقل
+static inline uint32_t hash_ptr(uint32_t value, uint32_t size) {
+    return ((value >> 3) * 2654435761u) & (size - 1);
+}
+
+// إيجاد موقع الاستدعاء أو إضافته (probing خطي)
+static int find_site(uint32_t caller) {
+    uint32_t i = hash_ptr(caller, PROFILE_MAX_SITES);
+    uint32_t n;
+
+    for (n = 0; n < PROFILE_MAX_SITES; n++) {
+        if (sites[i].caller == caller) {
+            return i;
+        }
+        if (sites[i].caller == 0) {
+            sites[i].caller = caller;
+            return i;
+        }
+        i = (i + 1) & (PROFILE_MAX_SITES - 1);
+    }
+
+    dropped_sites++;
+    return -1;
+}
+
+// إيجاد خانة تخصيص حي بالعنوان
+static heap_live_t* find_live(uint32_t ptr) {
+    uint32_t i = hash_ptr(ptr, PROFILE_MAX_LIVE);
+    uint32_t n;
+
+    for (n = 0; n < PROFILE_MAX_LIVE && live[i].ptr != 0; n++) {
+        if (live[i].ptr == ptr) {
+            return &live[i];
+        }
+        i = (i + 1) & (PROFILE_MAX_LIVE - 1);
+    }
+    return NULL;
+}
+
+// حذف خانة مع إزاحة اللاحقة للخلف حتى لا تنقطع سلاسل البحث
+static void remove_live(heap_live_t* entry) {
+    uint32_t hole = entry - live;
+    uint32_t i = hole;
+    uint32_t home;
+
+    live[hole].ptr = 0;
+    for (;;) {
+        i = (i + 1) & (PROFILE_MAX_LIVE - 1);
+        if (live[i].ptr == 0) {
+            return;
+        }
+        home = hash_ptr(live[i].ptr, PROFILE_MAX_LIVE);
+        // الخانة i يمكن نقلها إلى hole إذا لم يكن موطنها بين hole و i
+        if (((i - home) & (PROFILE_MAX_LIVE - 1)) >= ((i - hole) & (PROFILE_MAX_LIVE - 1))) {
+            live[hole] = live[i];
+            live[i].ptr = 0;
+            hole = i;
+        }
+    }
+}
+
+/**
+ * تسجيل تخصيص: الموقع والحجم وزمن البداية
+ */
+void heap_profile_alloc(void* ptr, uint32_t requested, uint32_t granted, void* caller) {
+    uint32_t flags = irq_save();
+    uint32_t bucket = bit_scan_reverse(requested);
+    uint32_t i, n;
+    int site;
+
+    size_buckets[bucket].count++;
+    size_buckets[bucket].waste += granted - requested;
+
+    site = find_site((uint32_t)caller);
+    if (site >= 0) {
+        sites[site].allocs++;
+        sites[site].live_bytes += granted;
+        sites[site].requested_bytes += requested;
+        sites[site].granted_bytes += granted;
+
+        i = hash_ptr((uint32_t)ptr, PROFILE_MAX_LIVE);
+        for (n = 0; n < PROFILE_MAX_LIVE && live[i].ptr != 0; n++) {
+            i = (i + 1) & (PROFILE_MAX_LIVE - 1);
+        }
+        if (n < PROFILE_MAX_LIVE) {
+            live[i].ptr = (uint32_t)ptr;
+            live[i].size = granted;
+            live[i].site = site;
+            live[i].birth = rdtsc();
+        } else {
+            dropped_live++;
+        }
+    }
+
+    irq_restore(flags);
+}
+
+/**
+ * تسجيل تحرير: عمر الكتلة يُضاف إلى موقع تخصيصها
+ */
+void heap_profile_free(void* ptr) {
+    uint32_t flags = irq_save();
+    heap_live_t* entry = find_live((uint32_t)ptr);
+    heap_site_t* site;
+
+    if (entry) {
+        site = &sites[entry->site];
+        site->frees++;
+        site->live_bytes -= entry->size;
+        site->lifetime_cycles += rdtsc() - entry->birth;
+        remove_live(entry);
+    }
+
+    irq_restore(flags);
+}
+
+/**
+ * تسجيل تغيير حجم في المكان (krealloc بدون نسخ)
+ */
+void heap_profile_resize(void* ptr, uint32_t requested, uint32_t granted) {
+    uint32_t flags = irq_save();
+    heap_live_t* entry = find_live((uint32_t)ptr);
+    heap_site_t* site;
+
+    if (entry) {
+        site = &sites[entry->site];
+        site->live_bytes = site->live_bytes - entry->size + granted;
+        site->requested_bytes += requested;
+        site->granted_bytes += granted;
+        entry->size = granted;
+    }
+
+    irq_restore(flags);
+}
+
+// طباعة نسبة مئوية صحيحة
+static void print_percent(uint64_t part, uint64_t total) {
+    print_number(total ? (uint32_t)div_u64(part * 100, (uint32_t)total) : 0);
+    print_string("%");
+}
+
+/**
+ * تقرير المحلل: أكثر المواقع تخصيصاً ومدرج الأحجام
+ */
+void print_heap_profile(void) {
+    bool shown[PROFILE_MAX_SITES];
+    heap_site_t* site;
+    uint32_t i, rank, best;
+
+    print_string("\n=== Heap Profile ===\n");
+    print_string("Top call sites by bytes requested:\n");
+
+    for (i = 0; i < PROFILE_MAX_SITES; i++) {
+        shown[i] = false;
+    }
+
+    // اختيار بسيط للأعلى، الجدول صغير
+    for (rank = 0; rank < PROFILE_TOP_SITES; rank++) {
+        best = PROFILE_MAX_SITES;
+        for (i = 0; i < PROFILE_MAX_SITES; i++) {
+            if (shown[i] || sites[i].allocs == 0) {
+                continue;
+            }
+            if (best == PROFILE_MAX_SITES || sites[i].requested_bytes > sites[best].requested_bytes) {
+                best = i;
+            }
+        }
+        if (best == PROFILE_MAX_SITES) {
+            break;
+        }
+        shown[best] = true;
+        site = &sites[best];
+
+        print_string("  ");
+        print_hex(site->caller);
+        print_string(" allocs: ");
+        print_number(site->allocs);
+        print_string(" live: ");
+        print_number(site->live_bytes);
+        print_string(" B avg: ");
+        print_number((uint32_t)div_u64(site->requested_bytes, site->allocs));
+        print_string(" B waste: ");
+        print_percent(site->granted_bytes - site->requested_bytes, site->granted_bytes);
+        if (site->frees) {
+            print_string(" life: ");
+            print_number((uint32_t)div_u64(site->lifetime_cycles, site->frees));
+            print_string(" cyc");
+        }
+        print_string("\n");
+    }
+
+    print_string("Size histogram (requests, rounding waste):\n");
+    for (i = 0; i < PROFILE_SIZE_BUCKETS; i++) {
+        if (size_buckets[i].count == 0) {
+            continue;
+        }
+        print_string("  ");
+        print_number(1u << i);
+        print_string("+ B: ");
+        print_number(size_buckets[i].count);
+        print_string(", ");
+        print_number((uint32_t)size_buckets[i].waste);
+        print_string(" B\n");
+    }
+
+    if (dropped_sites || dropped_live) {
+        print_string("  untracked: ");
+        print_number(dropped_sites);
+        print_string(" sites, ");
+        print_number(dropped_live);
+        print_string(" live blocks\n");
+    }
+}
+
+#endif // CONFIG_HEAP_PROFILE
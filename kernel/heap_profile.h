@@ -0,0 +1,49 @@
+#ifndef HEAP_PROFILE_H
+#define HEAP_PROFILE_H
+
+#include "kernel.h"
+
+// محلل kmalloc - يُبنى فقط مع make PROFILE=1
+// يسجل لكل موقع استدعاء: عدد التخصيصات والحجم المطلوب والممنوح وعمر الكتل
+#define PROFILE_MAX_SITES 128       // مواقع الاستدعاء المتتبعة
+#define PROFILE_MAX_LIVE 4096       // تخصيصات حية متتبعة (جدول hash)
+#define PROFILE_SIZE_BUCKETS 32     // مدرج الأحجام: bucket لكل قوة للعدد 2
+#define PROFILE_TOP_SITES 10        // عدد المواقع في التقرير
+
+// إحصائيات موقع استدعاء واحد
+typedef struct {
+    uint32_t caller;            // عنوان العودة من kmalloc
+    uint32_t allocs;            // عدد التخصيصات
+    uint32_t frees;             // عدد التحريرات
+    uint32_t live_bytes;        // البايتات الحية الآن
+    uint64_t requested_bytes;   // مجموع الأحجام المطلوبة
+    uint64_t granted_bytes;     // مجموع الأحجام الممنوحة فعلياً
+    uint64_t lifetime_cycles;   // مجموع أعمار الكتل المحررة
+} heap_site_t;
+
+// مدرج الأحجام: [2^k, 2^(k+1))
+typedef struct {
+    uint32_t count;             // عدد الطلبات في هذا المدى
+    uint64_t waste;             // البايتات الضائعة بالتقريب إلى فئة الحجم
+} heap_size_bucket_t;
+
+#ifdef CONFIG_HEAP_PROFILE
+
+void heap_profile_alloc(void* ptr, uint32_t requested, uint32_t granted, void* caller);
+void heap_profile_free(void* ptr);
+void heap_profile_resize(void* ptr, uint32_t requested, uint32_t granted);
+void print_heap_profile(void);
+
+#else
+
+#define heap_profile_alloc(ptr, requested, granted, caller) ((void)0)
+#define heap_profile_free(ptr) ((void)0)
+#define heap_profile_resize(ptr, requested, granted) ((void)0)
+
+static inline void print_heap_profile(void) {
+    print_string("[PROFILE] heap profiler disabled (build with make PROFILE=1)\n");
+}
+
+#endif // CONFIG_HEAP_PROFILE
+
+#endif // HEAP_PROFILE_H
@@ -2,6 +2,11 @@
 #include "kernel.h"
 #include <stdint.h>
 #include "task.h"
+#include "scheduler.h"
+#include "paging.h"
+#include "timer.h"
+#include "apic.h"
+#include "smp.h"
 
 // جدول وصف المقاطعات ومؤشره
 idt_entry_t idt[IDT_SIZE];
@@ -14,6 +19,14 @@ interrupt_handler_t interrupt_handlers[IDT_SIZE];
 static uint32_t interrupt_count = 0;
 static uint32_t timer_ticks = 0;
 
+// النبضة الديناميكية (tickless idle): عند خلو طابور التشغيل يُبرمج PIT بوضع
+// one-shot حتى أقرب حدث معلق بدل مقاطعة كل tick، وتُعوض timer_ticks عند الاستيقاظ
+// (حالة التوقف لكل معالج في cpu_t)
+static bool nohz_enabled = true;
+static uint32_t timer_interrupts = 0;       // مقاطعات المؤقت الفعلية
+static uint32_t ticks_saved = 0;            // ticks مرت بلا مقاطعة
+static uint32_t next_heartbeat = HZ;        // موعد النقطة التالية على الشاشة
+
 // دالة تهيئة نظام المقاطعات الكامل
 void init_interrupts() {
     print_string("[KERNEL] تهيئة نظام المقاطعات...\n");
@@ -108,6 +121,13 @@ void init_pic() {
     outb(0xA1, 0x00);
 }
 
+// إخفاء كل مداخل PIC: المقاطعات تأتي من IOAPIC و LAPIC
+// (إعادة الترقيم في init_pic تبقى، فالمقاطعة الزائفة من PIC تقع على متجه معروف)
+void disable_pic() {
+    outb(PIC1_DATA, 0xFF);
+    outb(PIC2_DATA, 0xFF);
+}
+
 // دالة تحميل IDT - معرفة في interrupt_asm.s
 // void load_idt() - تم نقلها إلى assembly
 
@@ -125,18 +145,39 @@ void register_interrupt_handler(uint8_t num, interrupt_handler_t handler) {
     interrupt_handlers[num] = handler;
 }
 
-// دالة تفعيل المقاطعات
+// قراءة EFLAGS الحالية
+static inline uint32_t read_eflags(void) {
+    uint32_t flags;
+    asm volatile("pushfl\n\tpopl %0" : "=r" (flags));
+    return flags;
+}
+
+// دالة تفعيل المقاطعات (وتحرير قفل النواة إن كانت معطلة)
 void enable_interrupts() {
+    if (!(read_eflags() & EFLAGS_IF)) {
+        kernel_lock_release();
+    }
     asm volatile("sti");
 }
 
-// دالة تعطيل المقاطعات
+// دالة تعطيل المقاطعات (وأخذ قفل النواة إن كانت مفعلة)
 void disable_interrupts() {
+    uint32_t flags = read_eflags();
+    
     asm volatile("cli");
+    if (flags & EFLAGS_IF) {
+        kernel_lock_acquire();
+    }
 }
 
 // معالج الاستثناءات العام
+// الاستثناء قد يقع والمقاطعات معطلة (والقفل ممسوك)، فيؤخذ القفل فقط إن كانت مفعلة
 void isr_handler(interrupt_context_t* context) {
+    bool lock = context->eflags & EFLAGS_IF;
+    
+    if (lock) {
+        kernel_lock_acquire();
+    }
     interrupt_count++;
     
     if (interrupt_handlers[context->int_no] != NULL) {
@@ -147,10 +188,16 @@ void isr_handler(interrupt_context_t* context) {
         print_string("\n");
         print_interrupt_info(context);
     }
+    
+    if (lock) {
+        kernel_lock_release();
+    }
 }
 
 // معالج المقاطعات الخارجية العام
+// المقاطعة الخارجية تصل فقط والمقاطعات مفعلة، فالقفل غير ممسوك على هذا المعالج
 void irq_handler(interrupt_context_t* context) {
+    kernel_lock_acquire();
     interrupt_count++;
     
     // إرسال EOI
@@ -159,21 +206,174 @@ void irq_handler(interrupt_context_t* context) {
     if (interrupt_handlers[context->int_no] != NULL) {
         interrupt_handlers[context->int_no](context);
     }
+    
+    kernel_lock_release();
+}
+
+// برمجة مقاطعة واحدة بعد ticks على مصدر الـ tick الحالي
+static void tick_program_oneshot(uint32_t ticks) {
+    uint32_t count;
+    
+    if (apic_enabled()) {
+        lapic_timer_oneshot(ticks);
+        return;
+    }
+    
+    count = ticks * PIT_DIVISOR;
+    outb(PIT_COMMAND_PORT, PIT_MODE_ONESHOT);
+    outb(PIT_CHANNEL0_PORT, count & 0xFF);
+    outb(PIT_CHANNEL0_PORT, (count >> 8) & 0xFF);
+}
+
+// الـ ticks الكاملة التي مرت من العد one-shot (nohz_ticks إذا انتهى)
+static uint32_t tick_oneshot_elapsed(void) {
+    uint32_t remaining, count;
+    
+    if (apic_enabled()) {
+        return lapic_timer_elapsed();
+    }
+    
+    outb(PIT_COMMAND_PORT, PIT_LATCH_COUNT);
+    remaining = inb(PIT_CHANNEL0_PORT);
+    remaining |= (uint32_t)inb(PIT_CHANNEL0_PORT) << 8;
+    count = this_cpu()->nohz_ticks * PIT_DIVISOR;
+    
+    // العداد تجاوز الصفر وبدأ من 0xFFFF
+    if (remaining > count) {
+        return this_cpu()->nohz_ticks;
+    }
+    return (count - remaining) / PIT_DIVISOR;
+}
+
+// العودة إلى المؤقت الدوري بعد توقفه وتعويض الـ ticks التي مرت بلا مقاطعة
+// (timer_ticks يتقدم على المعالج 0 وحده)
+static void tick_nohz_catch_up(cpu_t* cpu, uint32_t ticks) {
+    setup_scheduler_timer();
+    cpu->tick_stopped = false;
+    
+    // زمن المهمة المتوقفة على hlt تقيسه الساعة عند المحاسبة التالية
+    if (cpu->id == 0) {
+        timer_ticks += ticks;
+    }
+    ticks_saved += ticks;
 }
 
-// معالج مقاطعة المؤقت
+// معالج مقاطعة المؤقت: كل معالج يجدول مهامه بمؤقته المحلي
+// والمعالج 0 وحده يعد الـ ticks ويشغل مؤقتات النواة
 void timer_handler(interrupt_context_t* context) {
-    timer_ticks++;
+    cpu_t* cpu = this_cpu();
     
-    // طباعة نقطة كل 100 tick
-    if (timer_ticks % 100 == 0) {
-        print_char('.');
+    timer_interrupts++;
+    
+    if (cpu->tick_stopped) {
+        // انتهى العد one-shot: مرت كل الـ ticks المبرمجة، وآخرها هذه المقاطعة
+        tick_nohz_catch_up(cpu, cpu->nohz_ticks - 1);
+    } else {
+        lapic_timer_tick();
+    }
+    
+    if (cpu->id == 0) {
+        timer_ticks++;
+        
+        // طباعة نقطة كل HZ tick (ثانية)
+        if (timer_ticks >= next_heartbeat) {
+            print_char('.');
+            next_heartbeat = timer_ticks - timer_ticks % HZ + HZ;
+        }
+        
+        // المؤقتات المنتهية أولاً حتى تنافس المهام التي أيقظتها في نفس الـ tick
+        run_timers();
+    }
+    
+    // محاسبة الشريحة الزمنية والجدولة عند انتهائها أو ظهور أولوية أعلى
+    scheduler_tick();
+}
+
+/**
+ * انتظار المقاطعة التالية في حلقة الخمول
+ * إذا لم تكن هناك مهمة جاهزة يتوقف المؤقت الدوري حتى أقرب حدث معلق
+ * (أقرب مؤقت نواة أو نقطة الثانية التالية)، بحد أقصى ما يتسع له عداد المؤقت
+ * مع عدة معالجات يبقى tick المعالج 0 دورياً: timer_ticks ومؤقتات النواة تبقى دقيقة
+ * لمهام المعالجات الأخرى، وهذه لا تنتظر إلا IPI أو أطول one-shot
+ */
+void tick_nohz_idle(void) {
+    uint32_t ticks, elapsed;
+    cpu_t* cpu;
+    
+    disable_interrupts();
+    cpu = this_cpu();
+    
+    if (cpu->id != 0) {
+        ticks = lapic_timer_max_ticks();
+    } else if (smp_active) {
+        ticks = 0;
+    } else {
+        ticks = timer_next_event(apic_enabled() ? lapic_timer_max_ticks() : NOHZ_MAX_TICKS);
+        if (next_heartbeat - timer_ticks < ticks) {
+            ticks = next_heartbeat - timer_ticks;
+        }
     }
     
-    // جدولة المهام كل 10 ticks
-    if (timer_ticks % 10 == 0) {
-        schedule(); // استدعاء جدولة المهام
+    if (nohz_enabled && ticks > 1 && get_next_task() == scheduler.cpu[cpu->id].idle_task) {
+        cpu->nohz_ticks = ticks;
+        cpu->tick_stopped = true;
+        tick_program_oneshot(ticks);
+    }
+    
+    // sti تؤخر المقاطعات حتى بعد hlt فلا تضيع مقاطعة بينهما
+    // (ومنها IPI معالج أضاف مهمة إلى طابورنا بعد تحرير القفل)
+    kernel_lock_release();
+    asm volatile("sti\n\thlt");
+    disable_interrupts();
+    cpu = this_cpu();       // المقاطعة قد تكون نقلت المهمة (غير مهمة الخمول) إلى معالج آخر
+    
+    // استيقاظ مبكر بمقاطعة أخرى: تعويض الـ ticks الكاملة التي مرت
+    // (جزء الـ tick الأخير يضيع عند إعادة المؤقت الدوري)
+    if (cpu->tick_stopped) {
+        elapsed = tick_oneshot_elapsed();
+        
+        // العد انتهى: المقاطعة المعلقة ستعوض كل الـ ticks
+        if (elapsed < cpu->nohz_ticks) {
+            tick_nohz_catch_up(cpu, elapsed);
+        }
     }
+    
+    enable_interrupts();
+}
+
+/**
+ * تفعيل أو تعطيل النبضة الديناميكية
+ */
+void set_tick_nohz(bool enabled) {
+    nohz_enabled = enabled;
+}
+
+bool tick_nohz_enabled(void) {
+    return nohz_enabled;
+}
+
+uint32_t get_timer_interrupts(void) {
+    return timer_interrupts;
+}
+
+uint32_t get_ticks_saved(void) {
+    return ticks_saved;
+}
+
+/**
+ * طباعة إحصائيات المؤقت: الـ ticks مقابل المقاطعات التي ولدتها فعلاً
+ */
+void print_timer_stats(void) {
+    print_string("Timer: ticks ");
+    print_number(timer_ticks);
+    print_string(", interrupts ");
+    print_number(timer_interrupts);
+    print_string(", ticks saved ");
+    print_number(ticks_saved);
+    print_string(", pending timers ");
+    print_number(get_pending_timers());
+    print_string(apic_enabled() ? ", LAPIC timer" : ", PIT");
+    print_string(nohz_enabled ? ", nohz on\n" : ", nohz off\n");
 }
 
 // معالج مقاطعة لوحة المفاتيح
@@ -198,6 +398,11 @@ void page_fault_handler(interrupt_context_t* context) {
     uint32_t faulting_address;
     asm volatile("mov %%cr2, %0" : "=r" (faulting_address));
     
+    // صفحة محجوزة لم تُلمس بعد: تُربط عند الطلب ونعود للتعليمة
+    if (handle_page_fault(faulting_address, context->err_code)) {
+        return;
+    }
+    
     print_string("[ERROR] خطأ في الصفحة! العنوان: ");
     print_hex(faulting_address);
     print_string("\n");
@@ -213,11 +418,16 @@ void general_protection_fault_handler(interrupt_context_t* context) {
 }
 
 // دالة إرسال End of Interrupt
+// مع APIC كتابة MMIO واحدة لـ LAPIC بدل منفذ أو اثنين
 void send_eoi(uint8_t irq) {
+    if (apic_enabled()) {
+        lapic_eoi();
+        return;
+    }
     if (irq >= 8) {
-        outb(0xA0, 0x20); // إرسال EOI إلى PIC الثانوي
+        outb(PIC2_COMMAND, PIC_EOI); // إرسال EOI إلى PIC الثانوي
     }
-    outb(0x20, 0x20); // إرسال EOI إلى PIC الرئيسي
+    outb(PIC1_COMMAND, PIC_EOI); // إرسال EOI إلى PIC الرئيسي
 }
 
 // دالة طباعة معلومات المقاطعة
@@ -2,6 +2,7 @@
 #define INTERRUPT_H
 
 #include "kernel.h"
+#include "smp.h"
 
 // ثوابت المقاطعات - مستوحاة من Linux 0.01
 #define IDT_SIZE 256                    // حجم جدول وصف المقاطعات
@@ -17,6 +18,16 @@
 #define IRQ_LPT2        0x25            // مقاطعة LPT2
 #define IRQ_FLOPPY      0x26            // مقاطعة القرص المرن
 #define IRQ_LPT1        0x27            // مقاطعة LPT1
+#define IRQ_RESCHEDULE  0x30            // IPI: مهمة جاهزة لمعالج خامل
+
+// منافذ 8259
+#define PIC1_COMMAND    0x20
+#define PIC1_DATA       0x21
+#define PIC2_COMMAND    0xA0
+#define PIC2_DATA       0xA1
+#define PIC_EOI         0x20
+
+#define EFLAGS_IF       0x200           // المقاطعات مفعلة
 
 // مقاطعات الاستثناءات
 #define EXCEPTION_DIVIDE_ERROR          0x00
@@ -68,6 +79,7 @@ extern interrupt_handler_t interrupt_handlers[IDT_SIZE]; // معالجات ال
 void init_interrupts();                 // تهيئة نظام المقاطعات
 void init_idt();                        // تهيئة IDT
 void init_pic();                        // تهيئة PIC (Programmable Interrupt Controller)
+void disable_pic();                     // إخفاء كل مداخل PIC (عند الانتقال إلى APIC)
 void load_idt();                        // تحميل IDT
 
 // دوال إدارة المقاطعات
@@ -76,6 +88,36 @@ void register_interrupt_handler(uint8_t num, interrupt_handler_t handler);
 void enable_interrupts();               // تفعيل المقاطعات
 void disable_interrupts();              // تعطيل المقاطعات
 
+// حفظ حالة المقاطعات وتعطيلها، ثم استعادتها
+#ifdef CONFIG_HOST
+// البناء على المضيف (make bench-host): وضع المستخدم بلا مقاطعات، وcli ممنوعة فيه
+static inline uint32_t irq_save(void) {
+    return 0;
+}
+
+static inline void irq_restore(uint32_t flags) {
+    (void)flags;
+}
+#else
+// مع عدة معالجات: من يعطل مقاطعاته يمسك قفل النواة العام (smp.h)
+// والمستويات المتداخلة لا تمسكه مرة أخرى لأن المقاطعات معطلة أصلاً
+static inline uint32_t irq_save(void) {
+    uint32_t flags;
+    asm volatile("pushfl\n\tpopl %0\n\tcli" : "=r" (flags) : : "memory");
+    if (flags & EFLAGS_IF) {
+        kernel_lock_acquire();
+    }
+    return flags;
+}
+
+static inline void irq_restore(uint32_t flags) {
+    if (flags & EFLAGS_IF) {
+        kernel_lock_release();
+    }
+    asm volatile("pushl %0\n\tpopfl" : : "r" (flags) : "memory", "cc");
+}
+#endif
+
 // معالجات المقاطعات الأساسية
 void isr_handler(interrupt_context_t* context);    // معالج الاستثناءات
 void irq_handler(interrupt_context_t* context);    // معالج المقاطعات الخارجية
@@ -87,6 +129,14 @@ void divide_error_handler(interrupt_context_t* context); // معالج خطأ ا
 void page_fault_handler(interrupt_context_t* context); // معالج خطأ الصفحة
 void general_protection_fault_handler(interrupt_context_t* context); // معالج خطأ الحماية العامة
 
+// النبضة الديناميكية: إيقاف المؤقت الدوري أثناء الخمول
+void tick_nohz_idle(void);              // hlt بدون ticks حتى أقرب حدث
+void set_tick_nohz(bool enabled);
+bool tick_nohz_enabled(void);
+uint32_t get_timer_interrupts(void);    // مقاطعات المؤقت الفعلية
+uint32_t get_ticks_saved(void);         // ticks مرت بلا مقاطعة
+void print_timer_stats(void);
+
 // دوال مساعدة
 void send_eoi(uint8_t irq);             // إرسال End of Interrupt
 void print_interrupt_info(interrupt_context_t* context); // طباعة معلومات المقاطعة
@@ -129,5 +179,6 @@ IRQ(4, 36)         // COM1
 IRQ(5, 37)         // LPT2
 IRQ(6, 38)         // Floppy
 IRQ(7, 39)         // LPT1
+IRQ(16, 48)        // Reschedule IPI
 
 #endif
\ No newline at end of file
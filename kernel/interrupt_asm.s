@@ -7,6 +7,8 @@
 global isr0, isr1, isr2, isr3, isr4, isr5, isr6, isr7, isr8
 global isr10, isr11, isr12, isr13, isr14
 global irq0, irq1, irq2, irq3, irq4, irq5, irq6, irq7
+global irq16
+global apic_spurious
 global load_idt
 
 ; استيراد معالجات C
@@ -66,6 +68,7 @@ IRQ 4, 36           ; COM1
 IRQ 5, 37           ; LPT2
 IRQ 6, 38           ; Floppy Disk
 IRQ 7, 39           ; LPT1
+IRQ 16, 48          ; Reschedule IPI (LAPIC, no 8259 line)
 
 ; المعالج المشترك للاستثناءات
 isr_common_stub:
@@ -77,8 +80,7 @@ isr_common_stub:
     mov ax, 0x10        ; تحميل kernel data segment descriptor
     mov ds, ax
     mov es, ax
-    mov fs, ax
-    mov gs, ax
+    mov fs, ax          ; gs يبقى مقطع بيانات المعالج (smp.h)
     
     call isr_handler    ; استدعاء معالج C
     
@@ -86,7 +88,6 @@ isr_common_stub:
     mov ds, ax
     mov es, ax
     mov fs, ax
-    mov gs, ax
     
     popa                ; استعادة جميع السجلات
     add esp, 8          ; تنظيف رقم المقاطعة ورمز الخطأ
@@ -103,8 +104,7 @@ irq_common_stub:
     mov ax, 0x10        ; تحميل kernel data segment descriptor
     mov ds, ax
     mov es, ax
-    mov fs, ax
-    mov gs, ax
+    mov fs, ax          ; gs يبقى مقطع بيانات المعالج (smp.h)
     
     call irq_handler    ; استدعاء معالج C
     
@@ -112,13 +112,16 @@ irq_common_stub:
     mov ds, ax
     mov es, ax
     mov fs, ax
-    mov gs, ax
     
     popa                ; استعادة جميع السجلات
     add esp, 8          ; تنظيف رقم المقاطعة ورمز الخطأ
     sti                 ; تفعيل المقاطعات
     iret                ; العودة من المقاطعة
 
+; مقاطعة LAPIC الزائفة: لا تحتاج EOI ولا معالج
+apic_spurious:
+    iret
+
 ; دالة تحميل IDT
 load_idt:
     mov eax, [esp+4]    ; الحصول على مؤشر IDT من المعامل
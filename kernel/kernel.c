@@ -1,10 +1,20 @@
 #include "kernel.h"
 #include "task.h"
 #include "interrupt.h"
+#include "timer.h"
+#include "clock.h"
+#include "acpi.h"
+#include "apic.h"
+#include "smp.h"
 #include "memory.h"
 #include "syscall.h"
 #include "scheduler.h"
 #include "keyboard.h"
+#include "slab.h"
+#include "cpu.h"
+#include "paging.h"
+#include "bench.h"
+#include "heap_profile.h"
 
 // مؤشر إلى ذاكرة VGA
 static uint16_t* vga_buffer = (uint16_t*)VGA_TEXT_BUFFER;
@@ -20,8 +30,10 @@ void clear_screen() {
     cursor_y = 0;
 }
 
-// دالة طباعة حرف واحد
+// دالة طباعة حرف واحد (موضع المؤشر مشترك بين المعالجات)
 void print_char(char c) {
+    uint32_t flags = irq_save();
+    
     if (c == '\n') {
         cursor_x = 0;
         cursor_y++;
@@ -41,15 +53,13 @@ void print_char(char c) {
             }
         }
     }
+    
+    irq_restore(flags);
 }
 
 void scroll_screen(void) {
-    // تمرير الشاشة لأعلى - نسخ كل سطر إلى السطر الذي فوقه
-    for (int row = 1; row < VGA_HEIGHT; row++) {
-        for (int col = 0; col < VGA_WIDTH; col++) {
-            vga_buffer[(row - 1) * VGA_WIDTH + col] = vga_buffer[row * VGA_WIDTH + col];
-        }
-    }
+    // تمرير الشاشة لأعلى - نسخ كل الأسطر سطراً واحداً للأعلى دفعة واحدة
+    memmove(vga_buffer, vga_buffer + VGA_WIDTH, (VGA_HEIGHT - 1) * VGA_WIDTH * sizeof(uint16_t));
     
     // مسح السطر الأخير
     for (int col = 0; col < VGA_WIDTH; col++) {
@@ -82,12 +92,16 @@ void print_number(uint32_t num) {
     }
 }
 
-// دالة طباعة نص
+// دالة طباعة نص (دفعة واحدة فلا تتداخل أسطر المعالجات)
 void print_string(const char* str) {
+    uint32_t flags = irq_save();
+    
     while (*str) {
         print_char(*str);
         str++;
     }
+    
+    irq_restore(flags);
 }
 
 // مهمة تجريبية بسيطة
@@ -109,26 +123,46 @@ void kernel_main() {
     print_string("[KERNEL] بدء تشغيل النواة...\n");
     print_string("[KERNEL] مرحباً بك في نظام التشغيل البسيط!\n\n");
     
+    // GDT النواة ومقطع gs لبيانات المعالج (current_task و this_cpu تقرآن منه)
+    init_percpu();
+    
+    // اكتشاف ميزات المعالج (تحدد تطبيقات دوال الذاكرة)
+    init_cpu();
+    
+    // معايرة TSC مقابل PIT وقراءة وقت الحائط من RTC
+    init_clock();
+    
+    // قراءة MADT قبل الترقيم (جداول ACPI قد تقع خارج الذاكرة المربوطة)
+    init_acpi();
+    
     // تهيئة نظام المقاطعات
     print_string("[KERNEL] تهيئة نظام المقاطعات...\n");
     init_interrupts();
+    init_timers();
     
     // تهيئة مدير الذاكرة
     init_memory_manager();
+    init_slab_allocator();
+    
+    // تفعيل الترقيم (بعد مدير الذاكرة لأن الجداول تُخصص منه)
+    init_paging();
+    
+    // LAPIC و IOAPIC بدل 8259 (سجلاتهما تُربط في نافذة الأجهزة)
+    init_apic();
     
     // تهيئة نظام استدعاءات النظام
     init_syscalls();
     
+    // تهيئة مدير المهام (قبل المجدول لأنه ينشئ مهمة idle)
+    print_string("[KERNEL] تهيئة مدير المهام...\n");
+    init_task_manager();
+    
     // Initialize scheduler
     init_scheduler();
     
     // Start scheduler
     start_scheduler();
     
-    // تهيئة مدير المهام
-    print_string("[KERNEL] تهيئة مدير المهام...\n");
-    init_task_manager();
-    
     // إنشاء مهمة تجريبية
     print_string("[KERNEL] إنشاء مهمة تجريبية...\n");
     create_task("demo_task", (void*)demo_task);
@@ -162,6 +196,19 @@ void kernel_main() {
     kfree(ptr2);
     print_string("\nتم تحرير الكتلة الثانية\n");
     print_memory_info();
+    print_slab_info();
+    
+#ifdef CONFIG_BENCH
+    // اختبارات الأداء (make BENCH=1)
+    run_benchmarks();
+#endif
+    
+    // إقلاع المعالجات الإضافية بعد الاختبارات (بعضها يبدل المهام يدوياً على هذا المعالج)
+    smp_boot();
+    
+#ifdef CONFIG_BENCH
+    bench_smp_scaling();
+#endif
     
     // Initialize keyboard
     init_keyboard();
@@ -190,15 +237,41 @@ void kernel_main() {
     print_string("\n=== System Ready ===\n");
     print_string("All Linux 0.01 inspired features initialized!\n");
     print_string("[DEBUG] Entering main loop...\n");
+    print_string("Keys: m = memory map, p = heap profile, c = page coloring, t = timer stats, s = scheduler stats\n");
     
     // Keep system running
     while (1) {
         if (keyboard_has_input()) {
             char c = keyboard_getchar();
-            print_string("Input: ");
-            print_char(c);
-            print_string("\n");
+            // عرض حالة الذاكرة أثناء التشغيل
+            if (c == 'm') {
+                print_memory_map();
+                if (check_memory_integrity() == 0) {
+                    print_string("Memory integrity: OK\n");
+                }
+            } else if (c == 'p') {
+                print_heap_profile();
+            } else if (c == 't') {
+                print_timer_stats();
+            } else if (c == 's') {
+                print_scheduler_stats();
+                print_smp_info();
+            } else if (c == 'c') {
+                // تلوين صفحات المستخدم حسب L2
+                if (set_page_coloring(!page_coloring_enabled())) {
+                    print_string(page_coloring_enabled() ? "Page coloring: on\n" : "Page coloring: off\n");
+                } else {
+                    print_string("Page coloring: L2 geometry unknown\n");
+                }
+            } else {
+                print_string("Input: ");
+                print_char(c);
+                print_string("\n");
+            }
+        }
+        // وقت الخمول يُستغل لتحرير المهام المنتهية واسترجاع الذاكرة ثم لتصفير الصفحات مسبقاً
+        if (!reap_zombies() && !zone_reclaim() && !zero_pool_refill()) {
+            tick_nohz_idle(); // Halt until next interrupt (periodic tick stopped)
         }
-        asm volatile("hlt"); // Halt until next interrupt
     }
 }
\ No newline at end of file
@@ -9,6 +9,41 @@
 #define TRUE 1
 #define FALSE 0
 
+// أقصى عدد معالجات تدعمه النواة
+#define MAX_CPUS 8
+
+// مسح البتات: رقم أول بت مضبوط (الكلمة يجب ألا تكون صفراً)
+static inline uint32_t bit_scan_forward(uint32_t word) {
+    uint32_t index;
+    asm("bsfl %1, %0" : "=r" (index) : "rm" (word));
+    return index;
+}
+
+// مسح البتات: رقم أعلى بت مضبوط (الكلمة يجب ألا تكون صفراً)
+static inline uint32_t bit_scan_reverse(uint32_t word) {
+    uint32_t index;
+    asm("bsrl %1, %0" : "=r" (index) : "rm" (word));
+    return index;
+}
+
+// قراءة عداد الدورات (TSC)
+static inline uint64_t rdtsc(void) {
+    uint32_t lo, hi;
+    asm volatile("rdtsc" : "=a" (lo), "=d" (hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+// قسمة 64 بت على 32 بت بدون libgcc
+static inline uint64_t div_u64(uint64_t dividend, uint32_t divisor) {
+    uint32_t hi = (uint32_t)(dividend >> 32);
+    uint32_t lo = (uint32_t)dividend;
+    uint32_t q_hi = hi / divisor;
+    uint32_t q_lo, rem;
+    hi %= divisor;
+    asm("divl %4" : "=a" (q_lo), "=d" (rem) : "a" (lo), "d" (hi), "rm" (divisor));
+    return ((uint64_t)q_hi << 32) | q_lo;
+}
+
 // دوال الإدخال والإخراج
 void outb(uint16_t port, uint8_t value);
 uint8_t inb(uint16_t port);
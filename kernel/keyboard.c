@@ -103,9 +103,6 @@ void keyboard_interrupt_handler(interrupt_context_t* context) {
         keyboard_stats.total_keypresses++;
         handle_key_press(scancode);
     }
-    
-    // Send EOI to PIC
-    outb(0x20, 0x20);
 }
 
 /**
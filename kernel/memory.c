@@ -1,32 +1,214 @@
 #include "memory.h"
+#include "slab.h"
+#include "cpu.h"
+#include "interrupt.h"
+#include "heap_profile.h"
 #include "kernel.h"
 
 // متغيرات عامة لإدارة الذاكرة
 static memory_manager_t memory_manager;
 static memory_stats_t memory_stats;
+static zero_pool_t zero_pool;
+static color_cache_t color_cache;
 static uint8_t memory_initialized = 0;
 
+// خريطة E820 التي تركها boot.asm في الذاكرة المنخفضة
+const e820_map_t* boot_memory_map = (const e820_map_t*)E820_MAP_ADDR;
+
+// هل تُستخدم مسارات SSE2 لدوال الذاكرة؟ (تُحدد عند الإقلاع)
+static bool mem_use_sse2 = false;
+
+// كلمة 32 بت يُسمح بقراءتها من أي مخزن بايتات
+typedef uint32_t __attribute__((may_alias)) mem_word_t;
+
+static void buddy_init(void);
+static uint32_t zero_pool_shrink(uint32_t pages);
+static uint32_t color_cache_shrink(uint32_t pages);
+
+// الوصول إلى boundary tag الخلفي للكتلة
+static inline block_footer_t* block_footer(memory_block_t* block) {
+    return (block_footer_t*)((uint8_t*)block + BLOCK_HEADER_SIZE + block->size);
+}
+
+// الكتلة المجاورة فعلياً بعد هذه الكتلة
+static inline memory_block_t* next_phys_block(memory_block_t* block) {
+    return (memory_block_t*)((uint8_t*)block + BLOCK_OVERHEAD + block->size);
+}
+
+// boundary tag الخلفي للكتلة المجاورة فعلياً قبل هذه الكتلة
+static inline block_footer_t* prev_phys_footer(memory_block_t* block) {
+    return (block_footer_t*)((uint8_t*)block - BLOCK_FOOTER_SIZE);
+}
+
+// رأس الكتلة من عنوان الحمولة
+static inline memory_block_t* payload_to_block(void* ptr) {
+    return (memory_block_t*)((uint8_t*)ptr - BLOCK_HEADER_SIZE);
+}
+
+// كتابة boundary tags الأمامي والخلفي معاً
+static inline void set_block(memory_block_t* block, uint32_t size, uint32_t is_free) {
+    block_footer_t* footer;
+    
+    block->size = size;
+    block->is_free = is_free;
+    footer = block_footer(block);
+    footer->size = size;
+    footer->is_free = is_free;
+}
+
+// إضافة كتلة إلى رأس قائمة الكتل الحرة
+static void free_list_insert(memory_block_t* block) {
+    block->prev = NULL;
+    block->next = memory_manager.free_list;
+    if (memory_manager.free_list) {
+        memory_manager.free_list->prev = block;
+    }
+    memory_manager.free_list = block;
+}
+
+// إزالة كتلة من قائمة الكتل الحرة
+static void free_list_remove(memory_block_t* block) {
+    if (block->prev) {
+        block->prev->next = block->next;
+    } else {
+        memory_manager.free_list = block->next;
+    }
+    if (block->next) {
+        block->next->prev = block->prev;
+    }
+}
+
+// حجز بيانات الإطارات بعد منطقة kmalloc: page_t لكل إطار ثم bitmap والملخص
+static void setup_frame_metadata(uint32_t frame_count) {
+    uint32_t base = MEMORY_START + KERNEL_HEAP_SIZE;
+    uint32_t words = (frame_count + BITS_PER_WORD - 1) / BITS_PER_WORD;
+    uint32_t summary_words = (words + BITS_PER_WORD - 1) / BITS_PER_WORD;
+    uint32_t bitmap_addr = align_address(base + frame_count * sizeof(page_t), sizeof(uint32_t));
+    uint32_t summary_addr = bitmap_addr + words * sizeof(uint32_t);
+    
+    memory_manager.pages = (page_t*)base;
+    memory_manager.frame_bitmap = (uint32_t*)bitmap_addr;
+    memory_manager.frame_summary = (uint32_t*)summary_addr;
+    memory_manager.metadata_size = PAGE_ALIGN(summary_addr + summary_words * sizeof(uint32_t)) - base;
+}
+
+// قراءة خريطة E820 وحساب نهاية الذاكرة القابلة للاستخدام (0 إذا لم تتوفر)
+// الذاكرة فوق 4GB وفوق MEMORY_LIMIT لا يمكن ربطها مباشرة فتُتجاهل
+static uint32_t e820_memory_end(const e820_map_t* map) {
+    uint64_t end;
+    uint32_t i, top = 0;
+    
+    if (map->signature != E820_SIGNATURE || map->count == 0 || map->count > E820_MAX_ENTRIES) {
+        return 0;
+    }
+    
+    for (i = 0; i < map->count; i++) {
+        if (map->entries[i].type != E820_USABLE || map->entries[i].base >= MEMORY_LIMIT) {
+            continue;
+        }
+        end = map->entries[i].base + map->entries[i].length;
+        if (end > MEMORY_LIMIT) {
+            end = MEMORY_LIMIT;
+        }
+        if ((uint32_t)end > top) {
+            top = (uint32_t)end & ~(PAGE_SIZE - 1);
+        }
+    }
+    
+    return top > MEMORY_START ? top : 0;
+}
+
+// تحرير المناطق المتاحة من E820 (مع تقريب الحدود إلى داخل المنطقة)
+static void e820_mark_usable(const e820_map_t* map) {
+    uint64_t start, end;
+    uint32_t i;
+    
+    for (i = 0; i < map->count; i++) {
+        if (map->entries[i].type != E820_USABLE) {
+            continue;
+        }
+        start = map->entries[i].base;
+        end = start + map->entries[i].length;
+        if (start >= memory_manager.memory_end) {
+            continue;
+        }
+        if (end > memory_manager.memory_end) {
+            end = memory_manager.memory_end;
+        }
+        start = align_address((uint32_t)start, PAGE_SIZE);
+        end &= ~(uint64_t)(PAGE_SIZE - 1);
+        if (start < end) {
+            mark_memory_region((uint32_t)start, (uint32_t)end, PAGE_FREE);
+        }
+    }
+}
+
 // دالة تهيئة مدير الذاكرة
 void init_memory_manager(void) {
+    const e820_map_t* e820 = boot_memory_map;
     uint32_t i;
-    uint32_t page_addr;
+    uint32_t frame_count;
+    uint32_t overhead;
+    
+    // نهاية الذاكرة من BIOS، وإلا القيمة الافتراضية
+    memory_manager.memory_end = e820_memory_end(e820);
+    if (memory_manager.memory_end == 0) {
+        memory_manager.memory_end = MEMORY_END;
+        e820 = NULL;
+    }
+    frame_count = (memory_manager.memory_end - MEMORY_START) / PAGE_SIZE;
     
-    // تهيئة مدير الذاكرة
-    memory_manager.total_pages = MAX_PAGES;
-    memory_manager.free_pages = MAX_PAGES;
-    memory_manager.used_pages = 0;
+    // تهيئة مدير الذاكرة (كل الإطارات محجوزة حتى تُحرر المناطق المتاحة)
+    memory_manager.total_pages = frame_count;
+    memory_manager.free_pages = 0;
+    memory_manager.used_pages = frame_count;
     memory_manager.free_list = NULL;
-    memory_manager.total_memory = MEMORY_END - MEMORY_START;
+    memory_manager.total_memory = memory_manager.memory_end - MEMORY_START;
     memory_manager.free_memory = memory_manager.total_memory;
     
+    // اختيار تطبيقات دوال الذاكرة حسب المعالج
+    select_memory_routines();
+    
     // تهيئة مصفوفة الصفحات
-    page_addr = MEMORY_START;
-    for (i = 0; i < MAX_PAGES; i++) {
-        memory_manager.pages[i].address = page_addr;
-        memory_manager.pages[i].status = PAGE_FREE;
+    setup_frame_metadata(frame_count);
+    for (i = 0; i < frame_count; i++) {
+        memory_manager.pages[i].status = PAGE_RESERVED;
         memory_manager.pages[i].ref_count = 0;
-        page_addr += PAGE_SIZE;
+        memory_manager.pages[i].order = PAGE_ORDER_NONE;
+        memory_manager.pages[i].flags = 0;
+    }
+    
+    // تهيئة bitmap الإطارات ثم حجز كل شيء دفعة واحدة
+    frame_allocator_init(&memory_manager.frames, memory_manager.frame_bitmap,
+                         memory_manager.frame_summary, frame_count);
+    memset(memory_manager.frame_bitmap, 0, memory_manager.frames.word_count * sizeof(uint32_t));
+    memset(memory_manager.frame_summary, 0,
+           ((memory_manager.frames.word_count + BITS_PER_WORD - 1) / BITS_PER_WORD) * sizeof(uint32_t));
+    memory_manager.frames.free_frames = 0;
+    
+    // تحرير الذاكرة المتاحة فقط (الثقوب في E820 تبقى محجوزة)
+    if (e820) {
+        e820_mark_usable(e820);
+    } else {
+        mark_memory_region(MEMORY_START, memory_manager.memory_end, PAGE_FREE);
+    }
+    
+    // حجز صفحات منطقة kmalloc وبيانات الإطارات حتى لا يعطيها alloc_page
+    mark_memory_region(MEMORY_START, MEMORY_START + KERNEL_HEAP_SIZE + memory_manager.metadata_size,
+                       PAGE_RESERVED);
+    
+    // بناء قوائم buddy من الإطارات الحرة المتبقية، مقسمة على المناطق
+    buddy_init();
+    register_reclaim_hook(zero_pool_shrink);
+    
+    // ألوان الصفحات من هندسة L2 (التلوين نفسه معطل حتى set_page_coloring)
+    memset(&color_cache, 0, sizeof(color_cache));
+    color_cache.colors = cpu_info.cache_colors ? cpu_info.cache_colors : 1;
+    if (color_cache.colors > MAX_CACHE_COLORS) {
+        color_cache.colors = MAX_CACHE_COLORS;
     }
+    color_cache.order = bit_scan_reverse(color_cache.colors);
+    register_reclaim_hook(color_cache_shrink);
     
     // تهيئة الإحصائيات
     memory_stats.total_allocations = 0;
@@ -34,206 +216,1059 @@ void init_memory_manager(void) {
     memory_stats.current_allocated = 0;
     memory_stats.peak_allocated = 0;
     memory_stats.fragmentation = 0;
+    memory_stats.reclaim_runs = 0;
+    memory_stats.reclaimed_pages = 0;
     
-    // إنشاء كتلة حرة كبيرة في البداية
-    memory_block_t* initial_block = (memory_block_t*)MEMORY_START;
-    initial_block->address = MEMORY_START + sizeof(memory_block_t);
-    initial_block->size = memory_manager.total_memory - sizeof(memory_block_t);
-    initial_block->is_free = 1;
-    initial_block->next = NULL;
-    initial_block->prev = NULL;
-    memory_manager.free_list = initial_block;
+    // منطقة الكتل: حارس بداية (footer مستخدم) ثم كتلة حرة واحدة ثم حارس نهاية
+    // (header مستخدم بحجم صفر)، فلا يخرج فحص الجيران عن المنطقة أبداً
+    block_footer_t* prologue = (block_footer_t*)MEMORY_START;
+    prologue->size = 0;
+    prologue->is_free = 0;
+    
+    memory_block_t* initial_block = (memory_block_t*)(MEMORY_START + BLOCK_FOOTER_SIZE);
+    set_block(initial_block, KERNEL_HEAP_SIZE - BLOCK_FOOTER_SIZE - BLOCK_OVERHEAD - BLOCK_HEADER_SIZE, 1);
+    
+    memory_block_t* epilogue = next_phys_block(initial_block);
+    epilogue->size = 0;
+    epilogue->is_free = 0;
+    
+    memory_manager.free_list = NULL;
+    free_list_insert(initial_block);
     
     memory_initialized = 1;
     
     print_string("Memory Manager: تم تهيئة مدير الذاكرة\n");
     print_string("Total Memory: ");
     print_hex(memory_manager.total_memory);
-    print_string(" bytes\n");
+    print_string(" bytes");
+    print_string(e820 ? " (E820)\n" : " (default)\n");
+    
+    // نسبة بيانات الإطارات من الذاكرة بدقة 0.001%
+    overhead = (uint32_t)div_u64((uint64_t)memory_manager.metadata_size * 100000,
+                                 memory_manager.total_memory);
+    print_string("Frame metadata: ");
+    print_number(memory_manager.metadata_size / 1024);
+    print_string(" KB (");
+    print_number(overhead / 1000);
+    print_char('.');
+    print_char('0' + (overhead / 100) % 10);
+    print_char('0' + (overhead / 10) % 10);
+    print_char('0' + overhead % 10);
+    print_string("%)\n");
 }
 
-// دالة تخصيص الذاكرة (مشابهة لـ malloc)
-void* kmalloc(uint32_t size) {
+// التحقق من أن العنوان داخل منطقة الكتل المتغيرة
+static int is_heap_address(void* ptr) {
+    uint32_t address = (uint32_t)ptr;
+    return address >= MEMORY_START && address < MEMORY_START + KERNEL_HEAP_SIZE;
+}
+
+// تحديث الإحصائيات عند التخصيص
+static void account_alloc(uint32_t size) {
+    memory_stats.total_allocations++;
+    memory_stats.current_allocated += size;
+    if (memory_stats.current_allocated > memory_stats.peak_allocated) {
+        memory_stats.peak_allocated = memory_stats.current_allocated;
+    }
+    memory_manager.free_memory -= size;
+}
+
+// تحديث الإحصائيات عند التحرير
+static void account_free(uint32_t size) {
+    memory_stats.total_frees++;
+    memory_stats.current_allocated -= size;
+    memory_manager.free_memory += size;
+}
+
+// تحديث الإحصائيات عند تغيير حجم كتلة في مكانها
+static void account_resize(uint32_t old_size, uint32_t new_size) {
+    memory_stats.current_allocated = memory_stats.current_allocated - old_size + new_size;
+    if (memory_stats.current_allocated > memory_stats.peak_allocated) {
+        memory_stats.peak_allocated = memory_stats.current_allocated;
+    }
+    memory_manager.free_memory = memory_manager.free_memory + old_size - new_size;
+}
+
+// تخصيص كتلة متغيرة الحجم (first-fit على الكتل الحرة فقط) للطلبات الكبيرة
+static void* heap_alloc(uint32_t size) {
     memory_block_t* current;
-    memory_block_t* new_block;
+    memory_block_t* remainder;
     uint32_t aligned_size;
     
+    // محاذاة الحجم إلى 8 بايت
+    aligned_size = align_address(size, BLOCK_ALIGN);
+    if (aligned_size < BLOCK_MIN_PAYLOAD) {
+        aligned_size = BLOCK_MIN_PAYLOAD;
+    }
+    
+    // البحث عن كتلة حرة مناسبة
+    for (current = memory_manager.free_list; current != NULL; current = current->next) {
+        if (current->size < aligned_size) {
+            continue;
+        }
+        
+        free_list_remove(current);
+        
+        // إذا كان الباقي يتسع لكتلة، قسمها وأعد الباقي للقائمة
+        if (current->size >= aligned_size + BLOCK_OVERHEAD + BLOCK_MIN_PAYLOAD) {
+            uint32_t remainder_size = current->size - aligned_size - BLOCK_OVERHEAD;
+            set_block(current, aligned_size, 0);
+            remainder = next_phys_block(current);
+            set_block(remainder, remainder_size, 1);
+            free_list_insert(remainder);
+        } else {
+            set_block(current, current->size, 0);
+        }
+        
+        // تحديث الإحصائيات
+        account_alloc(current->size);
+        
+        return (uint8_t*)current + BLOCK_HEADER_SIZE;
+    }
+    
+    return NULL; // لا توجد ذاكرة كافية
+}
+
+#ifdef CONFIG_HEAP_PROFILE
+// الحجم الممنوح فعلياً لكتلة أعادها kmalloc (0 إذا لم تكن كذلك) - للمحلل فقط
+static uint32_t kmalloc_size(void* ptr) {
+    kmem_cache_t* cache;
+    memory_block_t* block;
+    
+    if (is_heap_address(ptr)) {
+        block = payload_to_block(ptr);
+        return block->is_free ? 0 : block->size;
+    }
+    
+    cache = kmem_cache_of(ptr);
+    if (cache == NULL || !(cache->flags & SLAB_KMALLOC)) {
+        return 0;
+    }
+    return cache->object_size;
+}
+#endif // CONFIG_HEAP_PROFILE
+
+// مسار التخصيص المشترك: الطلبات حتى KMALLOC_MAX_SIZE تُخدم من فئة حجمها،
+// والأكبر من الكتل المتغيرة. caller هو موقع الاستدعاء الذي يسجله المحلل
+static void* kmalloc_caller(uint32_t size, void* caller) {
+    kmem_cache_t* cache;
+    void* ptr = NULL;
+    uint32_t flags;
+    
     if (!memory_initialized || size == 0) {
         return NULL;
     }
     
-    // محاذاة الحجم إلى 4 بايت
-    aligned_size = align_address(size, 4);
+    // الكومة والإحصائيات مشتركة بين المعالجات
+    flags = irq_save();
+    
+    // قبل تهيئة slab تكون الفئات غير متاحة فيُستخدم مسار الكتل
+    cache = kmalloc_cache_for(size);
+    if (cache != NULL) {
+        ptr = kmem_cache_alloc(cache);
+        if (ptr != NULL) {
+            account_alloc(cache->object_size);
+        }
+    }
+    
+    if (ptr == NULL) {
+        ptr = heap_alloc(size);
+    }
+    
+    if (ptr != NULL) {
+        heap_profile_alloc(ptr, size, kmalloc_size(ptr), caller);
+    }
+#ifndef CONFIG_HEAP_PROFILE
+    (void)caller;           // لا يستخدمه إلا المحلل
+#endif
+    
+    irq_restore(flags);
+    return ptr;
+}
+
+// دالة تخصيص الذاكرة (مشابهة لـ malloc)
+void* kmalloc(uint32_t size) {
+    return kmalloc_caller(size, __builtin_return_address(0));
+}
+
+// تحرير كتلة متغيرة الحجم: الرأس بحساب العنوان والدمج مع الجارين في O(1)
+static void heap_free(void* ptr) {
+    memory_block_t* block = payload_to_block(ptr);
+    memory_block_t* next;
+    block_footer_t* prev_footer;
+    uint32_t size;
+    
+    // الكتلة محررة مسبقاً أو الرأس لا يطابق الذيل
+    if (block->is_free || block_footer(block)->size != block->size) {
+        return;
+    }
+    
+    // تحديث الإحصائيات
+    account_free(block->size);
+    size = block->size;
+    
+    // دمج الكتلة التالية فعلياً إذا كانت حرة
+    next = next_phys_block(block);
+    if (next->is_free) {
+        free_list_remove(next);
+        size += BLOCK_OVERHEAD + next->size;
+    }
+    
+    // دمج الكتلة السابقة فعلياً إذا كانت حرة
+    prev_footer = prev_phys_footer(block);
+    if (prev_footer->is_free) {
+        block = (memory_block_t*)((uint8_t*)prev_footer - prev_footer->size - BLOCK_HEADER_SIZE);
+        free_list_remove(block);
+        size += BLOCK_OVERHEAD + block->size;
+    }
+    
+    set_block(block, size, 1);
+    free_list_insert(block);
+}
+
+// تغيير حجم كتلة في مكانها: النمو داخل الكتلة التالية الحرة أو قص الذيل عند التصغير
+static int heap_resize_in_place(memory_block_t* block, uint32_t new_size) {
+    memory_block_t* next = next_phys_block(block);
+    memory_block_t* tail;
+    uint32_t old_size = block->size;
+    uint32_t available = old_size;
+    uint32_t aligned_size, tail_size;
+    
+    aligned_size = align_address(new_size, BLOCK_ALIGN);
+    if (aligned_size < BLOCK_MIN_PAYLOAD) {
+        aligned_size = BLOCK_MIN_PAYLOAD;
+    }
+    
+    if (aligned_size > old_size) {
+        if (!next->is_free || old_size + BLOCK_OVERHEAD + next->size < aligned_size) {
+            return 0; // لا مساحة حرة ملاصقة كافية
+        }
+        free_list_remove(next);
+        available = old_size + BLOCK_OVERHEAD + next->size;
+    }
+    
+    if (available >= aligned_size + BLOCK_OVERHEAD + BLOCK_MIN_PAYLOAD) {
+        tail_size = available - aligned_size - BLOCK_OVERHEAD;
+        set_block(block, aligned_size, 0);
+        tail = next_phys_block(block);
+        
+        // عند التصغير يُدمج الذيل مع الكتلة التالية إذا كانت حرة
+        if (aligned_size <= old_size && next->is_free) {
+            free_list_remove(next);
+            tail_size += BLOCK_OVERHEAD + next->size;
+        }
+        set_block(tail, tail_size, 1);
+        free_list_insert(tail);
+    } else {
+        set_block(block, available, 0);
+    }
+    
+    account_resize(old_size, block->size);
+    return 1;
+}
+
+// دالة تحرير الذاكرة (مشابهة لـ free)
+void kfree(void* ptr) {
+    kmem_cache_t* cache;
+    uint32_t flags;
+    
+    if (!memory_initialized || ptr == NULL) {
+        return;
+    }
+    
+    flags = irq_save();
+    heap_profile_free(ptr);
+    
+    if (is_heap_address(ptr)) {
+        heap_free(ptr);
+    } else {
+        cache = kmem_cache_of(ptr);
+        // غير ذلك ليس عنواناً أعاده kmalloc
+        if (cache != NULL && (cache->flags & SLAB_KMALLOC)) {
+            account_free(cache->object_size);
+            kmem_cache_free(cache, ptr);
+        }
+    }
+    
+    irq_restore(flags);
+}
+
+// دالة تخصيص ذاكرة مع التصفير (مشابهة لـ calloc)
+void* kcalloc(uint32_t count, uint32_t size) {
+    uint32_t total_size = count * size;
+    void* ptr = kmalloc_caller(total_size, __builtin_return_address(0));
+    
+    if (ptr != NULL) {
+        memset(ptr, 0, total_size);
+    }
+    
+    return ptr;
+}
+
+// دالة إعادة تخصيص الذاكرة (مشابهة لـ realloc)
+void* krealloc(void* ptr, uint32_t new_size) {
+    void* new_ptr;
+    memory_block_t* current;
+    kmem_cache_t* cache;
+    uint32_t old_size = 0;
+    uint32_t flags;
+    
+    if (ptr == NULL) {
+        return kmalloc_caller(new_size, __builtin_return_address(0));
+    }
+    
+    if (new_size == 0) {
+        kfree(ptr);
+        return NULL;
+    }
+    
+    // البحث عن حجم الكتلة الحالية، والتغيير في المكان يعدل قوائم الكومة المشتركة
+    flags = irq_save();
+    if (is_heap_address(ptr)) {
+        current = payload_to_block(ptr);
+        if (!current->is_free) {
+            if (heap_resize_in_place(current, new_size)) {
+                memory_stats.realloc_in_place++;
+                heap_profile_resize(ptr, new_size, current->size);
+                irq_restore(flags);
+                return ptr;
+            }
+            old_size = current->size;
+        }
+    } else {
+        cache = kmem_cache_of(ptr);
+        if (cache != NULL && (cache->flags & SLAB_KMALLOC)) {
+            old_size = cache->object_size;
+            
+            // الحجم الجديد في الفئة نفسها: لا حاجة للنسخ
+            if (kmalloc_cache_for(new_size) == cache) {
+                memory_stats.realloc_in_place++;
+                heap_profile_resize(ptr, new_size, old_size);
+                irq_restore(flags);
+                return ptr;
+            }
+        }
+    }
+    irq_restore(flags);
+    
+    // الحل الأخير: تخصيص جديد ونسخ
+    new_ptr = kmalloc_caller(new_size, __builtin_return_address(0));
+    if (new_ptr != NULL && old_size > 0) {
+        uint32_t copy_size = (old_size < new_size) ? old_size : new_size;
+        memcpy(new_ptr, ptr, copy_size);
+        kfree(ptr);
+        flags = irq_save();
+        memory_stats.realloc_copied++;
+        irq_restore(flags);
+    }
+    
+    return new_ptr;
+}
+
+// دالة تهيئة مخصص الإطارات
+void frame_allocator_init(frame_allocator_t* fa, uint32_t* bitmap, uint32_t* summary, uint32_t frame_count) {
+    uint32_t i;
+    uint32_t summary_words;
+    
+    fa->bitmap = bitmap;
+    fa->summary = summary;
+    fa->frame_count = frame_count;
+    fa->word_count = (frame_count + BITS_PER_WORD - 1) / BITS_PER_WORD;
+    fa->free_frames = frame_count;
+    fa->hint = 0;
+    
+    // كل الإطارات حرة، والبتات بعد آخر إطار تبقى صفراً
+    for (i = 0; i < fa->word_count; i++) {
+        bitmap[i] = 0xFFFFFFFF;
+    }
+    if (frame_count % BITS_PER_WORD) {
+        bitmap[fa->word_count - 1] = (1u << (frame_count % BITS_PER_WORD)) - 1;
+    }
+    
+    summary_words = (fa->word_count + BITS_PER_WORD - 1) / BITS_PER_WORD;
+    for (i = 0; i < summary_words; i++) {
+        summary[i] = 0xFFFFFFFF;
+    }
+    if (fa->word_count % BITS_PER_WORD) {
+        summary[summary_words - 1] = (1u << (fa->word_count % BITS_PER_WORD)) - 1;
+    }
+}
+
+// دالة تخصيص إطار: كلمة الملخص الأولى غير الصفرية ثم bsf مرتين
+uint32_t frame_alloc(frame_allocator_t* fa) {
+    uint32_t summary_words = (fa->word_count + BITS_PER_WORD - 1) / BITS_PER_WORD;
+    uint32_t s, word, bit;
+    
+    if (fa->free_frames == 0) {
+        return FRAME_NONE;
+    }
+    
+    // كل كلمات الملخص قبل hint صفرية، فالبحث يتقدم ولا يعود
+    for (s = fa->hint; s < summary_words; s++) {
+        if (fa->summary[s]) {
+            break;
+        }
+    }
+    if (s == summary_words) {
+        return FRAME_NONE;
+    }
+    fa->hint = s;
+    
+    word = s * BITS_PER_WORD + bit_scan_forward(fa->summary[s]);
+    bit = bit_scan_forward(fa->bitmap[word]);
+    
+    fa->bitmap[word] &= ~(1u << bit);
+    if (fa->bitmap[word] == 0) {
+        fa->summary[s] &= ~(1u << (word % BITS_PER_WORD));
+    }
+    fa->free_frames--;
+    
+    return word * BITS_PER_WORD + bit;
+}
+
+// دالة تحرير إطار
+void frame_free(frame_allocator_t* fa, uint32_t frame) {
+    uint32_t word = frame / BITS_PER_WORD;
+    uint32_t s = word / BITS_PER_WORD;
+    
+    if (frame >= fa->frame_count || frame_is_free(fa, frame)) {
+        return;
+    }
+    
+    fa->bitmap[word] |= 1u << (frame % BITS_PER_WORD);
+    fa->summary[s] |= 1u << (word % BITS_PER_WORD);
+    fa->free_frames++;
+    
+    if (s < fa->hint) {
+        fa->hint = s;
+    }
+}
+
+// دالة حجز إطار محدد (مثل منطقة kmalloc)
+void frame_reserve(frame_allocator_t* fa, uint32_t frame) {
+    uint32_t word = frame / BITS_PER_WORD;
+    
+    if (frame >= fa->frame_count || !frame_is_free(fa, frame)) {
+        return;
+    }
+    
+    fa->bitmap[word] &= ~(1u << (frame % BITS_PER_WORD));
+    if (fa->bitmap[word] == 0) {
+        fa->summary[word / BITS_PER_WORD] &= ~(1u << (word % BITS_PER_WORD));
+    }
+    fa->free_frames--;
+}
+
+// دالة فحص حالة إطار
+int frame_is_free(frame_allocator_t* fa, uint32_t frame) {
+    return (fa->bitmap[frame / BITS_PER_WORD] >> (frame % BITS_PER_WORD)) & 1;
+}
+
+// الكتلة الحرة هي ذاكرة الإطار نفسه
+static inline free_block_t* pfn_to_block(uint32_t pfn) {
+    return (free_block_t*)PFN_TO_ADDR(pfn);
+}
+
+// المنطقة التي يقع فيها الإطار
+static inline zone_t* pfn_zone(uint32_t pfn) {
+    if (pfn < memory_manager.zones[ZONE_NORMAL].start_pfn) {
+        return &memory_manager.zones[ZONE_DMA];
+    }
+    if (pfn < memory_manager.zones[ZONE_HIGH].start_pfn) {
+        return &memory_manager.zones[ZONE_NORMAL];
+    }
+    return &memory_manager.zones[ZONE_HIGH];
+}
+
+// رقم إطار حد منطقة (0 إذا كان الحد تحت MEMORY_START)
+static uint32_t zone_boundary_pfn(uint32_t address) {
+    if (address <= MEMORY_START) {
+        return 0;
+    }
+    if (address >= memory_manager.memory_end) {
+        return memory_manager.total_pages;
+    }
+    return ADDR_TO_PFN(address);
+}
+
+// إضافة كتلة حرة إلى قائمة رتبتها في منطقتها
+static void buddy_list_add(uint32_t pfn, uint32_t order) {
+    free_block_t* block = pfn_to_block(pfn);
+    zone_t* zone = pfn_zone(pfn);
+    free_area_t* area = &zone->free_area[order];
+    
+    memory_manager.pages[pfn].order = order;
+    block->prev = NULL;
+    block->next = area->head;
+    if (area->head) {
+        area->head->prev = block;
+    }
+    area->head = block;
+    area->count++;
+    zone->free_area_mask |= 1u << order;
+}
+
+// إزالة كتلة حرة من قائمة رتبتها
+static void buddy_list_del(uint32_t pfn) {
+    free_block_t* block = pfn_to_block(pfn);
+    page_t* page = &memory_manager.pages[pfn];
+    zone_t* zone = pfn_zone(pfn);
+    free_area_t* area = &zone->free_area[page->order];
+    
+    if (block->prev) {
+        block->prev->next = block->next;
+    } else {
+        area->head = block->next;
+    }
+    if (block->next) {
+        block->next->prev = block->prev;
+    }
+    area->count--;
+    if (area->head == NULL) {
+        zone->free_area_mask &= ~(1u << page->order);
+    }
+    
+    page->order = PAGE_ORDER_NONE;
+}
+
+// حدود المناطق وتصفير قوائمها
+static void zones_init(void) {
+    static const char* names[MAX_ZONES] = { "DMA", "Normal", "High" };
+    uint32_t bounds[MAX_ZONES + 1];
+    zone_t* zone;
+    uint32_t z;
+    
+    bounds[ZONE_DMA] = 0;
+    bounds[ZONE_NORMAL] = zone_boundary_pfn(ZONE_DMA_END);
+    bounds[ZONE_HIGH] = zone_boundary_pfn(ZONE_NORMAL_END);
+    bounds[MAX_ZONES] = memory_manager.total_pages;
+    
+    for (z = 0; z < MAX_ZONES; z++) {
+        zone = &memory_manager.zones[z];
+        memset(zone, 0, sizeof(zone_t));
+        zone->name = names[z];
+        zone->start_pfn = bounds[z];
+        zone->end_pfn = bounds[z + 1];
+    }
+    
+    memory_manager.reclaim_hook_count = 0;
+    memory_manager.reclaim_pending = false;
+}
+
+// العلامات المائية من حجم كل منطقة (مثل min_free_kbytes في لينكس):
+// low و high أعلى من min بالربع والنصف
+static void zones_set_watermarks(void) {
+    zone_t* zone;
+    uint32_t z;
+    
+    for (z = 0; z < MAX_ZONES; z++) {
+        zone = &memory_manager.zones[z];
+        zone->present_pages = zone->free_pages;
+        if (zone->present_pages == 0) {
+            continue;
+        }
+        zone->watermark_min = zone->present_pages / ZONE_MIN_RATIO;
+        if (zone->watermark_min < ZONE_MIN_PAGES) {
+            zone->watermark_min = ZONE_MIN_PAGES;
+        }
+        zone->watermark_low = zone->watermark_min + zone->watermark_min / 4;
+        zone->watermark_high = zone->watermark_min + zone->watermark_min / 2;
+    }
+    
+    // حجز DMA للأجهزة، بحد أقصى ربع المنطقة حتى لا تختنق الأنظمة الصغيرة
+    zone = &memory_manager.zones[ZONE_DMA];
+    zone->lowmem_reserve = ZONE_DMA_RESERVE;
+    if (zone->lowmem_reserve > zone->present_pages / 4) {
+        zone->lowmem_reserve = zone->present_pages / 4;
+    }
+}
+
+// بناء قوائم buddy: كل مجموعة إطارات حرة تُقسم إلى أكبر كتل محاذاة ممكنة
+// لا تعبر كتلة حدود منطقتها. bitmap الإطارات مصدرها هنا فقط: بعدها تملك قوائم
+// buddy الصفحات ولا يُحدّث الـ bitmap عند كل تخصيص وتحرير
+static void buddy_init(void) {
+    uint32_t pfn = 0;
+    uint32_t order, i;
+    zone_t* zone;
+    
+    zones_init();
+    
+    while (pfn < memory_manager.total_pages) {
+        if (!frame_is_free(&memory_manager.frames, pfn)) {
+            pfn++;
+            continue;
+        }
+        zone = pfn_zone(pfn);
+        
+        for (order = BUDDY_MAX_ORDER - 1; order > 0; order--) {
+            if ((pfn & ((1u << order) - 1)) != 0 || pfn + (1u << order) > zone->end_pfn) {
+                continue;
+            }
+            for (i = 1; i < (1u << order); i++) {
+                if (!frame_is_free(&memory_manager.frames, pfn + i)) {
+                    break;
+                }
+            }
+            if (i == (1u << order)) {
+                break;
+            }
+        }
+        
+        buddy_list_add(pfn, order);
+        zone->free_pages += 1u << order;
+        pfn += 1u << order;
+    }
+    
+    zones_set_watermarks();
+}
+
+// هل يمكن أخذ 2^order صفحة من المنطقة مع إبقاء mark صفحة حرة؟
+static inline bool zone_watermark_ok(zone_t* zone, uint32_t order, uint32_t mark) {
+    return zone->free_pages >= (1u << order) + mark &&
+           (zone->free_area_mask & ~((1u << order) - 1)) != 0;
+}
+
+// طلب الاسترجاع في الخلفية (تنفذه حلقة الخمول عبر zone_reclaim)
+static void wake_reclaim(zone_t* zone) {
+    if (!memory_manager.reclaim_pending) {
+        zone->low_events++;
+        memory_manager.reclaim_pending = true;
+    }
+}
+
+// تخصيص كتلة من منطقة محددة: أصغر رتبة متاحة ثم تقسيمها
+static void* zone_alloc(zone_t* zone, uint32_t order) {
+    uint32_t available = zone->free_area_mask & ~((1u << order) - 1);
+    uint32_t current, pfn;
+    page_t* page;
+    
+    if (available == 0) {
+        return NULL;
+    }
+    current = bit_scan_forward(available);
+    
+    pfn = ADDR_TO_PFN(zone->free_area[current].head);
+    buddy_list_del(pfn);
+    page = &memory_manager.pages[pfn];
+    
+    // تقسيم الكتلة وإعادة النصف العلوي إلى قائمته في كل خطوة
+    while (current > order) {
+        current--;
+        buddy_list_add(pfn + (1u << current), current);
+    }
+    
+    // حالة الكتلة في صفحة رأسها فقط (status و order)، فالتخصيص O(log n) لا O(2^order)
+    page->status = PAGE_USED;
+    page->order = order;
+    page->ref_count = 1;
+    
+    zone->free_pages -= 1u << order;
+    zone->allocs++;
+    memory_manager.free_pages -= 1u << order;
+    memory_manager.used_pages += 1u << order;
+    
+    if (zone->free_pages < zone->watermark_low) {
+        wake_reclaim(zone);
+    }
+    
+    return (void*)PFN_TO_ADDR(pfn);
+}
+
+// اختيار المنطقة وتخصيص 2^order صفحة منها (يُستدعى تحت irq_save)
+// المرور الأول يحترم low، وإذا فشل يُطلب الاسترجاع ويُسمح بالنزول حتى min
+// التراجع إلى منطقة أدنى يترك lowmem_reserve لطلباتها هي
+static void* buddy_alloc(uint32_t order, uint32_t gfp) {
+    zone_t* zone;
+    uint32_t mark, pass;
+    int preferred, z;
+    void* block;
+    
+    if (order >= BUDDY_MAX_ORDER) {
+        return NULL;
+    }
+    
+    if (gfp & GFP_DMA) {
+        preferred = ZONE_DMA;
+    } else if (gfp & GFP_HIGHUSER) {
+        preferred = ZONE_HIGH;
+    } else {
+        preferred = ZONE_NORMAL;
+    }
+    
+    for (pass = 0; pass < ((gfp & GFP_NORETRY) ? 1 : 2); pass++) {
+        for (z = preferred; z >= ZONE_DMA; z--) {
+            zone = &memory_manager.zones[z];
+            if (pass == 0) {
+                mark = zone->watermark_low;
+            } else {
+                mark = (gfp & GFP_ATOMIC) ? zone->watermark_min / 2 : zone->watermark_min;
+            }
+            if (z != preferred) {
+                mark += zone->lowmem_reserve;
+            }
+            if (!zone_watermark_ok(zone, order, mark)) {
+                continue;
+            }
+            
+            block = zone_alloc(zone, order);
+            if (z != preferred) {
+                zone->fallbacks++;
+            }
+            return block;
+        }
+        if (!(gfp & GFP_NORETRY)) {
+            wake_reclaim(&memory_manager.zones[preferred]);
+        }
+    }
+    
+    return NULL; // لا توجد كتلة حرة كافية
+}
+
+// دالة تخصيص 2^order صفحة متجاورة من المنطقة المفضلة حسب gfp أو ما تحتها
+// قوائم buddy مشتركة بين المعالجات (مكدسات المهام، مهام الخمول، تحرير المهام)
+void* alloc_pages_gfp(uint32_t order, uint32_t gfp) {
+    uint32_t flags = irq_save();
+    void* block = buddy_alloc(order, gfp);
+    
+    irq_restore(flags);
+    return block;
+}
+
+// دالة تخصيص 2^order صفحة متجاورة للنواة
+void* alloc_pages(uint32_t order) {
+    return alloc_pages_gfp(order, GFP_KERNEL);
+}
+
+// تحرير كتلة ودمجها مع buddy الحر داخل منطقتها (يُستدعى تحت irq_save)
+static void buddy_free(void* addr, uint32_t order) {
+    uint32_t address = (uint32_t)addr;
+    page_t* page = get_page_info(addr);
+    page_t* buddy;
+    zone_t* zone;
+    uint32_t pfn, buddy_pfn;
+    
+    if (page == NULL || (address & (PAGE_SIZE - 1)) != 0) {
+        return;
+    }
+    if (page->status != PAGE_USED || page->order != order) {
+        return; // ليست رأس كتلة مخصصة بهذه الرتبة
+    }
+    
+    page->ref_count--;
+    if (page->ref_count > 0) {
+        return;
+    }
+    
+    pfn = ADDR_TO_PFN(address);
+    zone = pfn_zone(pfn);
+    page->status = PAGE_FREE;
+    page->order = PAGE_ORDER_NONE;
+    
+    zone->free_pages += 1u << order;
+    memory_manager.free_pages += 1u << order;
+    memory_manager.used_pages -= 1u << order;
+    
+    // الدمج: buddy حر بنفس الرتبة إذا كان رأس كتلة حرة بهذه الرتبة في المنطقة نفسها
+    while (order < BUDDY_MAX_ORDER - 1) {
+        buddy_pfn = pfn ^ (1u << order);
+        if (buddy_pfn < zone->start_pfn || buddy_pfn + (1u << order) > zone->end_pfn) {
+            break;
+        }
+        buddy = &memory_manager.pages[buddy_pfn];
+        if (buddy->status != PAGE_FREE || buddy->order != order) {
+            break;
+        }
+        buddy_list_del(buddy_pfn);
+        pfn &= ~(1u << order);
+        order++;
+    }
+    
+    buddy_list_add(pfn, order);
+}
+
+// دالة تحرير كتلة أعادها alloc_pages (أو إنقاص مرجعها إن كانت مشتركة)
+void free_pages(void* addr, uint32_t order) {
+    uint32_t flags = irq_save();
+    
+    buddy_free(addr, order);
+    irq_restore(flags);
+}
+
+// دالة تخصيص صفحة
+void* alloc_page(void) {
+    return alloc_pages(0);
+}
+
+// دالة تحرير صفحة (أو الكتلة التي تبدأ بها)
+// الرتبة تُقرأ تحت القفل نفسه حتى لا يغيرها تحرير على معالج آخر
+void free_page(void* page_addr) {
+    uint32_t flags = irq_save();
+    page_t* page = get_page_info(page_addr);
+    
+    if (page != NULL && page->status == PAGE_USED) {
+        buddy_free(page_addr, page->order);
+    }
+    irq_restore(flags);
+}
+
+// دالة تخصيص صفحة مصفرة: من المخزون أولاً، وإلا تصفير فوري
+void* alloc_zeroed_page(void) {
+    uint32_t flags = irq_save();
+    void* page = NULL;
+    
+    if (zero_pool.count > 0) {
+        page = zero_pool.pages[--zero_pool.count];
+        zero_pool.hits++;
+    } else {
+        zero_pool.misses++;
+    }
+    irq_restore(flags);
     
-    // البحث عن كتلة حرة مناسبة
-    current = memory_manager.free_list;
-    while (current != NULL) {
-        if (current->is_free && current->size >= aligned_size) {
-            // إذا كانت الكتلة أكبر من المطلوب، قسمها
-            if (current->size > aligned_size + sizeof(memory_block_t)) {
-                new_block = (memory_block_t*)(current->address + aligned_size);
-                new_block->address = current->address + aligned_size + sizeof(memory_block_t);
-                new_block->size = current->size - aligned_size - sizeof(memory_block_t);
-                new_block->is_free = 1;
-                new_block->next = current->next;
-                new_block->prev = current;
-                
-                if (current->next) {
-                    current->next->prev = new_block;
-                }
-                current->next = new_block;
-                current->size = aligned_size;
-            }
-            
-            current->is_free = 0;
-            
-            // تحديث الإحصائيات
-            memory_stats.total_allocations++;
-            memory_stats.current_allocated += current->size;
-            if (memory_stats.current_allocated > memory_stats.peak_allocated) {
-                memory_stats.peak_allocated = memory_stats.current_allocated;
-            }
-            memory_manager.free_memory -= current->size;
-            
-            return (void*)current->address;
+    if (page == NULL) {
+        page = alloc_page();
+        if (page != NULL) {
+            memset(page, 0, PAGE_SIZE);
         }
-        current = current->next;
     }
     
-    return NULL; // لا توجد ذاكرة كافية
+    return page;
 }
 
-// دالة تحرير الذاكرة (مشابهة لـ free)
-void kfree(void* ptr) {
-    memory_block_t* current;
-    memory_block_t* block_to_free = NULL;
+// خطوة واحدة لملء مخزون الصفحات المصفرة، تُستدعى من حلقة الخمول
+// تصفر ZERO_CHUNK_SIZE بايت فقط حتى لا تتأخر المقاطعات
+// تعيد false إذا كان المخزون ممتلئاً ولا يوجد عمل
+// لا يُملأ المخزون والذاكرة تحت low: صفحاته تخدم أخطاء المستخدم فتؤخذ من المنطقة العليا
+// مستدعٍ واحد في كل مرة (حلقة النواة ومهام الخمول على كل المعالجات): يحجز الصفحة
+// والإزاحة تحت irq_save، ويصفر بدونه، ثم ينشر النتيجة تحته
+bool zero_pool_refill(void) {
+    uint32_t flags = irq_save();
+    uint32_t offset;
+    uint8_t* page;
     
-    if (!memory_initialized || ptr == NULL) {
-        return;
+    if (zero_pool.fill_busy) {
+        irq_restore(flags);
+        return false;
     }
-    
-    // البحث عن الكتلة المراد تحريرها
-    current = memory_manager.free_list;
-    while (current != NULL) {
-        if (current->address == (uint32_t)ptr) {
-            block_to_free = current;
-            break;
-        }
-        current = current->next;
+    if (zero_pool.filling == NULL && zero_pool.count < ZERO_POOL_SIZE &&
+        !memory_manager.reclaim_pending) {
+        zero_pool.filling = alloc_pages_gfp(0, GFP_HIGHUSER | GFP_NORETRY);
+        zero_pool.fill_offset = 0;
     }
+    page = (uint8_t*)zero_pool.filling;
+    offset = zero_pool.fill_offset;
+    zero_pool.fill_busy = page != NULL;
+    irq_restore(flags);
     
-    if (block_to_free == NULL || block_to_free->is_free) {
-        return; // الكتلة غير موجودة أو محررة مسبقاً
+    if (page == NULL) {
+        return false;
     }
     
-    // تحرير الكتلة
-    block_to_free->is_free = 1;
+    memset(page + offset, 0, ZERO_CHUNK_SIZE);
     
-    // تحديث الإحصائيات
-    memory_stats.total_frees++;
-    memory_stats.current_allocated -= block_to_free->size;
-    memory_manager.free_memory += block_to_free->size;
+    flags = irq_save();
+    zero_pool.fill_offset = offset + ZERO_CHUNK_SIZE;
+    if (zero_pool.fill_offset == PAGE_SIZE) {
+        zero_pool.pages[zero_pool.count++] = page;
+        zero_pool.filling = NULL;
+    }
+    zero_pool.fill_busy = false;
+    irq_restore(flags);
     
-    // دمج الكتل المجاورة الحرة
-    compact_free_blocks();
+    return true;
 }
 
-// دالة تخصيص ذاكرة مع التصفير (مشابهة لـ calloc)
-void* kcalloc(uint32_t count, uint32_t size) {
-    uint32_t total_size = count * size;
-    void* ptr = kmalloc(total_size);
+// دالة استرجاع: إعادة صفحات المخزون المصفر إلى buddy
+static uint32_t zero_pool_shrink(uint32_t pages) {
+    uint32_t flags = irq_save();
+    uint32_t freed = 0;
     
-    if (ptr != NULL) {
-        memset(ptr, 0, total_size);
+    while (freed < pages && zero_pool.count > 0) {
+        free_page(zero_pool.pages[--zero_pool.count]);
+        freed++;
     }
+    irq_restore(flags);
     
-    return ptr;
+    return freed;
 }
 
-// دالة إعادة تخصيص الذاكرة (مشابهة لـ realloc)
-void* krealloc(void* ptr, uint32_t new_size) {
-    void* new_ptr;
-    memory_block_t* current;
-    uint32_t old_size = 0;
+// دالة حساب لون صفحة في L2
+uint32_t page_color(void* page) {
+    return ((uint32_t)page >> PAGE_SHIFT) & (color_cache.colors - 1);
+}
+
+// أخذ كتلة تغطي كل الألوان من buddy وتقسيمها إلى صفحات مفردة في قوائم ألوانها
+static bool color_cache_refill(void) {
+    uint8_t* block = alloc_pages_gfp(color_cache.order, GFP_HIGHUSER);
+    page_t* page;
+    uint32_t i, color;
     
-    if (ptr == NULL) {
-        return kmalloc(new_size);
+    if (block == NULL) {
+        return false;
     }
     
-    if (new_size == 0) {
-        kfree(ptr);
-        return NULL;
+    for (i = 0; i < color_cache.colors; i++) {
+        page = get_page_info(block + i * PAGE_SIZE);
+        page->status = PAGE_USED;   // كل صفحة تُحرر وحدها إلى buddy
+        page->order = 0;
+        page->ref_count = 1;
+        
+        color = page_color(block + i * PAGE_SIZE);
+        ((free_block_t*)(block + i * PAGE_SIZE))->next = color_cache.lists[color];
+        color_cache.lists[color] = (free_block_t*)(block + i * PAGE_SIZE);
+        color_cache.counts[color]++;
     }
     
-    // البحث عن حجم الكتلة الحالية
-    current = memory_manager.free_list;
-    while (current != NULL) {
-        if (current->address == (uint32_t)ptr) {
-            old_size = current->size;
-            break;
-        }
-        current = current->next;
-    }
+    color_cache.cached += color_cache.colors;
+    color_cache.refills++;
+    return true;
+}
+
+// دالة تخصيص صفحة بلون محدد (أي لون إذا تعذر)
+// المهام تمرر عداداً متزايداً فتأخذ صفحاتها المتتالية ألواناً متتالية
+void* alloc_page_color(uint32_t color) {
+    uint32_t flags = irq_save();
+    free_block_t* page;
     
-    new_ptr = kmalloc(new_size);
-    if (new_ptr != NULL && old_size > 0) {
-        uint32_t copy_size = (old_size < new_size) ? old_size : new_size;
-        memcpy(new_ptr, ptr, copy_size);
-        kfree(ptr);
+    color &= color_cache.colors - 1;
+    if (color_cache.lists[color] == NULL && !color_cache_refill()) {
+        color_cache.misses++;
+        irq_restore(flags);
+        return alloc_pages_gfp(0, GFP_HIGHUSER);
     }
     
-    return new_ptr;
+    page = color_cache.lists[color];
+    color_cache.lists[color] = page->next;
+    color_cache.counts[color]--;
+    color_cache.cached--;
+    irq_restore(flags);
+    
+    return page;
 }
 
-// دالة تخصيص صفحة
-void* alloc_page(void) {
-    uint32_t i;
+// دالة استرجاع: إعادة صفحات قوائم الألوان إلى buddy
+static uint32_t color_cache_shrink(uint32_t pages) {
+    uint32_t flags = irq_save();
+    uint32_t freed = 0;
+    uint32_t color;
+    free_block_t* page;
     
-    for (i = 0; i < MAX_PAGES; i++) {
-        if (memory_manager.pages[i].status == PAGE_FREE) {
-            memory_manager.pages[i].status = PAGE_USED;
-            memory_manager.pages[i].ref_count = 1;
-            memory_manager.free_pages--;
-            memory_manager.used_pages++;
-            return (void*)memory_manager.pages[i].address;
+    for (color = 0; color < color_cache.colors && freed < pages; color++) {
+        while (color_cache.lists[color] != NULL && freed < pages) {
+            page = color_cache.lists[color];
+            color_cache.lists[color] = page->next;
+            color_cache.counts[color]--;
+            color_cache.cached--;
+            free_page(page);
+            freed++;
         }
     }
+    irq_restore(flags);
     
-    return NULL; // لا توجد صفحات حرة
+    return freed;
 }
 
-// دالة تحرير صفحة
-void free_page(void* page_addr) {
-    uint32_t i;
-    uint32_t addr = (uint32_t)page_addr;
-    
-    for (i = 0; i < MAX_PAGES; i++) {
-        if (memory_manager.pages[i].address == addr) {
-            if (memory_manager.pages[i].status == PAGE_USED) {
-                memory_manager.pages[i].ref_count--;
-                if (memory_manager.pages[i].ref_count == 0) {
-                    memory_manager.pages[i].status = PAGE_FREE;
-                    memory_manager.free_pages++;
-                    memory_manager.used_pages--;
-                }
-            }
-            return;
+// دالة تفعيل أو تعطيل تلوين صفحات المستخدم
+// لا أثر له إذا كان L2 بلون واحد، وعند التعطيل تعود الصفحات المحجوزة إلى buddy
+bool set_page_coloring(bool enabled) {
+    if (enabled && color_cache.colors < 2) {
+        return false;
+    }
+    color_cache.enabled = enabled;
+    if (!enabled) {
+        color_cache_shrink(color_cache.cached);
+    }
+    return true;
+}
+
+// دالة فحص حالة التلوين
+bool page_coloring_enabled(void) {
+    return color_cache.enabled;
+}
+
+// دالة الحصول على منطقة
+zone_t* get_zone(uint32_t zone) {
+    return zone < MAX_ZONES ? &memory_manager.zones[zone] : NULL;
+}
+
+// دالة تسجيل دالة استرجاع تُستدعى عند نزول منطقة تحت low
+bool register_reclaim_hook(reclaim_hook_t hook) {
+    if (hook == NULL || memory_manager.reclaim_hook_count >= MAX_RECLAIM_HOOKS) {
+        return false;
+    }
+    memory_manager.reclaim_hooks[memory_manager.reclaim_hook_count++] = hook;
+    return true;
+}
+
+// دالة الاسترجاع في الخلفية، تُستدعى من حلقة الخمول
+// تستدعي دوال الاسترجاع حتى تعود كل منطقة إلى high أو لا يبقى ما يُحرر
+// تعيد false إذا لم يكن هناك طلب استرجاع
+bool zone_reclaim(void) {
+    uint32_t needed = 0;
+    uint32_t freed = 0;
+    uint32_t i, z;
+    zone_t* zone;
+    
+    if (!memory_manager.reclaim_pending) {
+        return false;
+    }
+    
+    for (z = 0; z < MAX_ZONES; z++) {
+        zone = &memory_manager.zones[z];
+        if (zone->free_pages < zone->watermark_high) {
+            needed += zone->watermark_high - zone->free_pages;
         }
     }
+    
+    for (i = 0; i < memory_manager.reclaim_hook_count && freed < needed; i++) {
+        freed += memory_manager.reclaim_hooks[i](needed - freed);
+    }
+    
+    memory_stats.reclaim_runs++;
+    memory_stats.reclaimed_pages += freed;
+    
+    // الطلب يُمسح دائماً: إذا بقيت منطقة تحت low فالتخصيص التالي منها يطلبه من جديد
+    memory_manager.reclaim_pending = false;
+    return true;
 }
 
-// دالة الحصول على معلومات الصفحة
+// دالة الحصول على معلومات الصفحة (فهرسة مباشرة بالـ PFN)
 page_t* get_page_info(void* addr) {
-    uint32_t i;
-    uint32_t page_addr = (uint32_t)addr & ~(PAGE_SIZE - 1);
+    uint32_t address = (uint32_t)addr;
     
-    for (i = 0; i < MAX_PAGES; i++) {
-        if (memory_manager.pages[i].address == page_addr) {
-            return &memory_manager.pages[i];
-        }
+    if (address < MEMORY_START || address >= memory_manager.memory_end) {
+        return NULL;
     }
     
-    return NULL;
+    return &memory_manager.pages[ADDR_TO_PFN(address)];
+}
+
+// دالة تعليم منطقة من الذاكرة بحالة معينة
+// تُستدعى أثناء التهيئة فقط، قبل بناء قوائم buddy
+void mark_memory_region(uint32_t start, uint32_t end, uint8_t status) {
+    uint32_t addr;
+    page_t* page;
+    
+    start &= ~(PAGE_SIZE - 1);
+    end = align_address(end, PAGE_SIZE);
+    if (start < MEMORY_START) start = MEMORY_START;
+    if (end > memory_manager.memory_end) end = memory_manager.memory_end;
+    
+    for (addr = start; addr < end; addr += PAGE_SIZE) {
+        page = &memory_manager.pages[ADDR_TO_PFN(addr)];
+        
+        if (status == PAGE_FREE && page->status != PAGE_FREE) {
+            frame_free(&memory_manager.frames, ADDR_TO_PFN(addr));
+            memory_manager.free_pages++;
+            memory_manager.used_pages--;
+        } else if (status != PAGE_FREE && page->status == PAGE_FREE) {
+            frame_reserve(&memory_manager.frames, ADDR_TO_PFN(addr));
+            memory_manager.free_pages--;
+            memory_manager.used_pages++;
+        }
+        
+        page->status = status;
+        page->ref_count = (status == PAGE_USED) ? 1 : 0;
+    }
 }
 
 // دالة الحصول على عدد الصفحات الحرة
@@ -241,6 +1276,11 @@ uint32_t get_free_pages_count(void) {
     return memory_manager.free_pages;
 }
 
+// دالة الحصول على نهاية الذاكرة المكتشفة
+uint32_t get_memory_end(void) {
+    return memory_manager.memory_end;
+}
+
 // دالة طباعة معلومات الذاكرة
 void print_memory_info(void) {
     print_string("\n=== Memory Information ===\n");
@@ -275,31 +1315,328 @@ void print_memory_info(void) {
     print_string("Frees: ");
     print_hex(memory_stats.total_frees);
     print_string("\n");
+    
+    print_string("Realloc in-place/copied: ");
+    print_number(memory_stats.realloc_in_place);
+    print_string("/");
+    print_number(memory_stats.realloc_copied);
+    print_string("\n");
+    
+    print_string("Zero pool: ");
+    print_number(zero_pool.count);
+    print_string(" pages, hits/misses: ");
+    print_number(zero_pool.hits);
+    print_string("/");
+    print_number(zero_pool.misses);
+    print_string("\n");
+    
+    memory_stats_t* stats = get_memory_stats();
+    print_string("Free blocks per order:");
+    for (uint32_t order = 0; order < BUDDY_MAX_ORDER; order++) {
+        print_string(" ");
+        print_number(stats->free_blocks[order]);
+    }
+    print_string("\n");
+    
+    for (uint32_t z = 0; z < MAX_ZONES; z++) {
+        zone_t* zone = &memory_manager.zones[z];
+        if (zone->present_pages == 0) {
+            continue;
+        }
+        print_string("Zone ");
+        print_string(zone->name);
+        print_string(": free ");
+        print_number(zone->free_pages);
+        print_string("/");
+        print_number(zone->present_pages);
+        print_string(" pages, min/low/high ");
+        print_number(zone->watermark_min);
+        print_string("/");
+        print_number(zone->watermark_low);
+        print_string("/");
+        print_number(zone->watermark_high);
+        print_string(", fallbacks ");
+        print_number(zone->fallbacks);
+        print_string("\n");
+    }
+    
+    print_string("Page coloring: ");
+    print_string(color_cache.enabled ? "on, " : "off, ");
+    print_number(color_cache.colors);
+    print_string(" colors, ");
+    print_number(color_cache.cached);
+    print_string(" cached pages, refills/misses ");
+    print_number(color_cache.refills);
+    print_string("/");
+    print_number(color_cache.misses);
+    print_string("\n");
+    
+    print_string("Reclaim runs/pages: ");
+    print_number(memory_stats.reclaim_runs);
+    print_string("/");
+    print_number(memory_stats.reclaimed_pages);
+    print_string("\n");
 }
 
 // دالة الحصول على الإحصائيات
 memory_stats_t* get_memory_stats(void) {
+    uint32_t order, z;
+    uint32_t free_total = 0;
+    uint32_t smaller = 0;
+    
+    memory_stats.zero_pool_pages = zero_pool.count;
+    memory_stats.zero_pool_hits = zero_pool.hits;
+    memory_stats.zero_pool_misses = zero_pool.misses;
+    
+    for (order = 0; order < BUDDY_MAX_ORDER; order++) {
+        memory_stats.free_blocks[order] = 0;
+        for (z = 0; z < MAX_ZONES; z++) {
+            memory_stats.free_blocks[order] += memory_manager.zones[z].free_area[order].count;
+        }
+        free_total += memory_stats.free_blocks[order] << order;
+    }
+    
+    // تجزئة الرتبة: نسبة الصفحات الحرة الموجودة في كتل أصغر منها
+    for (order = 0; order < BUDDY_MAX_ORDER; order++) {
+        memory_stats.order_fragmentation[order] = free_total ? (smaller * 100) / free_total : 0;
+        smaller += memory_stats.free_blocks[order] << order;
+    }
+    
+    calculate_fragmentation();
     return &memory_stats;
 }
 
-// دالة ضغط الكتل الحرة
-void compact_free_blocks(void) {
-    memory_block_t* current = memory_manager.free_list;
-    
-    while (current != NULL && current->next != NULL) {
-        if (current->is_free && current->next->is_free) {
-            // دمج الكتلتين إذا كانتا متجاورتين
-            if (current->address + current->size == current->next->address - sizeof(memory_block_t)) {
-                current->size += current->next->size + sizeof(memory_block_t);
-                memory_block_t* to_remove = current->next;
-                current->next = to_remove->next;
-                if (to_remove->next) {
-                    to_remove->next->prev = current;
+// دالة حساب التجزئة الخارجية لمنطقة الكتل المتغيرة (نسبة مئوية)
+// 1 - أكبر كتلة حرة / مجموع الذاكرة الحرة: صفر يعني أن كل الذاكرة الحرة متصلة
+uint32_t calculate_fragmentation(void) {
+    memory_block_t* block;
+    uint32_t flags = irq_save();
+    uint32_t free_total = 0;
+    uint32_t largest = 0;
+    
+    for (block = memory_manager.free_list; block != NULL; block = block->next) {
+        free_total += block->size;
+        if (block->size > largest) {
+            largest = block->size;
+        }
+    }
+    irq_restore(flags);
+    
+    memory_stats.fragmentation = free_total ? 100 - (uint32_t)div_u64((uint64_t)largest * 100, free_total) : 0;
+    return memory_stats.fragmentation;
+}
+
+// طباعة عدد 64 بت من خريطة E820 (الجزء العلوي فقط إذا لم يكن صفراً)
+static void print_e820_value(uint64_t value) {
+    if (value >> 32) {
+        print_hex((uint32_t)(value >> 32));
+        print_string(":");
+    }
+    print_hex((uint32_t)value);
+}
+
+// طباعة منطقة [start, end) مع اسمها
+static void print_region(const char* name, uint32_t start, uint32_t end) {
+    print_string("  ");
+    print_hex(start);
+    print_string(" - ");
+    print_hex(end);
+    print_string("  ");
+    print_string(name);
+    print_string("\n");
+}
+
+// دالة طباعة خريطة الذاكرة: E820 ثم مناطق المدير والمناطق وحالة التجزئة
+void print_memory_map(void) {
+    const e820_map_t* e820 = boot_memory_map;
+    uint32_t heap_end = MEMORY_START + KERNEL_HEAP_SIZE;
+    uint32_t largest_order = 0;
+    uint32_t free_blocks = 0;
+    memory_stats_t* stats;
+    memory_block_t* block;
+    uint32_t i;
+    
+    print_string("\n=== Memory Map ===\n");
+    if (e820->signature == E820_SIGNATURE) {
+        print_string("E820:\n");
+        for (i = 0; i < e820->count && i < E820_MAX_ENTRIES; i++) {
+            print_string("  ");
+            print_e820_value(e820->entries[i].base);
+            print_string(" len ");
+            print_e820_value(e820->entries[i].length);
+            print_string(e820->entries[i].type == E820_USABLE ? " usable\n" : " reserved\n");
+        }
+    } else {
+        print_string("E820: not available\n");
+    }
+    
+    print_string("Layout:\n");
+    print_region("kmalloc heap", MEMORY_START, heap_end);
+    print_region("frame metadata", heap_end, heap_end + memory_manager.metadata_size);
+    print_region("buddy pages", heap_end + memory_manager.metadata_size, memory_manager.memory_end);
+    for (i = 0; i < MAX_ZONES; i++) {
+        if (memory_manager.zones[i].start_pfn < memory_manager.zones[i].end_pfn) {
+            print_region(memory_manager.zones[i].name,
+                         PFN_TO_ADDR(memory_manager.zones[i].start_pfn),
+                         PFN_TO_ADDR(memory_manager.zones[i].end_pfn));
+        }
+    }
+    
+    for (block = memory_manager.free_list; block != NULL; block = block->next) {
+        free_blocks++;
+    }
+    print_string("Heap free blocks: ");
+    print_number(free_blocks);
+    print_string(", external fragmentation: ");
+    print_number(calculate_fragmentation());
+    print_string("%\n");
+    
+    // تجزئة buddy: نسبة الصفحات الحرة خارج أكبر كتلة حرة
+    stats = get_memory_stats();
+    for (i = 0; i < BUDDY_MAX_ORDER; i++) {
+        if (stats->free_blocks[i]) {
+            largest_order = i;
+        }
+    }
+    print_string("Buddy largest free order: ");
+    print_number(largest_order);
+    print_string(", free pages in smaller blocks: ");
+    print_number(stats->order_fragmentation[largest_order]);
+    print_string("%\n");
+}
+
+// تسجيل خطأ في فحص السلامة مع العنوان أو القيمة المخالفة
+static void integrity_error(const char* what, uint32_t value) {
+    print_string("[MEM] integrity: ");
+    print_string(what);
+    print_string(": ");
+    print_hex(value);
+    print_string("\n");
+}
+
+// دالة التحقق من سلامة هياكل الذاكرة - تعيد عدد الأخطاء
+// الكتل المتغيرة: تطابق boundary tags، لا كتلتين حرتين متجاورتين، القائمة تطابق الكتل
+// buddy: كل كتلة حرة محاذاة ورتبتها صحيحة وصفحاتها حرة، والعدادات تطابق القوائم
+uint32_t check_memory_integrity(void) {
+    memory_block_t* block = (memory_block_t*)(MEMORY_START + BLOCK_FOOTER_SIZE);
+    uint32_t heap_end = MEMORY_START + KERNEL_HEAP_SIZE;
+    uint32_t flags = irq_save();
+    uint32_t errors = 0;
+    uint32_t walked_free = 0;
+    uint32_t listed_free = 0;
+    uint32_t buddy_pages = 0;
+    bool prev_free = false;
+    memory_block_t* prev_block = NULL;
+    free_block_t* free_block;
+    free_block_t* prev_free_block;
+    free_area_t* area;
+    zone_t* zone;
+    uint32_t order, count, pfn, i, z, zone_pages;
+    
+    // مرور فعلي على الكتل من الحارس الأول حتى حارس النهاية
+    while (block->size != 0) {
+        if ((uint32_t)next_phys_block(block) >= heap_end) {
+            integrity_error("block overruns heap", (uint32_t)block);
+            errors++;
+            break;
+        }
+        if (block_footer(block)->size != block->size || block_footer(block)->is_free != block->is_free) {
+            integrity_error("header/footer mismatch", (uint32_t)block);
+            errors++;
+            break;
+        }
+        if (block->is_free) {
+            walked_free++;
+            if (prev_free) {
+                integrity_error("uncoalesced free blocks", (uint32_t)block);
+                errors++;
+            }
+        }
+        prev_free = block->is_free;
+        block = next_phys_block(block);
+    }
+    
+    // قائمة الكتل الحرة: كل عنصر حر وداخل المنطقة، والروابط متسقة
+    for (block = memory_manager.free_list; block != NULL; block = block->next) {
+        if (!is_heap_address(block) || !block->is_free || block->prev != prev_block) {
+            integrity_error("bad free list entry", (uint32_t)block);
+            errors++;
+            break;
+        }
+        if (++listed_free > walked_free) {
+            break; // حلقة أو كتل غير موجودة في المرور الفعلي
+        }
+        prev_block = block;
+    }
+    if (listed_free != walked_free) {
+        integrity_error("free list count differs from heap walk", listed_free);
+        errors++;
+    }
+    
+    // قوائم buddy لكل منطقة: الكتل داخل حدود منطقتها وعداداتها مطابقة
+    for (z = 0; z < MAX_ZONES; z++) {
+        zone = &memory_manager.zones[z];
+        zone_pages = 0;
+        for (order = 0; order < BUDDY_MAX_ORDER; order++) {
+            area = &zone->free_area[order];
+            count = 0;
+            prev_free_block = NULL;
+            for (free_block = area->head; free_block != NULL; free_block = free_block->next) {
+                pfn = ADDR_TO_PFN(free_block);
+                if (pfn < zone->start_pfn || pfn + (1u << order) > zone->end_pfn ||
+                    (pfn & ((1u << order) - 1)) != 0 ||
+                    memory_manager.pages[pfn].order != order || free_block->prev != prev_free_block) {
+                    integrity_error("bad buddy block", (uint32_t)free_block);
+                    errors++;
+                    break;
                 }
-                continue;
+                for (i = 0; i < (1u << order); i++) {
+                    if (memory_manager.pages[pfn + i].status != PAGE_FREE) {
+                        integrity_error("used page in free buddy block", PFN_TO_ADDR(pfn + i));
+                        errors++;
+                        break;
+                    }
+                }
+                if (++count > area->count) {
+                    break;
+                }
+                zone_pages += 1u << order;
+                prev_free_block = free_block;
+            }
+            if (count != area->count || ((zone->free_area_mask >> order) & 1) != (count != 0)) {
+                integrity_error("buddy order count mismatch", order);
+                errors++;
             }
         }
-        current = current->next;
+        if (zone_pages != zone->free_pages) {
+            integrity_error("zone free count differs from its lists", z);
+            errors++;
+        }
+        buddy_pages += zone_pages;
+    }
+    if (buddy_pages != memory_manager.free_pages) {
+        integrity_error("free page count differs from buddy lists", buddy_pages);
+        errors++;
+    }
+    
+    irq_restore(flags);
+    return errors;
+}
+
+// دالة ضغط الكتل الحرة
+// الدمج يحدث فوراً في kfree، لذا هذه مجرد مرورة تصحيحية على الكتل المتجاورة
+void compact_free_blocks(void) {
+    memory_block_t* current = (memory_block_t*)(MEMORY_START + BLOCK_FOOTER_SIZE);
+    memory_block_t* next;
+    
+    while (current->size != 0) {
+        next = next_phys_block(current);
+        if (current->is_free && next->is_free && next->size != 0) {
+            free_list_remove(next);
+            set_block(current, current->size + BLOCK_OVERHEAD + next->size, 1);
+            continue;
+        }
+        current = next;
     }
 }
 
@@ -311,7 +1648,7 @@ uint32_t align_address(uint32_t addr, uint32_t alignment) {
 // دالة التحقق من صحة العنوان
 int is_valid_address(void* addr) {
     uint32_t address = (uint32_t)addr;
-    return (address >= MEMORY_START && address < MEMORY_END);
+    return (address >= MEMORY_START && address < memory_manager.memory_end);
 }
 
 // دالة التحقق من عنوان النواة
@@ -320,8 +1657,105 @@ int is_kernel_address(void* addr) {
     return (address >= MEMORY_START && address < MEMORY_START + 0x100000); // أول 1MB للنواة
 }
 
+// دالة اختيار تطبيقات دوال الذاكرة: SSE2 إذا فعّله init_cpu وإلا rep movsd/stosd
+void select_memory_routines(void) {
+    mem_use_sse2 = cpu_info.sse_enabled;
+}
+
 // دوال الذاكرة الأساسية
 void* memset(void* ptr, int value, uint32_t size) {
+    if (mem_use_sse2 && size >= MEM_SSE2_THRESHOLD) {
+        return memset_sse2(ptr, value, size);
+    }
+    return memset_rep(ptr, value, size);
+}
+
+void* memcpy(void* dest, const void* src, uint32_t size) {
+    if (mem_use_sse2 && size >= MEM_SSE2_THRESHOLD) {
+        return memcpy_sse2(dest, src, size);
+    }
+    return memcpy_rep(dest, src, size);
+}
+
+// النسخ للأمام آمن إذا كان الهدف قبل المصدر، وإلا يُنسخ من النهاية
+void* memmove(void* dest, const void* src, uint32_t size) {
+    uint32_t d0, d1, d2;
+    
+    if ((uint32_t)dest <= (uint32_t)src || (uint32_t)dest >= (uint32_t)src + size) {
+        return memcpy(dest, src, size);
+    }
+    
+    asm volatile("std\n\t"
+                 "rep movsb\n\t"
+                 "cld"
+                 : "=&c" (d0), "=&D" (d1), "=&S" (d2)
+                 : "0" (size), "1" ((uint8_t*)dest + size - 1), "2" ((const uint8_t*)src + size - 1)
+                 : "memory");
+    return dest;
+}
+
+int memcmp(const void* ptr1, const void* ptr2, uint32_t size) {
+    return memcmp_words(ptr1, ptr2, size);
+}
+
+// طول النص: كلمة كاملة في كل دورة بعد المحاذاة
+// القراءة لا تتجاوز الكلمة المحاذاة التي فيها الصفر، فلا تعبر حدود الصفحة
+uint32_t strlen(const char* str) {
+    const char* p = str;
+    const mem_word_t* w;
+    uint32_t word;
+    
+    while ((uint32_t)p & 3) {
+        if (*p == '\0') {
+            return p - str;
+        }
+        p++;
+    }
+    
+    w = (const mem_word_t*)p;
+    for (;;) {
+        word = *w;
+        // بايت صفري داخل الكلمة
+        if ((word - 0x01010101) & ~word & 0x80808080) {
+            break;
+        }
+        w++;
+    }
+    
+    p = (const char*)w;
+    while (*p) {
+        p++;
+    }
+    return p - str;
+}
+
+uint32_t strnlen(const char* str, uint32_t max_len) {
+    uint32_t len = 0;
+    uint32_t word;
+    
+    while (len < max_len && ((uint32_t)(str + len) & 3)) {
+        if (str[len] == '\0') {
+            return len;
+        }
+        len++;
+    }
+    
+    while (len + 4 <= max_len) {
+        word = *(const mem_word_t*)(str + len);
+        if ((word - 0x01010101) & ~word & 0x80808080) {
+            break;
+        }
+        len += 4;
+    }
+    
+    while (len < max_len && str[len]) {
+        len++;
+    }
+    return len;
+}
+
+// التطبيق المرجعي: بايت في كل دورة
+void* memset_bytes(void* ptr, int value, uint32_t size) {
     uint8_t* p = (uint8_t*)ptr;
     uint32_t i;
     
@@ -332,7 +1766,7 @@ void* memset(void* ptr, int value, uint32_t size) {
     return ptr;
 }
 
-void* memcpy(void* dest, const void* src, uint32_t size) {
+void* memcpy_bytes(void* dest, const void* src, uint32_t size) {
     uint8_t* d = (uint8_t*)dest;
     const uint8_t* s = (const uint8_t*)src;
     uint32_t i;
@@ -344,7 +1778,7 @@ void* memcpy(void* dest, const void* src, uint32_t size) {
     return dest;
 }
 
-int memcmp(const void* ptr1, const void* ptr2, uint32_t size) {
+int memcmp_bytes(const void* ptr1, const void* ptr2, uint32_t size) {
     const uint8_t* p1 = (const uint8_t*)ptr1;
     const uint8_t* p2 = (const uint8_t*)ptr2;
     uint32_t i;
@@ -356,4 +1790,179 @@ int memcmp(const void* ptr1, const void* ptr2, uint32_t size) {
     }
     
     return 0;
-}
\ No newline at end of file
+}
+
+// rep stosd للكلمات ثم rep stosb للباقي
+void* memset_rep(void* ptr, int value, uint32_t size) {
+    uint32_t fill = (uint8_t)value * 0x01010101u;
+    uint32_t d0, d1;
+    
+    asm volatile("rep stosl\n\t"
+                 "movl %3, %%ecx\n\t"
+                 "andl $3, %%ecx\n\t"
+                 "rep stosb"
+                 : "=&c" (d0), "=&D" (d1)
+                 : "0" (size >> 2), "g" (size), "a" (fill), "1" (ptr)
+                 : "memory");
+    return ptr;
+}
+
+// rep movsd للكلمات ثم rep movsb للباقي
+void* memcpy_rep(void* dest, const void* src, uint32_t size) {
+    uint32_t d0, d1, d2;
+    
+    asm volatile("rep movsl\n\t"
+                 "movl %4, %%ecx\n\t"
+                 "andl $3, %%ecx\n\t"
+                 "rep movsb"
+                 : "=&c" (d0), "=&D" (d1), "=&S" (d2)
+                 : "0" (size >> 2), "g" (size), "1" (dest), "2" (src)
+                 : "memory");
+    return dest;
+}
+
+// مقارنة كلمة كاملة في كل دورة حتى أول كلمة مختلفة ثم بالبايت داخلها
+int memcmp_words(const void* ptr1, const void* ptr2, uint32_t size) {
+    const uint8_t* p1 = (const uint8_t*)ptr1;
+    const uint8_t* p2 = (const uint8_t*)ptr2;
+    
+    while (size > 0 && ((uint32_t)p1 & 3)) {
+        if (*p1 != *p2) {
+            return *p1 - *p2;
+        }
+        p1++;
+        p2++;
+        size--;
+    }
+    
+    while (size >= 4 && *(const mem_word_t*)p1 == *(const mem_word_t*)p2) {
+        p1 += 4;
+        p2 += 4;
+        size -= 4;
+    }
+    
+    return memcmp_bytes(p1, p2, size);
+}
+
+// كتل SSE2 بحجم 64 بايت لكل دورة، والمقاطعات معطلة أثناء استخدام XMM
+// (النواة لا تحفظ سجلات XMM عند المقاطعة). المترجم يبني بدون SSE فلا
+// يستخدم سجلات XMM بنفسه، لذا لا تُذكر في قائمة clobber.
+#define SSE2_CHUNK_BLOCKS 64        // 4KB ثم تُفتح المقاطعات لحظياً
+
+void* memcpy_sse2(void* dest, const void* src, uint32_t size) {
+    uint8_t* d = (uint8_t*)dest;
+    const uint8_t* s = (const uint8_t*)src;
+    uint32_t head, blocks, chunk, flags;
+    bool non_temporal = size >= MEM_NT_THRESHOLD;
+    
+    // محاذاة الهدف إلى 16 بايت
+    head = (16 - ((uint32_t)d & 15)) & 15;
+    if (head > size) {
+        head = size;
+    }
+    memcpy_rep(d, s, head);
+    d += head;
+    s += head;
+    size -= head;
+    
+    blocks = size / 64;
+    while (blocks > 0) {
+        chunk = blocks < SSE2_CHUNK_BLOCKS ? blocks : SSE2_CHUNK_BLOCKS;
+        blocks -= chunk;
+        
+        flags = irq_save();
+        if (non_temporal) {
+            asm volatile("1:\n\t"
+                         "movdqu 0(%1), %%xmm0\n\t"
+                         "movdqu 16(%1), %%xmm1\n\t"
+                         "movdqu 32(%1), %%xmm2\n\t"
+                         "movdqu 48(%1), %%xmm3\n\t"
+                         "movntdq %%xmm0, 0(%0)\n\t"
+                         "movntdq %%xmm1, 16(%0)\n\t"
+                         "movntdq %%xmm2, 32(%0)\n\t"
+                         "movntdq %%xmm3, 48(%0)\n\t"
+                         "addl $64, %0\n\t"
+                         "addl $64, %1\n\t"
+                         "decl %2\n\t"
+                         "jnz 1b\n\t"
+                         "sfence"
+                         : "+r" (d), "+r" (s), "+r" (chunk)
+                         :
+                         : "memory", "cc");
+        } else {
+            asm volatile("1:\n\t"
+                         "movdqu 0(%1), %%xmm0\n\t"
+                         "movdqu 16(%1), %%xmm1\n\t"
+                         "movdqu 32(%1), %%xmm2\n\t"
+                         "movdqu 48(%1), %%xmm3\n\t"
+                         "movdqa %%xmm0, 0(%0)\n\t"
+                         "movdqa %%xmm1, 16(%0)\n\t"
+                         "movdqa %%xmm2, 32(%0)\n\t"
+                         "movdqa %%xmm3, 48(%0)\n\t"
+                         "addl $64, %0\n\t"
+                         "addl $64, %1\n\t"
+                         "decl %2\n\t"
+                         "jnz 1b"
+                         : "+r" (d), "+r" (s), "+r" (chunk)
+                         :
+                         : "memory", "cc");
+        }
+        irq_restore(flags);
+    }
+    
+    memcpy_rep(d, s, size & 63);
+    return dest;
+}
+
+void* memset_sse2(void* ptr, int value, uint32_t size) {
+    uint8_t* p = (uint8_t*)ptr;
+    uint32_t fill = (uint8_t)value * 0x01010101u;
+    uint32_t head, blocks, chunk, flags;
+    bool non_temporal = size >= MEM_NT_THRESHOLD;
+    
+    head = (16 - ((uint32_t)p & 15)) & 15;
+    if (head > size) {
+        head = size;
+    }
+    memset_rep(p, value, head);
+    p += head;
+    size -= head;
+    
+    blocks = size / 64;
+    while (blocks > 0) {
+        chunk = blocks < SSE2_CHUNK_BLOCKS ? blocks : SSE2_CHUNK_BLOCKS;
+        blocks -= chunk;
+        
+        flags = irq_save();
+        asm volatile("movd %3, %%xmm0\n\t"
+                     "pshufd $0, %%xmm0, %%xmm0\n\t"
+                     "testl %2, %2\n\t"
+                     "jnz 2f\n\t"
+                     "1:\n\t"
+                     "movdqa %%xmm0, 0(%0)\n\t"
+                     "movdqa %%xmm0, 16(%0)\n\t"
+                     "movdqa %%xmm0, 32(%0)\n\t"
+                     "movdqa %%xmm0, 48(%0)\n\t"
+                     "addl $64, %0\n\t"
+                     "decl %1\n\t"
+                     "jnz 1b\n\t"
+                     "jmp 3f\n\t"
+                     "2:\n\t"
+                     "movntdq %%xmm0, 0(%0)\n\t"
+                     "movntdq %%xmm0, 16(%0)\n\t"
+                     "movntdq %%xmm0, 32(%0)\n\t"
+                     "movntdq %%xmm0, 48(%0)\n\t"
+                     "addl $64, %0\n\t"
+                     "decl %1\n\t"
+                     "jnz 2b\n\t"
+                     "sfence\n\t"
+                     "3:"
+                     : "+r" (p), "+r" (chunk)
+                     : "r" ((uint32_t)non_temporal), "r" (fill)
+                     : "memory", "cc");
+        irq_restore(flags);
+    }
+    
+    memset_rep(p, value, size & 63);
+    return ptr;
+}
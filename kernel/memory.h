@@ -5,38 +5,197 @@
 
 // ثوابت إدارة الذاكرة مستوحاة من Linux 0.01
 #define PAGE_SIZE 4096              // حجم الصفحة 4KB
+#define PAGE_SHIFT 12               // log2(PAGE_SIZE)
+#define PAGE_ALIGN(addr) (((uint32_t)(addr) + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1))
+// MEMORY_START و MEMORY_END قابلتان للتغيير عند الترجمة (make bench-host يضعهما فوق البرنامج)
+#ifndef MEMORY_START
 #define MEMORY_START 0x100000       // بداية الذاكرة المتاحة (1MB)
-#define MEMORY_END 0x1000000        // نهاية الذاكرة (16MB)
-#define MAX_PAGES ((MEMORY_END - MEMORY_START) / PAGE_SIZE)
+#endif
+#ifndef MEMORY_END
+#define MEMORY_END 0x1000000        // نهاية الذاكرة إذا لم تتوفر خريطة E820 (16MB)
+#endif
+#define MEMORY_LIMIT 0xC0000000     // أعلى ذاكرة تربطها النواة مباشرة (مساحة المستخدم فوقها)
+#define KERNEL_HEAP_SIZE 0x400000   // منطقة kmalloc في بداية الذاكرة (4MB)
+
+// ثوابت bitmap الإطارات
+#define BITS_PER_WORD 32
+#define FRAME_NONE 0xFFFFFFFF       // لا يوجد إطار حر
+
+// خريطة الذاكرة من BIOS (int 0x15, E820) - يملؤها boot.asm قبل تحميل النواة
+#define E820_MAP_ADDR 0x500
+#define E820_SIGNATURE 0x534D4150   // 'SMAP': الخريطة صالحة
+#define E820_MAX_ENTRIES 64
+#define E820_USABLE 1               // ذاكرة قابلة للاستخدام
+
+typedef struct __attribute__((packed)) {
+    uint64_t base;              // بداية المنطقة
+    uint64_t length;            // طول المنطقة
+    uint32_t type;              // نوع المنطقة (1 = متاحة)
+    uint32_t acpi;              // سمات ACPI 3.0
+} e820_entry_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t signature;         // E820_SIGNATURE إذا نجح الاكتشاف
+    uint32_t count;             // عدد المدخلات
+    e820_entry_t entries[E820_MAX_ENTRIES];
+} e820_map_t;
+
+// خريطة الذاكرة التي تركها boot.asm
+extern const e820_map_t* boot_memory_map;
+
+// ثوابت مخصص buddy
+#define BUDDY_MAX_ORDER 11          // الرتب 0..10 (أكبر كتلة 4MB)
+#define PAGE_ORDER_NONE 0xF         // صفحة داخل كتلة وليست رأسها
+
+// أعلام الصفحات
+#define PG_SLAB 0x01                // رأس كتلة يملكها مخصص slab
 
 // حالات الصفحات
 #define PAGE_FREE 0
 #define PAGE_USED 1
 #define PAGE_RESERVED 2
 
-// هيكل بيانات الصفحة
-typedef struct {
-    uint32_t address;           // عنوان الصفحة
-    uint8_t status;             // حالة الصفحة (حرة/مستخدمة/محجوزة)
-    uint32_t ref_count;         // عداد المراجع
+// هيكل بيانات الصفحة - 3 بايت لكل إطار
+// العنوان يُشتق من الفهرس (PFN_TO_ADDR)، وروابط قوائم buddy تُخزن
+// داخل الصفحة الحرة نفسها، فلا يبقى هنا إلا الحقول الساخنة
+typedef struct __attribute__((packed)) page {
+    uint16_t ref_count;         // عداد المراجع
+    uint8_t order : 4;          // رتبة الكتلة إذا كانت الصفحة رأسها
+    uint8_t status : 2;         // حالة الصفحة (حرة/مستخدمة/محجوزة)
+    uint8_t flags : 2;          // أعلام PG_*
 } page_t;
 
-// هيكل بيانات كتلة الذاكرة
+// روابط كتلة حرة في قائمة رتبتها - في أول بايتات الكتلة نفسها
+typedef struct free_block {
+    struct free_block* next;    // الكتلة التالية في قائمة الرتبة
+    struct free_block* prev;    // الكتلة السابقة في قائمة الرتبة
+} free_block_t;
+
+// قائمة الكتل الحرة لرتبة واحدة
+typedef struct {
+    free_block_t* head;         // أول كتلة حرة
+    uint32_t count;             // عدد الكتل الحرة
+} free_area_t;
+
+// مناطق الذاكرة: لكل منطقة قوائم buddy وعلامات مائية خاصة بها
+// كل الذاكرة تحت MEMORY_LIMIT مربوطة مباشرة، فالمنطقة العليا سياسة تخصيص فقط:
+// صفحات المستخدم تُؤخذ منها أولاً فتبقى normal و DMA للنواة والأجهزة
+#define ZONE_DMA 0                  // تحت 16MB: أجهزة ISA DMA
+#define ZONE_NORMAL 1               // حتى 896MB
+#define ZONE_HIGH 2                 // ما فوق ذلك
+#define MAX_ZONES 3
+#define ZONE_DMA_END 0x1000000
+#define ZONE_NORMAL_END 0x38000000
+#define ZONE_DMA_RESERVE 256        // صفحات DMA لا تصلها الطلبات المتراجعة من منطقة أعلى
+#define ZONE_MIN_RATIO 256          // min = الصفحات المتاحة / 256
+#define ZONE_MIN_PAGES 8
+
+// أعلام التخصيص: المنطقة المفضلة (والتراجع منها نزولاً) وهل يُسمح بالنزول تحت min
+#define GFP_KERNEL 0x00             // normal ثم DMA
+#define GFP_DMA 0x01                // DMA فقط
+#define GFP_HIGHUSER 0x02           // high ثم normal ثم DMA (صفحات المستخدم)
+#define GFP_ATOMIC 0x04             // لا ينتظر الاسترجاع: يصل حتى نصف min
+#define GFP_NORETRY 0x08            // اختياري: لا ينزل تحت low ولا يطلب الاسترجاع
+
+typedef struct {
+    const char* name;           // اسم المنطقة
+    uint32_t start_pfn;         // أول إطار في المنطقة
+    uint32_t end_pfn;           // بعد آخر إطار
+    uint32_t present_pages;     // إطارات يديرها buddy فيها
+    uint32_t free_pages;        // الإطارات الحرة فيها
+    free_area_t free_area[BUDDY_MAX_ORDER]; // قوائم buddy لكل رتبة
+    uint32_t free_area_mask;    // بت لكل رتبة قائمتها غير فارغة
+    uint32_t watermark_min;     // تحته: طلبات GFP_ATOMIC فقط
+    uint32_t watermark_low;     // تحته: يُطلب الاسترجاع في الخلفية
+    uint32_t watermark_high;    // يتوقف الاسترجاع عنده
+    uint32_t lowmem_reserve;    // صفحات محجوزة لطلبات هذه المنطقة نفسها
+    uint32_t allocs;            // تخصيصات خُدمت منها
+    uint32_t fallbacks;         // منها تخصيصات تراجعت من منطقة أعلى
+    uint32_t low_events;        // مرات النزول تحت low
+} zone_t;
+
+// دالة استرجاع: تحاول تحرير عدد من الصفحات وتعيد ما حررته فعلاً
+typedef uint32_t (*reclaim_hook_t)(uint32_t pages);
+#define MAX_RECLAIM_HOOKS 4
+
+// مخصص الإطارات: bitmap بمستويين، بت لكل إطار (1 = حر)
+// وبت ملخص لكل كلمة (1 = الكلمة فيها إطار حر واحد على الأقل)
+typedef struct {
+    uint32_t* bitmap;           // bitmap الإطارات
+    uint32_t* summary;          // bitmap الملخص
+    uint32_t frame_count;       // عدد الإطارات
+    uint32_t word_count;        // عدد كلمات bitmap
+    uint32_t free_frames;       // عدد الإطارات الحرة
+    uint32_t hint;              // أول كلمة ملخص قد تحتوي إطاراً حراً
+} frame_allocator_t;
+
+// هيكل بيانات كتلة الذاكرة (boundary tag أمامي)
+// next/prev تُستخدم فقط والكتلة حرة، وتقع داخل الحمولة
 typedef struct memory_block {
-    uint32_t address;           // عنوان الكتلة
-    uint32_t size;              // حجم الكتلة
-    uint8_t is_free;            // هل الكتلة حرة؟
-    struct memory_block* next;  // المؤشر للكتلة التالية
-    struct memory_block* prev;  // المؤشر للكتلة السابقة
+    uint32_t size;              // حجم الحمولة
+    uint32_t is_free;           // هل الكتلة حرة؟
+    struct memory_block* next;  // الكتلة الحرة التالية
+    struct memory_block* prev;  // الكتلة الحرة السابقة
 } memory_block_t;
 
+// boundary tag خلفي في نهاية كل كتلة
+typedef struct {
+    uint32_t size;              // نسخة من حجم الحمولة
+    uint32_t is_free;           // نسخة من حالة الكتلة
+} block_footer_t;
+
+#define BLOCK_HEADER_SIZE (2 * sizeof(uint32_t))    // size + is_free
+#define BLOCK_FOOTER_SIZE sizeof(block_footer_t)
+#define BLOCK_OVERHEAD (BLOCK_HEADER_SIZE + BLOCK_FOOTER_SIZE)
+#define BLOCK_MIN_PAYLOAD (2 * sizeof(void*))       // مساحة next/prev في الكتلة الحرة
+#define BLOCK_ALIGN 8
+
+// مخزون الصفحات المصفرة مسبقاً - تملؤه مهمة الخمول على دفعات صغيرة
+#define ZERO_POOL_SIZE 64           // أقصى عدد صفحات مصفرة جاهزة
+#define ZERO_CHUNK_SIZE 512         // بايتات تُصفر في كل خطوة (المقاطعات مفعلة بينها)
+
+typedef struct {
+    void* pages[ZERO_POOL_SIZE];    // صفحات مصفرة جاهزة
+    uint32_t count;                 // عدد الصفحات الجاهزة
+    void* filling;                  // الصفحة التي يجري تصفيرها
+    uint32_t fill_offset;           // ما تم تصفيره منها
+    bool fill_busy;                 // مستدعٍ يصفر قطعة الآن خارج irq_save
+    uint32_t hits;                  // طلبات خدمها المخزون
+    uint32_t misses;                // طلبات صُفرت فيها الصفحة فوراً
+} zero_pool_t;
+
+// تلوين الصفحات: صفحات حرة مصنفة حسب لونها في L2 (بتات العنوان الفيزيائي
+// فوق إزاحة الصفحة التي تدخل في فهرس المجموعة)، حتى تتوزع صفحات المهمة
+// المتتالية على كل المجموعات بدل أن تتزاحم في بعضها
+#define MAX_CACHE_COLORS 64
+
+typedef struct {
+    bool enabled;                   // هل يُستخدم التلوين لصفحات المستخدم؟
+    uint32_t colors;                // عدد الألوان (قوة للعدد 2، من cpu_info)
+    uint32_t order;                 // log2(colors): كتلة بهذه الرتبة تغطي كل الألوان مرة
+    free_block_t* lists[MAX_CACHE_COLORS]; // صفحات جاهزة لكل لون
+    uint32_t counts[MAX_CACHE_COLORS];
+    uint32_t cached;                // صفحات في القوائم (مخصصة من buddy)
+    uint32_t refills;               // كتل أُخذت من buddy وقُسمت على الألوان
+    uint32_t misses;                // طلبات أخذت صفحة بلا لون محدد
+} color_cache_t;
+
 // هيكل بيانات مدير الذاكرة
 typedef struct {
-    page_t pages[MAX_PAGES];    // مصفوفة الصفحات
+    page_t* pages;              // مصفوفة الصفحات (تُحجز بعد منطقة kmalloc)
+    uint32_t* frame_bitmap;     // bitmap الإطارات الحرة عند التهيئة (يبني منه buddy_init)
+    uint32_t* frame_summary;    // ملخص bitmap
+    uint32_t memory_end;        // نهاية الذاكرة المكتشفة
+    uint32_t metadata_size;     // حجم بيانات الإطارات بالبايت
+    frame_allocator_t frames;   // مخصص الإطارات
+    zone_t zones[MAX_ZONES];    // مناطق buddy
+    reclaim_hook_t reclaim_hooks[MAX_RECLAIM_HOOKS]; // دوال الاسترجاع المسجلة
+    uint32_t reclaim_hook_count;
+    bool reclaim_pending;       // منطقة نزلت تحت low ولم تُسترجع بعد
     uint32_t total_pages;       // العدد الكلي للصفحات
     uint32_t free_pages;        // عدد الصفحات الحرة
     uint32_t used_pages;        // عدد الصفحات المستخدمة
-    memory_block_t* free_list;  // قائمة الكتل الحرة
+    memory_block_t* free_list;  // قائمة الكتل الحرة فقط
     uint32_t total_memory;      // إجمالي الذاكرة
     uint32_t free_memory;       // الذاكرة الحرة
 } memory_manager_t;
@@ -47,7 +206,16 @@ typedef struct {
     uint32_t total_frees;       // إجمالي التحريرات
     uint32_t current_allocated; // المخصص حالياً
     uint32_t peak_allocated;    // أقصى مخصص
-    uint32_t fragmentation;     // نسبة التجزئة
+    uint32_t fragmentation;     // % التجزئة الخارجية لمنطقة الكتل المتغيرة
+    uint32_t realloc_in_place;  // krealloc بدون نسخ
+    uint32_t realloc_copied;    // krealloc بتخصيص جديد ونسخ
+    uint32_t zero_pool_pages;   // صفحات مصفرة جاهزة حالياً
+    uint32_t zero_pool_hits;    // alloc_zeroed_page من المخزون
+    uint32_t zero_pool_misses;  // alloc_zeroed_page بتصفير فوري
+    uint32_t reclaim_runs;      // مرات تشغيل الاسترجاع في الخلفية
+    uint32_t reclaimed_pages;   // الصفحات التي أعادها الاسترجاع
+    uint32_t free_blocks[BUDDY_MAX_ORDER];        // الكتل الحرة لكل رتبة (كل المناطق)
+    uint32_t order_fragmentation[BUDDY_MAX_ORDER]; // % من الذاكرة الحرة غير صالح لطلب بهذه الرتبة
 } memory_stats_t;
 
 // دوال إدارة الذاكرة الأساسية
@@ -60,21 +228,61 @@ void* krealloc(void* ptr, uint32_t new_size);
 // دوال إدارة الصفحات
 void* alloc_page(void);
 void free_page(void* page_addr);
+void* alloc_pages(uint32_t order);
+void* alloc_pages_gfp(uint32_t order, uint32_t gfp);
+void free_pages(void* addr, uint32_t order);
 page_t* get_page_info(void* addr);
 uint32_t get_free_pages_count(void);
+uint32_t get_memory_end(void);
+void* alloc_zeroed_page(void);
+bool zero_pool_refill(void);
+void* alloc_page_color(uint32_t color);
+uint32_t page_color(void* page);
+bool set_page_coloring(bool enabled);
+bool page_coloring_enabled(void);
+zone_t* get_zone(uint32_t zone);
+bool register_reclaim_hook(reclaim_hook_t hook);
+bool zone_reclaim(void);
+
+// دوال مخصص الإطارات (bitmap)
+void frame_allocator_init(frame_allocator_t* fa, uint32_t* bitmap, uint32_t* summary, uint32_t frame_count);
+uint32_t frame_alloc(frame_allocator_t* fa);
+void frame_free(frame_allocator_t* fa, uint32_t frame);
+void frame_reserve(frame_allocator_t* fa, uint32_t frame);
+int frame_is_free(frame_allocator_t* fa, uint32_t frame);
+
+// تحويل بين العنوان ورقم الإطار (PFN) بدون بحث
+#define ADDR_TO_PFN(addr) (((uint32_t)(addr) - MEMORY_START) >> PAGE_SHIFT)
+#define PFN_TO_ADDR(pfn) (MEMORY_START + ((uint32_t)(pfn) << PAGE_SHIFT))
 
 // دوال المراقبة والإحصائيات
 void print_memory_info(void);
 void print_memory_map(void);
 memory_stats_t* get_memory_stats(void);
-void check_memory_integrity(void);
+uint32_t check_memory_integrity(void);
 
 // دوال مساعدة
 void* memset(void* ptr, int value, uint32_t size);
 void* memcpy(void* dest, const void* src, uint32_t size);
+void* memmove(void* dest, const void* src, uint32_t size);
 int memcmp(const void* ptr1, const void* ptr2, uint32_t size);
+uint32_t strlen(const char* str);
+uint32_t strnlen(const char* str, uint32_t max_len);
 uint32_t align_address(uint32_t addr, uint32_t alignment);
 
+// تطبيقات بديلة لدوال الذاكرة، تُختار عند الإقلاع حسب CPUID
+#define MEM_SSE2_THRESHOLD 256      // أقل حجم يستحق مسار SSE2
+#define MEM_NT_THRESHOLD 0x40000    // من هذا الحجم تُستخدم كتابة non-temporal
+void select_memory_routines(void);
+void* memcpy_bytes(void* dest, const void* src, uint32_t size);
+void* memcpy_rep(void* dest, const void* src, uint32_t size);
+void* memcpy_sse2(void* dest, const void* src, uint32_t size);
+void* memset_bytes(void* ptr, int value, uint32_t size);
+void* memset_rep(void* ptr, int value, uint32_t size);
+void* memset_sse2(void* ptr, int value, uint32_t size);
+int memcmp_bytes(const void* ptr1, const void* ptr2, uint32_t size);
+int memcmp_words(const void* ptr1, const void* ptr2, uint32_t size);
+
 // دوال التجزئة والضغط
 void defragment_memory(void);
 void compact_free_blocks(void);
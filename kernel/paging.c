@@ -0,0 +1,643 @@
+#include "paging.h"
+#include "memory.h"
+#include "cpu.h"
+#include "task.h"
+#include "kernel.h"
+
+// دليل صفحات النواة - أساس كل الأدلة الأخرى
+page_directory_t* kernel_directory = NULL;
+
+// CR3 المحمل حالياً على هذا المعالج - لتجنب إعادة تحميله (ومسح TLB) بلا داع
+#define current_cr3 (this_cpu()->cr3)
+static paging_stats_t paging_stats;
+
+// تخصيص جدول صفحات فارغ من مخصص الصفحات
+// العنوان الفيزيائي = الافتراضي لأن ذاكرة النواة مربوطة بشكل مطابق
+static page_table_t* alloc_page_table(void) {
+    page_table_t* table = (page_table_t*)alloc_zeroed_page();
+
+    if (table) {
+        paging_stats.page_tables++;
+    }
+    return table;
+}
+
+static void free_page_table(page_table_t* table) {
+    free_page(table);
+    paging_stats.page_tables--;
+}
+
+// تقسيم صفحة 4MB إلى جدول من 1024 صفحة 4KB بنفس الصلاحيات
+// الترجمة لا تتغير، لذلك لا حاجة لمسح TLB هنا
+static bool split_large_page(pde_t* pde) {
+    uint32_t base = *pde & LARGE_PAGE_MASK;
+    uint32_t flags = *pde & (PAGE_PRESENT | PAGE_WRITABLE | PAGE_USER |
+                             PAGE_WRITETHROUGH | PAGE_NOCACHE | PAGE_GLOBAL);
+    page_table_t* table = alloc_page_table();
+    uint32_t i;
+
+    if (!table) {
+        return false;
+    }
+
+    for (i = 0; i < PAGE_ENTRIES; i++) {
+        table->entries[i] = (base + (i << PAGE_SHIFT)) | flags;
+    }
+
+    *pde = (uint32_t)table | (flags & ~PAGE_GLOBAL);
+    paging_stats.large_splits++;
+    return true;
+}
+
+// الحصول على مدخل جدول الصفحات لعنوان افتراضي
+// create: تخصيص جدول جديد إذا لم يكن موجوداً
+// صفحات 4MB تُقسم دائماً لأن كل المستدعين سيعدلون صفحة واحدة
+static pte_t* get_page_entry(page_directory_t* dir, uint32_t virt, bool create) {
+    pde_t* pde = &dir->entries[PDE_INDEX(virt)];
+    page_table_t* table;
+
+    if (*pde & PAGE_LARGE) {
+        if (!split_large_page(pde)) {
+            return NULL;
+        }
+    } else if (!(*pde & PAGE_PRESENT)) {
+        if (!create) {
+            return NULL;
+        }
+        table = alloc_page_table();
+        if (!table) {
+            return NULL;
+        }
+        // الصلاحيات الفعلية تحددها مدخلات الجدول
+        *pde = (uint32_t)table | PAGE_PRESENT | PAGE_WRITABLE | PAGE_USER;
+    }
+
+    table = (page_table_t*)(*pde & PAGE_FRAME_MASK);
+    return &table->entries[PTE_INDEX(virt)];
+}
+
+// ربط مساحة النواة: صفحات 4MB إذا دعم المعالج PSE، وإلا جداول 4KB
+static void map_kernel_space(page_directory_t* dir, uint32_t global) {
+    uint32_t addr;
+
+    if (paging_stats.large_pages) {
+        for (addr = 0; addr < paging_stats.kernel_space_end; addr += LARGE_PAGE_SIZE) {
+            dir->entries[PDE_INDEX(addr)] = addr | PAGE_PRESENT | PAGE_WRITABLE |
+                                            PAGE_LARGE | global;
+        }
+        return;
+    }
+
+    for (addr = 0; addr < paging_stats.kernel_space_end; addr += PAGE_SIZE) {
+        map_page(dir, addr, addr, PAGE_PRESENT | PAGE_WRITABLE | global);
+    }
+}
+
+/**
+ * تهيئة الترقيم: بناء دليل النواة وتفعيل CR0.PG
+ * يجب أن تُستدعى بعد init_memory_manager وقبل إنشاء المهام
+ */
+void init_paging(void) {
+    uint32_t cr0, cr4;
+    uint32_t global = 0;
+
+    print_string("[PAGING] تهيئة الترقيم...\n");
+
+    kernel_directory = (page_directory_t*)alloc_page();
+    if (!kernel_directory) {
+        print_string("[ERROR] Cannot allocate kernel page directory\n");
+        return;
+    }
+    memset(kernel_directory, 0, sizeof(page_directory_t));
+
+    // ربط كل الذاكرة المكتشفة مقربة إلى صفحة 4MB كاملة
+    paging_stats.kernel_space_end = (get_memory_end() + LARGE_PAGE_SIZE - 1) & LARGE_PAGE_MASK;
+    paging_stats.kernel_pdes = PDE_INDEX(paging_stats.kernel_space_end);
+
+    paging_stats.large_pages = cpu_has(features_edx, CPUID_EDX_PSE);
+    paging_stats.global_pages = cpu_has(features_edx, CPUID_EDX_PGE);
+    if (paging_stats.global_pages) {
+        global = PAGE_GLOBAL;
+    }
+
+    map_kernel_space(kernel_directory, global);
+
+    asm volatile("mov %%cr4, %0" : "=r" (cr4));
+    if (paging_stats.large_pages) {
+        cr4 |= CR4_PSE;
+    }
+    if (paging_stats.global_pages) {
+        cr4 |= CR4_PGE;
+    }
+    asm volatile("mov %0, %%cr4" : : "r" (cr4));
+
+    current_cr3 = (uint32_t)kernel_directory;
+    asm volatile("mov %0, %%cr3" : : "r" (current_cr3));
+
+    asm volatile("mov %%cr0, %0" : "=r" (cr0));
+    // النواة كلها في الحلقة 0: بدون WP لا تسبب الكتابة على صفحة COW خطأ
+    cr0 |= CR0_PG | CR0_WP;
+    asm volatile("mov %0, %%cr0" : : "r" (cr0) : "memory");
+
+    paging_stats.enabled = true;
+    print_paging_info();
+}
+
+/**
+ * إنشاء دليل صفحات جديد يشارك النواة مدخلاتها (الذاكرة ونافذة الأجهزة)
+ * تعديلات النواة بعد إنشاء الدليل (مثل تقسيم صفحة 4MB) لا تنعكس عليه
+ */
+page_directory_t* create_page_directory(void) {
+    page_directory_t* dir = (page_directory_t*)alloc_page();
+    uint32_t i;
+
+    if (!dir) {
+        return NULL;
+    }
+
+    for (i = 0; i < paging_stats.kernel_pdes; i++) {
+        dir->entries[i] = kernel_directory->entries[i];
+    }
+    memset(&dir->entries[paging_stats.kernel_pdes], 0,
+           (DEVICE_PDE_START - paging_stats.kernel_pdes) * sizeof(pde_t));
+    for (i = DEVICE_PDE_START; i < PAGE_ENTRIES; i++) {
+        dir->entries[i] = kernel_directory->entries[i];
+    }
+
+    return dir;
+}
+
+/**
+ * نسخ مساحة عناوين لـ fork: الجداول فقط تُنسخ، والإطارات تُشارك
+ * الصفحات القابلة للكتابة تصبح للقراءة فقط مع PAGE_COW في الدليلين
+ * ويزداد ref_count لكل إطار مشترك
+ */
+page_directory_t* clone_page_directory(page_directory_t* src) {
+    page_directory_t* dir = create_page_directory();
+    page_table_t* src_table;
+    page_table_t* table;
+    page_t* page;
+    pte_t pte;
+    uint32_t i, j;
+
+    if (!dir) {
+        return NULL;
+    }
+
+    for (i = paging_stats.kernel_pdes; i < DEVICE_PDE_START; i++) {
+        if (!(src->entries[i] & PAGE_PRESENT)) {
+            continue;
+        }
+
+        table = alloc_page_table();
+        if (!table) {
+            release_user_pages(dir, USER_SPACE_START, USER_SPACE_END);
+            destroy_page_directory(dir);
+            return NULL;
+        }
+
+        src_table = (page_table_t*)(src->entries[i] & PAGE_FRAME_MASK);
+        for (j = 0; j < PAGE_ENTRIES; j++) {
+            pte = src_table->entries[j];
+            if (!(pte & PAGE_PRESENT)) {
+                continue;
+            }
+            if (pte & PAGE_WRITABLE) {
+                pte = (pte & ~PAGE_WRITABLE) | PAGE_COW;
+                src_table->entries[j] = pte;
+            }
+            page = get_page_info((void*)(pte & PAGE_FRAME_MASK));
+            if (page) {
+                page->ref_count++;
+            }
+            table->entries[j] = pte;
+        }
+        dir->entries[i] = (uint32_t)table | (src->entries[i] & PAGE_FLAGS_MASK);
+    }
+
+    // صفحات الأب أصبحت للقراءة فقط
+    if (current_cr3 == (uint32_t)src) {
+        flush_tlb_all();
+    }
+    return dir;
+}
+
+/**
+ * تحرير دليل صفحات وجداول المستخدم التابعة له
+ * الإطارات المربوطة تبقى مسؤولية من قام بربطها
+ */
+void destroy_page_directory(page_directory_t* dir) {
+    uint32_t i;
+
+    if (!dir || dir == kernel_directory) {
+        return;
+    }
+
+    // الانتقال إلى دليل النواة قبل تحرير الجداول المحملة
+    if (current_cr3 == (uint32_t)dir) {
+        switch_page_directory((uint32_t)kernel_directory);
+    }
+
+    for (i = paging_stats.kernel_pdes; i < DEVICE_PDE_START; i++) {
+        if ((dir->entries[i] & PAGE_PRESENT) && !(dir->entries[i] & PAGE_LARGE)) {
+            free_page_table((page_table_t*)(dir->entries[i] & PAGE_FRAME_MASK));
+        }
+    }
+    free_page(dir);
+}
+
+/**
+ * ربط صفحة افتراضية بإطار فيزيائي
+ */
+bool map_page(page_directory_t* dir, uint32_t virt, uint32_t phys, uint32_t flags) {
+    pte_t* pte = get_page_entry(dir, virt, true);
+
+    if (!pte) {
+        return false;
+    }
+
+    *pte = (phys & PAGE_FRAME_MASK) | (flags & PAGE_FLAGS_MASK) | PAGE_PRESENT;
+    flush_tlb_single(virt);
+    return true;
+}
+
+/**
+ * إلغاء ربط صفحة افتراضية
+ */
+bool unmap_page(page_directory_t* dir, uint32_t virt) {
+    pte_t* pte = get_page_entry(dir, virt, false);
+
+    if (!pte || !(*pte & PAGE_PRESENT)) {
+        return false;
+    }
+
+    *pte = 0;
+    flush_tlb_single(virt);
+    return true;
+}
+
+/**
+ * ربط سجلات جهاز (MMIO) في نافذة الأجهزة بعنوان مطابق وبدون ذاكرة مخبئية
+ * جداولها مشتركة بين كل الأدلة، والمدخل الجديد يُنسخ إلى أدلة المهام الموجودة
+ */
+bool map_mmio(uint32_t phys, uint32_t size) {
+    uint32_t addr = phys & PAGE_FRAME_MASK;
+    uint32_t end = phys + size;
+    uint32_t index;
+    pde_t old_pde;
+    page_directory_t* dir;
+    task_t* task;
+
+    if (phys < USER_SPACE_END || end < phys) {
+        return false;
+    }
+
+    for (; addr < end && addr >= USER_SPACE_END; addr += PAGE_SIZE) {
+        index = PDE_INDEX(addr);
+        old_pde = kernel_directory->entries[index];
+        if (!map_page(kernel_directory, addr, addr, PAGE_WRITABLE | PAGE_NOCACHE |
+                      PAGE_WRITETHROUGH | (paging_stats.global_pages ? PAGE_GLOBAL : 0))) {
+            return false;
+        }
+
+        if (kernel_directory->entries[index] != old_pde) {
+            for (task = task_list; task; task = task->next) {
+                dir = (page_directory_t*)task->cr3;
+                if (dir && dir != kernel_directory) {
+                    dir->entries[index] = kernel_directory->entries[index];
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * تغيير صلاحيات صفحة مربوطة مع الإبقاء على الإطار
+ */
+bool protect_page(page_directory_t* dir, uint32_t virt, uint32_t flags) {
+    pte_t* pte = get_page_entry(dir, virt, false);
+
+    if (!pte || !(*pte & PAGE_PRESENT)) {
+        return false;
+    }
+
+    *pte = (*pte & PAGE_FRAME_MASK) | (flags & PAGE_FLAGS_MASK) | PAGE_PRESENT;
+    flush_tlb_single(virt);
+    return true;
+}
+
+/**
+ * صفحة حماية في الربط المطابق للنواة (مثل أسفل مكدس مهمة)
+ * guard: إلغاء ربطها، وإلا إعادة ربطها قبل إعادة الإطار إلى المخصص
+ * إذا قُسمت صفحة 4MB يُنقل الجدول الجديد إلى أدلة المهام التي تشارك المدخل القديم
+ */
+bool set_kernel_guard_page(void* page, bool guard) {
+    uint32_t virt = (uint32_t)page & PAGE_FRAME_MASK;
+    uint32_t index = PDE_INDEX(virt);
+    pde_t old_pde, new_pde;
+    page_directory_t* dir;
+    task_t* task;
+    pte_t* pte;
+
+    if (!paging_stats.enabled || index >= paging_stats.kernel_pdes) {
+        return false;
+    }
+
+    old_pde = kernel_directory->entries[index];
+    pte = get_page_entry(kernel_directory, virt, false);
+    if (!pte) {
+        return false;
+    }
+
+    new_pde = kernel_directory->entries[index];
+    if (new_pde != old_pde) {
+        for (task = task_list; task; task = task->next) {
+            dir = (page_directory_t*)task->cr3;
+            if (dir && dir != kernel_directory && dir->entries[index] == old_pde) {
+                dir->entries[index] = new_pde;
+            }
+        }
+    }
+
+    if (guard) {
+        *pte = 0;
+    } else {
+        *pte = virt | PAGE_PRESENT | PAGE_WRITABLE |
+               (paging_stats.global_pages ? PAGE_GLOBAL : 0);
+    }
+    flush_tlb_single(virt);
+    return true;
+}
+
+/**
+ * ترجمة عنوان افتراضي إلى فيزيائي (PAGE_NOT_MAPPED إذا لم يكن مربوطاً)
+ */
+uint32_t virt_to_phys(page_directory_t* dir, uint32_t virt) {
+    pde_t pde = dir->entries[PDE_INDEX(virt)];
+    page_table_t* table;
+    pte_t pte;
+
+    if (!(pde & PAGE_PRESENT)) {
+        return PAGE_NOT_MAPPED;
+    }
+    if (pde & PAGE_LARGE) {
+        return (pde & LARGE_PAGE_MASK) | (virt & ~LARGE_PAGE_MASK);
+    }
+
+    table = (page_table_t*)(pde & PAGE_FRAME_MASK);
+    pte = table->entries[PTE_INDEX(virt)];
+    if (!(pte & PAGE_PRESENT)) {
+        return PAGE_NOT_MAPPED;
+    }
+    return (pte & PAGE_FRAME_MASK) | (virt & ~PAGE_FRAME_MASK);
+}
+
+/**
+ * تحميل دليل صفحات مهمة في CR3 - يُتخطى إذا كان محملاً بالفعل
+ * مهام النواة تشارك دليلاً واحداً فلا يُمسح TLB عند التبديل بينها
+ */
+void switch_page_directory(uint32_t cr3) {
+    if (!paging_stats.enabled || cr3 == 0 || cr3 == current_cr3) {
+        return;
+    }
+
+    current_cr3 = cr3;
+    asm volatile("mov %0, %%cr3" : : "r" (cr3) : "memory");
+    paging_stats.cr3_loads++;
+}
+
+/**
+ * الحصول على دليل صفحات خاص بالمهمة
+ * مهام النواة تشارك دليل النواة حتى تحجز أول ذاكرة مستخدم
+ */
+page_directory_t* get_task_directory(task_t* task) {
+    page_directory_t* dir;
+
+    if (task->cr3 != (uint32_t)kernel_directory) {
+        return (page_directory_t*)task->cr3;
+    }
+
+    dir = create_page_directory();
+    if (!dir) {
+        return NULL;
+    }
+    task->cr3 = (uint32_t)dir;
+    if (task == current_task) {
+        switch_page_directory(task->cr3);
+    }
+    return dir;
+}
+
+// إطار مصفر لصفحة مستخدم: بلون المهمة التالي إذا كان التلوين مفعلاً
+// وإلا من مخزون الصفحات المصفرة
+static void* alloc_user_page(task_t* task) {
+    void* frame;
+
+    if (!page_coloring_enabled()) {
+        return alloc_zeroed_page();
+    }
+    frame = alloc_page_color(task->next_color++);
+    if (frame) {
+        memset(frame, 0, PAGE_SIZE);
+    }
+    return frame;
+}
+
+// ربط صفحة جديدة مصفرة لمساحة المستخدم
+static bool map_zero_page(task_t* task, page_directory_t* dir, uint32_t virt) {
+    void* frame = alloc_user_page(task);
+
+    if (!frame) {
+        return false;
+    }
+
+    if (!map_page(dir, virt, (uint32_t)frame, PAGE_PRESENT | PAGE_WRITABLE | PAGE_USER)) {
+        free_page(frame);
+        return false;
+    }
+    return true;
+}
+
+// خطأ كتابة على صفحة COW: نسخ الإطار إذا كان مشتركاً
+// إذا بقي مرجع واحد فقط تُعاد الكتابة للصفحة نفسها بلا نسخ
+static bool handle_cow_fault(task_t* task, uint32_t addr) {
+    page_directory_t* dir = (page_directory_t*)task->cr3;
+    uint32_t page_addr = addr & PAGE_FRAME_MASK;
+    uint64_t start = rdtsc();
+    pte_t* pte;
+    page_t* page;
+    void* copy;
+    uint32_t phys, flags;
+
+    pte = get_page_entry(dir, page_addr, false);
+    if (!pte || !(*pte & PAGE_COW)) {
+        return false;
+    }
+
+    phys = *pte & PAGE_FRAME_MASK;
+    flags = ((*pte & PAGE_FLAGS_MASK) & ~PAGE_COW) | PAGE_WRITABLE;
+    page = get_page_info((void*)phys);
+
+    if (page && page->ref_count > 1) {
+        // النسخة تأخذ لون الأصل حتى لا يتغير توزيع المهمة على مجموعات L2
+        if (page_coloring_enabled()) {
+            copy = alloc_page_color(page_color((void*)phys));
+        } else {
+            copy = alloc_pages_gfp(0, GFP_HIGHUSER);
+        }
+        if (!copy) {
+            return false;
+        }
+        memcpy(copy, (void*)phys, PAGE_SIZE);
+        map_page(dir, page_addr, (uint32_t)copy, flags);
+        free_page((void*)phys);     // إنقاص ref_count فقط
+        paging_stats.cow_copies++;
+    } else {
+        protect_page(dir, page_addr, flags);
+        paging_stats.cow_reuses++;
+    }
+
+    task->page_faults++;
+    task->fault_cycles += rdtsc() - start;
+    return true;
+}
+
+/**
+ * معالجة خطأ صفحة في الكومة المحجوزة: ربط صفحة صفرية عند أول لمس
+ * مع ربط الصفحات المجاورة غير المربوطة في نفس النافذة (fault-around)
+ * تعيد false إذا لم يكن الخطأ قابلاً للمعالجة
+ */
+bool handle_page_fault(uint32_t addr, uint32_t err_code) {
+    task_t* task = current_task;
+    page_directory_t* dir;
+    uint64_t start = rdtsc();
+    uint32_t page, first, last, virt;
+    uint32_t mapped = 1;
+
+    if (!paging_stats.enabled || !task) {
+        return false;
+    }
+    if (err_code & PF_PRESENT) {
+        return (err_code & PF_WRITE) && handle_cow_fault(task, addr);
+    }
+    if (addr < task->brk_start || addr >= task->brk) {
+        return false;
+    }
+
+    dir = (page_directory_t*)task->cr3;
+    page = addr & PAGE_FRAME_MASK;
+    if (!map_zero_page(task, dir, page)) {
+        return false;
+    }
+
+    // نافذة fault-around محاذاة على FAULT_AROUND_PAGES داخل حدود الكومة
+    first = page & ~(FAULT_AROUND_PAGES * PAGE_SIZE - 1);
+    last = first + FAULT_AROUND_PAGES * PAGE_SIZE;
+    if (first < task->brk_start) {
+        first = task->brk_start;
+    }
+    if (last > PAGE_ALIGN(task->brk)) {
+        last = PAGE_ALIGN(task->brk);
+    }
+    for (virt = first; virt < last; virt += PAGE_SIZE) {
+        if (virt == page || virt_to_phys(dir, virt) != PAGE_NOT_MAPPED) {
+            continue;
+        }
+        if (!map_zero_page(task, dir, virt)) {
+            break;  // الصفحات المجاورة اختيارية
+        }
+        mapped++;
+    }
+
+    task->page_faults++;
+    task->fault_pages += mapped;
+    task->fault_cycles += rdtsc() - start;
+    paging_stats.demand_faults++;
+    paging_stats.demand_pages += mapped;
+    return true;
+}
+
+/**
+ * إلغاء ربط نطاق من مساحة المستخدم وتحرير إطاراته
+ */
+void release_user_pages(page_directory_t* dir, uint32_t start, uint32_t end) {
+    uint32_t virt, phys;
+
+    for (virt = PAGE_ALIGN(start); virt < end; virt += PAGE_SIZE) {
+        // جدول غير موجود: لا شيء مربوط في هذه الـ 4MB
+        if (!(dir->entries[PDE_INDEX(virt)] & PAGE_PRESENT)) {
+            virt = (virt & LARGE_PAGE_MASK) + LARGE_PAGE_SIZE - PAGE_SIZE;
+            continue;
+        }
+        phys = virt_to_phys(dir, virt);
+        if (phys != PAGE_NOT_MAPPED) {
+            unmap_page(dir, virt);
+            free_page((void*)phys);
+        }
+    }
+}
+
+/**
+ * مسح صفحة واحدة من TLB
+ */
+void flush_tlb_single(uint32_t virt) {
+    if (!paging_stats.enabled) {
+        return;
+    }
+
+    asm volatile("invlpg (%0)" : : "r" (virt) : "memory");
+    paging_stats.tlb_flushes++;
+}
+
+/**
+ * مسح TLB بالكامل بإعادة تحميل CR3 (الصفحات العامة تبقى)
+ */
+void flush_tlb_all(void) {
+    if (!paging_stats.enabled) {
+        return;
+    }
+
+    asm volatile("mov %0, %%cr3" : : "r" (current_cr3) : "memory");
+}
+
+/**
+ * الحصول على إحصائيات الترقيم
+ */
+paging_stats_t* get_paging_stats(void) {
+    return &paging_stats;
+}
+
+/**
+ * طباعة معلومات الترقيم
+ */
+void print_paging_info(void) {
+    print_string("[PAGING] ");
+    print_string(paging_stats.enabled ? "enabled" : "disabled");
+    print_string(", kernel map: ");
+    print_number(paging_stats.kernel_space_end / 1024 / 1024);
+    print_string("MB in ");
+    print_string(paging_stats.large_pages ? "4MB pages" : "4KB pages");
+    if (paging_stats.global_pages) {
+        print_string(" (global)");
+    }
+    print_string("\n");
+    print_string("  page tables: ");
+    print_number(paging_stats.page_tables);
+    print_string(", 4MB splits: ");
+    print_number(paging_stats.large_splits);
+    print_string(", invlpg: ");
+    print_number(paging_stats.tlb_flushes);
+    print_string(", cr3 loads: ");
+    print_number(paging_stats.cr3_loads);
+    print_string("\n");
+    print_string("  demand faults: ");
+    print_number(paging_stats.demand_faults);
+    print_string(", zero pages mapped: ");
+    print_number(paging_stats.demand_pages);
+    print_string(", cow copies: ");
+    print_number(paging_stats.cow_copies);
+    print_string(", cow reuses: ");
+    print_number(paging_stats.cow_reuses);
+    print_string("\n");
+}
@@ -0,0 +1,104 @@
+#ifndef PAGING_H
+#define PAGING_H
+
+#include "kernel.h"
+#include "memory.h"
+
+// بتات مدخلات جدول الصفحات ودليل الصفحات
+#define PAGE_PRESENT      0x001     // الصفحة موجودة
+#define PAGE_WRITABLE     0x002     // قابلة للكتابة
+#define PAGE_USER         0x004     // متاحة لوضع المستخدم
+#define PAGE_WRITETHROUGH 0x008     // كتابة مباشرة
+#define PAGE_NOCACHE      0x010     // بدون ذاكرة مخبئية (للأجهزة)
+#define PAGE_ACCESSED     0x020     // تمت القراءة
+#define PAGE_DIRTY        0x040     // تمت الكتابة
+#define PAGE_LARGE        0x080     // PDE: صفحة 4MB (PSE)
+#define PAGE_GLOBAL       0x100     // لا تُمسح من TLB عند تغيير CR3
+#define PAGE_COW          0x200     // متاح للنظام: نسخ عند الكتابة
+
+#define PAGE_FLAGS_MASK   0x00000FFF
+#define PAGE_FRAME_MASK   0xFFFFF000
+#define LARGE_PAGE_SIZE   0x400000  // 4MB
+#define LARGE_PAGE_MASK   0xFFC00000
+#define PAGE_ENTRIES      1024
+
+// فهارس العنوان الافتراضي
+#define PDE_INDEX(virt) ((uint32_t)(virt) >> 22)
+#define PTE_INDEX(virt) (((uint32_t)(virt) >> PAGE_SHIFT) & (PAGE_ENTRIES - 1))
+
+// مساحة النواة: ربط مطابق (identity) من 0 حتى نهاية الذاكرة المكتشفة
+// (مقربة إلى 4MB)، ومدخلات الدليل تحتها مشتركة بين كل أدلة الصفحات
+
+// مساحة المستخدم تبدأ فوق أعلى ذاكرة يمكن ربطها مباشرة - الكومة (brk) تنمو من بدايتها
+// وفوقها نافذة الأجهزة (IOAPIC/LAPIC)
+#define USER_SPACE_START  MEMORY_LIMIT
+#define USER_SPACE_END    0xFEC00000
+#define USER_HEAP_START   USER_SPACE_START
+#define DEVICE_PDE_START  PDE_INDEX(USER_SPACE_END)
+
+// عدد الصفحات المربوطة مع كل خطأ صفحة (fault-around)
+#define FAULT_AROUND_PAGES 4
+
+// بتات رمز خطأ الصفحة
+#define PF_PRESENT        0x1       // الصفحة موجودة (خرق صلاحيات)
+#define PF_WRITE          0x2       // عملية كتابة
+#define PF_USER           0x4       // من وضع المستخدم
+
+// قيمة تعيدها virt_to_phys لعنوان غير مربوط
+#define PAGE_NOT_MAPPED   0xFFFFFFFF
+
+typedef uint32_t pde_t;
+typedef uint32_t pte_t;
+
+// دليل الصفحات وجدول الصفحات - صفحة واحدة لكل منهما
+typedef struct {
+    pde_t entries[PAGE_ENTRIES];
+} page_directory_t;
+
+typedef struct {
+    pte_t entries[PAGE_ENTRIES];
+} page_table_t;
+
+// إحصائيات الترقيم
+typedef struct {
+    bool enabled;               // هل الترقيم مفعل؟
+    bool large_pages;           // هل ربط النواة بصفحات 4MB؟
+    bool global_pages;          // هل صفحات النواة عامة (PGE)؟
+    uint32_t kernel_space_end;  // نهاية الربط المطابق للنواة
+    uint32_t kernel_pdes;       // مدخلات الدليل المشتركة للنواة
+    uint32_t page_tables;       // جداول الصفحات المخصصة
+    uint32_t large_splits;      // صفحات 4MB تم تقسيمها
+    uint32_t tlb_flushes;       // invlpg لصفحة واحدة
+    uint32_t cr3_loads;         // تحميلات CR3 عند تبديل المهام
+    uint32_t demand_faults;     // أخطاء صفحات تمت معالجتها
+    uint32_t demand_pages;      // صفحات صفرية رُبطت عند الطلب
+    uint32_t cow_copies;        // صفحات نُسخت عند الكتابة
+    uint32_t cow_reuses;        // صفحات COW أُعيد استخدامها بلا نسخ
+} paging_stats_t;
+
+struct task_struct;
+
+// دليل صفحات النواة
+extern page_directory_t* kernel_directory;
+
+// دوال الترقيم
+void init_paging(void);
+page_directory_t* create_page_directory(void);
+page_directory_t* clone_page_directory(page_directory_t* src);
+void destroy_page_directory(page_directory_t* dir);
+bool map_page(page_directory_t* dir, uint32_t virt, uint32_t phys, uint32_t flags);
+bool unmap_page(page_directory_t* dir, uint32_t virt);
+bool protect_page(page_directory_t* dir, uint32_t virt, uint32_t flags);
+bool set_kernel_guard_page(void* page, bool guard);
+bool map_mmio(uint32_t phys, uint32_t size);
+uint32_t virt_to_phys(page_directory_t* dir, uint32_t virt);
+void switch_page_directory(uint32_t cr3);
+page_directory_t* get_task_directory(struct task_struct* task);
+bool handle_page_fault(uint32_t addr, uint32_t err_code);
+void release_user_pages(page_directory_t* dir, uint32_t start, uint32_t end);
+void flush_tlb_single(uint32_t virt);
+void flush_tlb_all(void);
+paging_stats_t* get_paging_stats(void);
+void print_paging_info(void);
+
+#endif // PAGING_H
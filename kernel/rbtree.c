@@ -0,0 +1,255 @@
+#include "rbtree.h"
+
+// تدوير لليسار حول x: ابنه الأيمن يصبح أباه
+static void rb_rotate_left(rb_node_t* x, rb_root_t* root) {
+    rb_node_t* y = x->right;
+
+    x->right = y->left;
+    if (y->left) {
+        y->left->parent = x;
+    }
+    y->parent = x->parent;
+    if (!x->parent) {
+        root->node = y;
+    } else if (x == x->parent->left) {
+        x->parent->left = y;
+    } else {
+        x->parent->right = y;
+    }
+    y->left = x;
+    x->parent = y;
+}
+
+// تدوير لليمين حول x: ابنه الأيسر يصبح أباه
+static void rb_rotate_right(rb_node_t* x, rb_root_t* root) {
+    rb_node_t* y = x->left;
+
+    x->left = y->right;
+    if (y->right) {
+        y->right->parent = x;
+    }
+    y->parent = x->parent;
+    if (!x->parent) {
+        root->node = y;
+    } else if (x == x->parent->right) {
+        x->parent->right = y;
+    } else {
+        x->parent->left = y;
+    }
+    y->right = x;
+    x->parent = y;
+}
+
+static inline bool rb_is_black(const rb_node_t* node) {
+    return !node || node->color == RB_BLACK;
+}
+
+/**
+ * إعادة توازن الشجرة بعد ربط عقدة حمراء جديدة
+ * (لا يوجد أب أحمر لأب أحمر، وكل المسارات بنفس عدد العقد السوداء)
+ */
+void rb_insert_color(rb_node_t* node, rb_root_t* root) {
+    rb_node_t* parent;
+    rb_node_t* gparent;
+    rb_node_t* uncle;
+
+    while ((parent = node->parent) && parent->color == RB_RED) {
+        gparent = parent->parent;     // موجود لأن الجذر أسود
+
+        if (parent == gparent->left) {
+            uncle = gparent->right;
+            if (uncle && uncle->color == RB_RED) {
+                // العم أحمر: إعادة تلوين والصعود
+                parent->color = RB_BLACK;
+                uncle->color = RB_BLACK;
+                gparent->color = RB_RED;
+                node = gparent;
+                continue;
+            }
+            if (node == parent->right) {
+                rb_rotate_left(parent, root);
+                node = parent;
+                parent = node->parent;
+            }
+            parent->color = RB_BLACK;
+            gparent->color = RB_RED;
+            rb_rotate_right(gparent, root);
+        } else {
+            uncle = gparent->left;
+            if (uncle && uncle->color == RB_RED) {
+                parent->color = RB_BLACK;
+                uncle->color = RB_BLACK;
+                gparent->color = RB_RED;
+                node = gparent;
+                continue;
+            }
+            if (node == parent->left) {
+                rb_rotate_right(parent, root);
+                node = parent;
+                parent = node->parent;
+            }
+            parent->color = RB_BLACK;
+            gparent->color = RB_RED;
+            rb_rotate_left(gparent, root);
+        }
+    }
+
+    root->node->color = RB_BLACK;
+}
+
+// وضع v مكان u عند أبيه
+static void rb_transplant(rb_node_t* u, rb_node_t* v, rb_root_t* root) {
+    if (!u->parent) {
+        root->node = v;
+    } else if (u == u->parent->left) {
+        u->parent->left = v;
+    } else {
+        u->parent->right = v;
+    }
+    if (v) {
+        v->parent = u->parent;
+    }
+}
+
+// إصلاح نقص عقدة سوداء في مسار node (قد تكون NULL، لذلك يُمرر أبوها)
+static void rb_erase_color(rb_node_t* node, rb_node_t* parent, rb_root_t* root) {
+    rb_node_t* sibling;
+
+    while (node != root->node && rb_is_black(node)) {
+        if (node == parent->left) {
+            sibling = parent->right;
+            if (sibling->color == RB_RED) {
+                sibling->color = RB_BLACK;
+                parent->color = RB_RED;
+                rb_rotate_left(parent, root);
+                sibling = parent->right;
+            }
+            if (rb_is_black(sibling->left) && rb_is_black(sibling->right)) {
+                sibling->color = RB_RED;
+                node = parent;
+                parent = node->parent;
+                continue;
+            }
+            if (rb_is_black(sibling->right)) {
+                sibling->left->color = RB_BLACK;
+                sibling->color = RB_RED;
+                rb_rotate_right(sibling, root);
+                sibling = parent->right;
+            }
+            sibling->color = parent->color;
+            parent->color = RB_BLACK;
+            sibling->right->color = RB_BLACK;
+            rb_rotate_left(parent, root);
+        } else {
+            sibling = parent->left;
+            if (sibling->color == RB_RED) {
+                sibling->color = RB_BLACK;
+                parent->color = RB_RED;
+                rb_rotate_right(parent, root);
+                sibling = parent->left;
+            }
+            if (rb_is_black(sibling->left) && rb_is_black(sibling->right)) {
+                sibling->color = RB_RED;
+                node = parent;
+                parent = node->parent;
+                continue;
+            }
+            if (rb_is_black(sibling->left)) {
+                sibling->right->color = RB_BLACK;
+                sibling->color = RB_RED;
+                rb_rotate_left(sibling, root);
+                sibling = parent->left;
+            }
+            sibling->color = parent->color;
+            parent->color = RB_BLACK;
+            sibling->left->color = RB_BLACK;
+            rb_rotate_right(parent, root);
+        }
+        node = root->node;
+        break;
+    }
+
+    if (node) {
+        node->color = RB_BLACK;
+    }
+}
+
+/**
+ * حذف عقدة من الشجرة وإعادة التوازن
+ */
+void rb_erase(rb_node_t* node, rb_root_t* root) {
+    rb_node_t* successor;
+    rb_node_t* child;
+    rb_node_t* parent;
+    int color = node->color;
+
+    if (!node->left) {
+        child = node->right;
+        parent = node->parent;
+        rb_transplant(node, child, root);
+    } else if (!node->right) {
+        child = node->left;
+        parent = node->parent;
+        rb_transplant(node, child, root);
+    } else {
+        // ابنان: اللاحق (أصغر عقدة في الفرع الأيمن) يأخذ مكان العقدة ولونها
+        successor = node->right;
+        while (successor->left) {
+            successor = successor->left;
+        }
+        color = successor->color;
+        child = successor->right;
+
+        if (successor->parent == node) {
+            parent = successor;
+        } else {
+            parent = successor->parent;
+            rb_transplant(successor, child, root);
+            successor->right = node->right;
+            successor->right->parent = successor;
+        }
+        rb_transplant(node, successor, root);
+        successor->left = node->left;
+        successor->left->parent = successor;
+        successor->color = node->color;
+    }
+
+    if (color == RB_BLACK) {
+        rb_erase_color(child, parent, root);
+    }
+}
+
+/**
+ * أصغر عقدة في الشجرة (NULL إذا كانت فارغة)
+ */
+rb_node_t* rb_first(const rb_root_t* root) {
+    rb_node_t* node = root->node;
+
+    if (!node) {
+        return NULL;
+    }
+    while (node->left) {
+        node = node->left;
+    }
+    return node;
+}
+
+/**
+ * العقدة التالية بالترتيب (NULL بعد الأخيرة)
+ */
+rb_node_t* rb_next(const rb_node_t* node) {
+    rb_node_t* parent;
+
+    if (node->right) {
+        node = node->right;
+        while (node->left) {
+            node = node->left;
+        }
+        return (rb_node_t*)node;
+    }
+
+    while ((parent = node->parent) && node == parent->right) {
+        node = parent;
+    }
+    return parent;
+}
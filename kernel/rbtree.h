@@ -0,0 +1,40 @@
+#ifndef RBTREE_H
+#define RBTREE_H
+
+#include "kernel.h"
+
+// شجرة حمراء-سوداء مدمجة في الهيكل المالك (مثل Linux lib/rbtree)
+// المستدعي يبحث عن موضع الإدراج بمفتاحه ثم يستدعي rb_link_node و rb_insert_color
+#define RB_RED   0
+#define RB_BLACK 1
+
+typedef struct rb_node {
+    struct rb_node* parent;
+    struct rb_node* left;
+    struct rb_node* right;
+    int color;
+} rb_node_t;
+
+typedef struct {
+    rb_node_t* node;            // الجذر (NULL = شجرة فارغة)
+} rb_root_t;
+
+// الهيكل المالك من عنوان العقدة المدمجة فيه
+#define rb_entry(ptr, type, member) \
+    ((type*)((char*)(ptr) - __builtin_offsetof(type, member)))
+
+// ربط عقدة جديدة حمراء في الموضع الذي وجده البحث
+static inline void rb_link_node(rb_node_t* node, rb_node_t* parent, rb_node_t** link) {
+    node->parent = parent;
+    node->left = NULL;
+    node->right = NULL;
+    node->color = RB_RED;
+    *link = node;
+}
+
+void rb_insert_color(rb_node_t* node, rb_root_t* root);
+void rb_erase(rb_node_t* node, rb_root_t* root);
+rb_node_t* rb_first(const rb_root_t* root);
+rb_node_t* rb_next(const rb_node_t* node);
+
+#endif // RBTREE_H
@@ -2,22 +2,19 @@
 #include "kernel.h"
 #include "memory.h"
 #include "interrupt.h"
+#include "clock.h"
+#include "apic.h"
+#include "smp.h"
 
 // Global scheduler instance
 scheduler_t scheduler;
 
-// Task queue for round-robin scheduling
-static task_t* task_queue_head = 0;
-static task_t* task_queue_tail = 0;
-
 /**
  * Initialize the scheduler system
  * مستوحى من Linux kernel 0.01 sched.c
  */
 void init_scheduler(void) {
     // Initialize scheduler structure
-    scheduler.current_task = 0;
-    scheduler.idle_task = 0;
     scheduler.state = SCHED_STOPPED;
     scheduler.policy = SCHED_ROUND_ROBIN;
     scheduler.time_slice = DEFAULT_TIME_SLICE;
@@ -31,12 +28,18 @@ void init_scheduler(void) {
     scheduler.stats.preemptions = 0;
     scheduler.stats.last_scheduled = 0;
     
-    // Initialize task queue
-    task_queue_head = 0;
-    task_queue_tail = 0;
+    // Initialize run queues (application processors get their idle
+    // tasks from smp_boot)
+    for (int cpu = 0; cpu < MAX_CPUS; cpu++) {
+        runqueue_init(&scheduler.cpu[cpu].rq);
+        memset(&scheduler.cpu[cpu].cfs, 0, sizeof(scheduler.cpu[cpu].cfs));
+        scheduler.cpu[cpu].idle_task = 0;
+        scheduler.cpu[cpu].ticks = 0;
+        scheduler.cpu[cpu].migrations = 0;
+    }
     
     // Create idle task
-    create_idle_task();
+    create_idle_task(0);
     
     // Setup scheduler timer
     setup_scheduler_timer();
@@ -49,26 +52,34 @@ void init_scheduler(void) {
  * مستوحى من Linux kernel 0.01 timer interrupt handler
  */
 void scheduler_tick(void) {
+    task_t* task = current_task;
+    cpu_rq_t* rq = this_rq();
+    
     scheduler.stats.timer_ticks++;
+    rq->ticks++;
     
-    if (scheduler.state != SCHED_RUNNING) {
+    if (scheduler.state != SCHED_RUNNING || !task) {
         return;
     }
     
-    // Update current task runtime
-    if (scheduler.current_task) {
-        update_task_runtime(scheduler.current_task, 1);
-        
-        // Decrease remaining time slice
-        if (scheduler.ticks_remaining > 0) {
-            scheduler.ticks_remaining--;
-        }
-        
-        // Check if time slice expired
-        if (scheduler.ticks_remaining == 0) {
-            scheduler.stats.preemptions++;
-            yield();
-        }
+    // Idle CPUs pull work as soon as they have nothing to run; busy ones
+    // also even out uneven queues now and then
+    if (smp_active && rq->ticks % SCHED_BALANCE_TICKS == 0) {
+        load_balance();
+    }
+    
+    // Update current task runtime and charge the tick to its slice
+    update_curr();
+    if (task->time_slice > 0) {
+        task->time_slice--;
+    }
+    scheduler.ticks_remaining = task->time_slice;
+    
+    if (can_preempt_current_task()) {
+        scheduler.stats.preemptions++;
+        schedule();
+    } else if (task->time_slice <= 0) {
+        calculate_time_slice(task);     // Nothing else to run
     }
 }
 
@@ -77,113 +88,403 @@ void scheduler_tick(void) {
  * مستوحى من Linux kernel 0.01
  */
 void yield(void) {
-    if (scheduler.current_task) {
-        scheduler.current_task->state = TASK_READY;
+    if (current_task) {
+        current_task->state = TASK_READY;
     }
     schedule();
 }
 
 /**
- * Add task to scheduler queue
+ * Reset a run queue to two empty arrays
  */
-void add_task_to_scheduler(task_t* task) {
-    if (!task) return;
+void runqueue_init(runqueue_t* rq) {
+    memset(rq, 0, sizeof(*rq));
+    rq->active = &rq->arrays[0];
+    rq->expired = &rq->arrays[1];
+}
+
+/**
+ * Append a task to the tail of its priority level
+ */
+static void prio_array_add(prio_array_t* array, task_t* task) {
+    int level = task->priority - MIN_PRIORITY;
+    task_t* head = array->queue[level];
     
-    task->next = 0;
-    task->state = TASK_READY;
+    if (!head) {
+        task->run_next = task;
+        task->run_prev = task;
+        array->queue[level] = task;
+        array->bitmap[level >> 5] |= 1u << (level & 31);
+    } else {
+        task->run_next = head;
+        task->run_prev = head->run_prev;
+        head->run_prev->run_next = task;
+        head->run_prev = task;
+    }
     
-    if (!task_queue_head) {
-        task_queue_head = task;
-        task_queue_tail = task;
+    task->run_array = array;
+    array->nr_active++;
+}
+
+/**
+ * Unlink a task from its priority level, clearing the bit when it empties
+ */
+static void prio_array_del(prio_array_t* array, task_t* task) {
+    int level = task->priority - MIN_PRIORITY;
+    
+    if (task->run_next == task) {
+        array->queue[level] = 0;
+        array->bitmap[level >> 5] &= ~(1u << (level & 31));
     } else {
-        task_queue_tail->next = task;
-        task_queue_tail = task;
+        task->run_prev->run_next = task->run_next;
+        task->run_next->run_prev = task->run_prev;
+        if (array->queue[level] == task) {
+            array->queue[level] = task->run_next;
+        }
     }
+    
+    task->run_array = 0;
+    array->nr_active--;
 }
 
 /**
- * Remove task from scheduler queue
+ * Queue a ready task: tasks with slice left go to the active array,
+ * tasks that used it up get a fresh slice and wait in the expired one
  */
-void remove_task_from_scheduler(task_t* task) {
-    if (!task || !task_queue_head) return;
+void runqueue_enqueue(runqueue_t* rq, task_t* task) {
+    if (task->run_array) {
+        return;
+    }
+    
+    if (task->time_slice <= 0) {
+        calculate_time_slice(task);
+        prio_array_add(rq->expired, task);
+    } else {
+        prio_array_add(rq->active, task);
+    }
+    rq->nr_running++;
+}
+
+/**
+ * Take a task off whichever array holds it
+ */
+void runqueue_dequeue(runqueue_t* rq, task_t* task) {
+    if (!task->run_array) {
+        return;
+    }
     
-    if (task_queue_head == task) {
-        task_queue_head = task->next;
-        if (task_queue_tail == task) {
-            task_queue_tail = 0;
+    prio_array_del(task->run_array, task);
+    rq->nr_running--;
+}
+
+/**
+ * Best queued task without dequeuing it: head of the first non-empty
+ * level in the active array. An empty active array swaps with the
+ * expired one, starting a new epoch in O(1)
+ */
+task_t* runqueue_peek(runqueue_t* rq) {
+    prio_array_t* array = rq->active;
+    uint32_t i;
+    
+    if (array->nr_active == 0) {
+        if (rq->expired->nr_active == 0) {
+            return 0;
         }
+        rq->active = rq->expired;
+        rq->expired = array;
+        array = rq->active;
+        rq->array_swaps++;
+    }
+    
+    for (i = 0; i < PRIO_BITMAP_WORDS; i++) {
+        if (array->bitmap[i]) {
+            return array->queue[i * 32 + bit_scan_forward(array->bitmap[i])];
+        }
+    }
+    return 0;
+}
+
+// Load weight per priority level (Linux's nice-to-weight table with
+// priority 20 as nice 0): each level is ~10% more or less CPU
+static const uint32_t prio_to_weight[40] = {
+    88761, 71755, 56483, 46273, 36291,
+    29154, 23254, 18705, 14949, 11916,
+     9548,  7620,  6100,  4904,  3906,
+     3121,  2501,  1991,  1586,  1277,
+     1024,   820,   655,   526,   423,
+      335,   272,   215,   172,   137,
+      110,    87,    70,    56,    45,
+       36,    29,    23,    18,    15,
+};
+
+static uint32_t task_weight(task_t* task) {
+    int prio = task->priority - MIN_PRIORITY;
+    
+    if (prio > 39) prio = 39;       // MAX_PRIORITY shares the lightest weight
+    return prio_to_weight[prio];
+}
+
+/**
+ * Insert a ready task into the vruntime tree. A task returning from
+ * sleep is placed no further back than half a latency period behind
+ * min_vruntime, so it runs soon without monopolising the CPU
+ */
+static void cfs_enqueue(cfs_rq_t* cfs, task_t* task) {
+    rb_node_t** link = &cfs->tasks.node;
+    rb_node_t* parent = NULL;
+    bool leftmost = true;
+    uint64_t floor = 0;
+    
+    if (task->on_fair_rq) {
         return;
     }
     
-    task_t* current = task_queue_head;
-    while (current->next && current->next != task) {
-        current = current->next;
+    if (cfs->min_vruntime > SCHED_LATENCY_NS / 2) {
+        floor = cfs->min_vruntime - SCHED_LATENCY_NS / 2;
+    }
+    if (task->vruntime < floor) {
+        task->vruntime = floor;
     }
     
-    if (current->next == task) {
-        current->next = task->next;
-        if (task_queue_tail == task) {
-            task_queue_tail = current;
+    // Equal keys go right so tasks with the same vruntime run in FIFO order
+    while (*link) {
+        parent = *link;
+        if (task->vruntime < rb_entry(parent, task_t, run_node)->vruntime) {
+            link = &parent->left;
+        } else {
+            link = &parent->right;
+            leftmost = false;
         }
     }
+    
+    rb_link_node(&task->run_node, parent, link);
+    rb_insert_color(&task->run_node, &cfs->tasks);
+    if (leftmost) {
+        cfs->leftmost = &task->run_node;
+    }
+    
+    task->on_fair_rq = true;
+    cfs->nr_running++;
+    cfs->load += task_weight(task);
+}
+
+/**
+ * Take a task out of the vruntime tree; the slice it is about to run
+ * is measured from here
+ */
+static void cfs_dequeue(cfs_rq_t* cfs, task_t* task) {
+    if (!task->on_fair_rq) {
+        return;
+    }
+    
+    if (cfs->leftmost == &task->run_node) {
+        cfs->leftmost = rb_next(&task->run_node);
+    }
+    rb_erase(&task->run_node, &cfs->tasks);
+    
+    task->on_fair_rq = false;
+    task->slice_start_runtime = task->sum_exec_runtime;
+    cfs->nr_running--;
+    cfs->load -= task_weight(task);
 }
 
-// Forward declarations for internal functions
-static task_t* get_next_round_robin_task(void);
-static task_t* get_next_fifo_task(void);
+/**
+ * Advance min_vruntime to the smaller of the running task's and the
+ * leftmost queued task's vruntime; it never moves backwards
+ */
+static void cfs_update_min_vruntime(cfs_rq_t* cfs, task_t* curr) {
+    uint64_t vruntime = curr->vruntime;
+    
+    if (cfs->leftmost) {
+        task_t* first = rb_entry(cfs->leftmost, task_t, run_node);
+        if (first->vruntime < vruntime) {
+            vruntime = first->vruntime;
+        }
+    }
+    if (vruntime > cfs->min_vruntime) {
+        cfs->min_vruntime = vruntime;
+    }
+}
 
 /**
- * Get next task to run based on scheduling policy
+ * Ideal slice for the running task: its weight's share of the latency
+ * period (stretched when too many tasks would get less than the minimum
+ * granularity)
  */
-task_t* get_next_task(void) {
-    switch (scheduler.policy) {
-        case SCHED_ROUND_ROBIN:
-            return get_next_round_robin_task();
-        case SCHED_PRIORITY:
-            return find_highest_priority_task();
-        case SCHED_FIFO:
-            return get_next_fifo_task();
-        default:
-            return scheduler.idle_task;
+static uint64_t cfs_slice(cfs_rq_t* cfs, task_t* curr) {
+    uint32_t weight = task_weight(curr);
+    uint64_t period = SCHED_LATENCY_NS;
+    uint64_t slice;
+    
+    if ((cfs->nr_running + 1) * SCHED_MIN_GRANULARITY_NS > period) {
+        period = (cfs->nr_running + 1) * SCHED_MIN_GRANULARITY_NS;
     }
+    
+    slice = div_u64(period * weight, cfs->load + weight);
+    return slice < SCHED_MIN_GRANULARITY_NS ? SCHED_MIN_GRANULARITY_NS : slice;
 }
 
 /**
- * Round-robin task selection
+ * Tasks a CPU has to run: queued ones plus the running one unless idle
  */
-static task_t* get_next_round_robin_task(void) {
-    if (!task_queue_head) {
-        return scheduler.idle_task;
+static unsigned int cpu_load(int cpu) {
+    cpu_rq_t* rq = &scheduler.cpu[cpu];
+    unsigned int load = rq->rq.nr_running + rq->cfs.nr_running;
+    
+    if (cpus[cpu].current && cpus[cpu].current != rq->idle_task) {
+        load++;
     }
+    return load;
+}
+
+/**
+ * A task was queued on cpu: wake that CPU if it is idle, otherwise wake
+ * some idle CPU so it can steal the waiting task
+ */
+static void kick_idle_cpu(int cpu) {
+    int this = smp_processor_id();
+    int i;
     
-    // Find next ready task
-    task_t* current = task_queue_head;
-    task_t* start = current;
+    if (!smp_active) return;
     
-    do {
-        if (current->state == TASK_READY) {
-            return current;
+    if (cpus[cpu].current == scheduler.cpu[cpu].idle_task) {
+        if (cpu != this) {
+            smp_send_reschedule(cpu);
         }
-        current = current->next ? current->next : task_queue_head;
-    } while (current != start);
+        return;
+    }
     
-    return scheduler.idle_task;
+    for (i = 0; i < MAX_CPUS; i++) {
+        if (i != this && cpus[i].online && cpus[i].current == scheduler.cpu[i].idle_task) {
+            smp_send_reschedule(i);
+            return;
+        }
+    }
 }
 
 /**
- * FIFO task selection
+ * Add task to scheduler queue (the run queue of task->cpu)
  */
-static task_t* get_next_fifo_task(void) {
-    task_t* current = task_queue_head;
+void add_task_to_scheduler(task_t* task) {
+    cpu_rq_t* rq;
+    
+    if (!task || is_idle_task(task)) return;
+    
+    rq = task_rq(task);
+    if (task->run_array || task->on_fair_rq) return;
+    
+    if (scheduler.policy == SCHED_FAIR) {
+        cfs_enqueue(&rq->cfs, task);
+    } else {
+        runqueue_enqueue(&rq->rq, task);
+    }
+    kick_idle_cpu(task->cpu);
+}
+
+/**
+ * Remove task from scheduler queue
+ */
+void remove_task_from_scheduler(task_t* task) {
+    if (!task) return;
+    
+    runqueue_dequeue(&task_rq(task)->rq, task);
+    cfs_dequeue(&task_rq(task)->cfs, task);
+}
+
+/**
+ * Get next task to run: the priority policies share the priority arrays
+ * (SCHED_FIFO only differs in never expiring the running task's slice),
+ * SCHED_FAIR takes the smallest vruntime
+ */
+task_t* get_next_task(void) {
+    cpu_rq_t* rq = this_rq();
+    
+    if (scheduler.policy == SCHED_FAIR) {
+        return rq->cfs.leftmost ?
+            rb_entry(rq->cfs.leftmost, task_t, run_node) : rq->idle_task;
+    }
+    return find_highest_priority_task();
+}
+
+/**
+ * CPU for a new task: the least loaded online one, this CPU on a tie
+ */
+int select_task_cpu(void) {
+    int best = smp_processor_id();
+    unsigned int best_load = cpu_load(best);
+    int cpu;
+    
+    for (cpu = 0; cpu < MAX_CPUS; cpu++) {
+        if (cpus[cpu].online && cpu_load(cpu) < best_load) {
+            best = cpu;
+            best_load = cpu_load(cpu);
+        }
+    }
+    return best;
+}
+
+/**
+ * Move a task that is not queued to another CPU's run queues. Each CPU
+ * has its own min_vruntime, so the task keeps its lag behind it rather
+ * than its absolute vruntime
+ */
+void set_task_cpu(task_t* task, int cpu) {
+    uint64_t src_min = task_rq(task)->cfs.min_vruntime;
+    uint64_t dst_min = scheduler.cpu[cpu].cfs.min_vruntime;
+    
+    if (task->vruntime >= src_min) {
+        task->vruntime = dst_min + (task->vruntime - src_min);
+    } else if (src_min - task->vruntime < dst_min) {
+        task->vruntime = dst_min - (src_min - task->vruntime);
+    } else {
+        task->vruntime = 0;
+    }
+    task->cpu = cpu;
+}
+
+/**
+ * Pull one queued task from the busiest CPU when it has at least
+ * SCHED_IMBALANCE more tasks than this one. Returns true if a task moved
+ */
+bool load_balance(void) {
+    uint32_t flags = irq_save();
+    int this = smp_processor_id();
+    unsigned int this_load = cpu_load(this);
+    unsigned int max_load = this_load + SCHED_IMBALANCE - 1;
+    int busiest = -1;
+    cpu_rq_t* rq;
+    task_t* task;
+    int cpu;
     
-    while (current) {
-        if (current->state == TASK_READY) {
-            return current;
+    for (cpu = 0; cpu < MAX_CPUS; cpu++) {
+        if (cpu != this && cpus[cpu].online && cpu_load(cpu) > max_load) {
+            busiest = cpu;
+            max_load = cpu_load(cpu);
         }
-        current = current->next;
     }
     
-    return scheduler.idle_task;
+    if (busiest < 0) {
+        irq_restore(flags);
+        return false;
+    }
+    
+    // The task that would run next there has waited longest
+    rq = &scheduler.cpu[busiest];
+    if (scheduler.policy == SCHED_FAIR) {
+        task = rq->cfs.leftmost ? rb_entry(rq->cfs.leftmost, task_t, run_node) : 0;
+    } else {
+        task = runqueue_peek(&rq->rq);
+    }
+    
+    if (task) {
+        remove_task_from_scheduler(task);
+        set_task_cpu(task, this);
+        add_task_to_scheduler(task);
+        scheduler.cpu[this].migrations++;
+    }
+    
+    irq_restore(flags);
+    return task != 0;
 }
 
 // Note: switch_to_task() function is already implemented in task.c
@@ -197,8 +498,16 @@ void set_task_priority(task_t* task, int priority) {
     if (priority < MIN_PRIORITY) priority = MIN_PRIORITY;
     if (priority > MAX_PRIORITY) priority = MAX_PRIORITY;
     
-    task->priority = priority;
-    calculate_time_slice(task);
+    // A queued task moves to its new level (or its new weight in the tree)
+    if (task->run_array || task->on_fair_rq) {
+        remove_task_from_scheduler(task);
+        task->priority = priority;
+        calculate_time_slice(task);
+        add_task_to_scheduler(task);
+    } else {
+        task->priority = priority;
+        calculate_time_slice(task);
+    }
 }
 
 /**
@@ -213,35 +522,74 @@ void calculate_time_slice(task_t* task) {
     if (slice < MIN_TIME_SLICE) slice = MIN_TIME_SLICE;
     if (slice > MAX_TIME_SLICE) slice = MAX_TIME_SLICE;
     
-    scheduler.time_slice = slice;
+    task->time_slice = slice;
 }
 
 /**
- * Update task runtime statistics
+ * Charge a task for delta_ns of CPU time
  */
-void update_task_runtime(task_t* task, unsigned int ticks) {
+void update_task_runtime(task_t* task, uint64_t delta) {
     if (!task) return;
     
-    // Note: runtime tracking would require adding runtime field to task_t
-    // For now, just update scheduler statistics
+    if (is_idle_task(task)) {
+        scheduler.stats.idle_time += delta;
+        return;
+    }
+    scheduler.stats.active_time += delta;
     
-    if (task == scheduler.idle_task) {
-        scheduler.stats.idle_time += ticks;
-    } else {
-        scheduler.stats.active_time += ticks;
+    // vruntime accrues under every policy so switching to SCHED_FAIR
+    // starts from real history
+    task->sum_exec_runtime += delta;
+    task->vruntime += div_u64(delta * NICE_0_WEIGHT, task_weight(task));
+    
+    if (scheduler.policy == SCHED_FAIR) {
+        cfs_update_min_vruntime(&task_rq(task)->cfs, task);
     }
 }
 
+/**
+ * Charge the running task for the time since its last accounting point
+ * (timer tick or context switch), measured with the TSC clock
+ */
+void update_curr(void) {
+    task_t* task = current_task;
+    uint64_t now;
+    
+    if (!task) return;
+    
+    now = ktime_get_ns();
+    update_task_runtime(task, now - task->exec_start);
+    task->exec_start = now;
+}
+
 /**
  * Start the scheduler
  */
 void start_scheduler(void) {
     scheduler.state = SCHED_RUNNING;
+}
+
+/**
+ * Switch scheduling policy, moving every queued task between the
+ * priority arrays and the vruntime tree
+ */
+void set_scheduling_policy(sched_policy_t policy) {
+    uint32_t flags = irq_save();
+    task_t* task;
     
-    // Start with idle task if no other tasks
-    if (!scheduler.current_task) {
-        scheduler.current_task = scheduler.idle_task;
+    scheduler.policy = policy;
+    if (policy == SCHED_FAIR && current_task) {
+        cfs_update_min_vruntime(&this_rq()->cfs, current_task);
+    }
+    
+    for (task = task_list; task; task = task->next) {
+        if (task->run_array || task->on_fair_rq) {
+            remove_task_from_scheduler(task);
+            add_task_to_scheduler(task);
+        }
     }
+    
+    irq_restore(flags);
 }
 
 /**
@@ -252,17 +600,24 @@ void stop_scheduler(void) {
 }
 
 /**
- * Create idle task
+ * Create the idle task of a CPU
  */
-void create_idle_task(void) {
-    scheduler.idle_task = create_task("idle", idle_task_function);
-    if (scheduler.idle_task) {
-        scheduler.idle_task->state = TASK_READY;
-        // Note: priority setting would require adding priority field to task_t
-        // Idle task created successfully
-    } else {
-        // Failed to create idle task
+task_t* create_idle_task(int cpu) {
+    uint32_t flags = irq_save();
+    task_t* idle = create_task("idle", idle_task_function);
+    
+    if (idle) {
+        // The idle task runs only when the run queue is empty, so it
+        // stays out of it (taken out before another CPU could steal it)
+        remove_task_from_scheduler(idle);
+        idle->priority = MAX_PRIORITY;
+        idle->state = TASK_READY;
+        idle->cpu = cpu;
+        scheduler.cpu[cpu].idle_task = idle;
     }
+    
+    irq_restore(flags);
+    return idle;
 }
 
 /**
@@ -270,44 +625,63 @@ void create_idle_task(void) {
  */
 void idle_task_function(void) {
     while (1) {
-        // Simple idle loop
-        asm volatile("hlt"); // Halt until next interrupt
+        // Steal from the busiest CPU and run it; the idle task only
+        // continues below when nothing is queued here
+        if (smp_active) {
+            load_balance();
+            schedule();
+        }
+        
+        // Free exited tasks, reclaim zones below their low watermark, then
+        // zero pages ahead of demand; halt only when there is nothing left to do
+        if (!reap_zombies() && !zone_reclaim() && !zero_pool_refill()) {
+            tick_nohz_idle();   // Halt with the periodic tick stopped
+        }
     }
 }
 
 /**
- * Find highest priority ready task
+ * Find highest priority ready task - O(1) bitmap lookup
  */
 task_t* find_highest_priority_task(void) {
-    task_t* best_task = 0;
-    int highest_priority = MAX_PRIORITY + 1;
-    
-    task_t* current = task_queue_head;
-    while (current) {
-        if (current->state == TASK_READY && current->priority < highest_priority) {
-            highest_priority = current->priority;
-            best_task = current;
-        }
-        current = current->next;
-    }
+    cpu_rq_t* rq = this_rq();
+    task_t* best_task = runqueue_peek(&rq->rq);
     
-    return best_task ? best_task : scheduler.idle_task;
+    return best_task ? best_task : rq->idle_task;
 }
 
 /**
  * Setup scheduler timer
  */
 void setup_scheduler_timer(void) {
-    // Timer setup will be integrated with interrupt system
-    // This is a placeholder for timer configuration
+    // The local APIC timer replaces the PIT when the IO-APIC routes IRQs
+    if (apic_enabled()) {
+        lapic_timer_periodic();
+        return;
+    }
+    
+    // IRQ0 at HZ instead of the BIOS default 18.2 Hz, so a tick really
+    // is NSEC_PER_TICK (also restores the periodic tick after nohz idle)
+    outb(PIT_COMMAND_PORT, PIT_MODE_PERIODIC);
+    outb(PIT_CHANNEL0_PORT, PIT_DIVISOR & 0xFF);
+    outb(PIT_CHANNEL0_PORT, (PIT_DIVISOR >> 8) & 0xFF);
 }
 
 /**
  * Print scheduler statistics
  */
 void print_scheduler_stats(void) {
-    // Scheduler statistics logged
-    // Total switches, idle time, active time logged
+    update_curr();
+    
+    print_string("Scheduler: switches ");
+    print_number(scheduler.stats.total_switches);
+    print_string(", preemptions ");
+    print_number(scheduler.stats.preemptions);
+    print_string(", busy ");
+    print_number((uint32_t)div_u64(scheduler.stats.active_time, NSEC_PER_MSEC));
+    print_string(" ms, idle ");
+    print_number((uint32_t)div_u64(scheduler.stats.idle_time, NSEC_PER_MSEC));
+    print_string(" ms\n");
 }
 
 /**
@@ -318,21 +692,41 @@ int is_scheduler_running(void) {
 }
 
 /**
- * Simple context switch implementation
- * In a real system, this would be in assembly
+ * Should the best queued task replace the current one?
+ * A blocked, exiting or yielding task always gives way; otherwise a
+ * better priority or an expired slice (except under SCHED_FIFO) wins,
+ * and under SCHED_FAIR the vruntime rules decide
  */
-void switch_context(task_t* from, task_t* to) {
-    // Simplified context switch
-    // In a real implementation, this would save/restore all registers
-    if (from) {
-        // Save current context (simplified)
-        from->esp = 0; // Placeholder
-    }
+int can_preempt_current_task(void) {
+    task_t* next = get_next_task();
+    task_t* idle = this_rq()->idle_task;
     
-    if (to) {
-        // Restore new context (simplified)
-        // Load new stack pointer, etc.
+    if (!current_task || !next || next == current_task) {
+        return 0;
+    }
+    if (current_task->state == TASK_SLEEPING || current_task->state == TASK_ZOMBIE) {
+        return 1;
+    }
+    if (next == idle) {
+        return 0;
+    }
+    if (current_task == idle || current_task->state == TASK_READY) {
+        return 1;
     }
+    if (scheduler.policy == SCHED_FAIR) {
+        // Preempt once the ideal slice is used up, or when the leftmost
+        // task has fallen far enough behind (e.g. just woke up)
+        uint64_t ran = current_task->sum_exec_runtime - current_task->slice_start_runtime;
+        
+        if (ran >= cfs_slice(&this_rq()->cfs, current_task)) {
+            return 1;
+        }
+        return current_task->vruntime > next->vruntime + SCHED_WAKEUP_GRANULARITY_NS;
+    }
+    if (next->priority < current_task->priority) {
+        return 1;
+    }
+    return current_task->time_slice <= 0 && scheduler.policy != SCHED_FIFO;
 }
 
 /**
@@ -340,5 +734,8 @@ void switch_context(task_t* from, task_t* to) {
  */
 void force_schedule(void) {
     scheduler.ticks_remaining = 0;
+    if (current_task) {
+        current_task->time_slice = 0;
+    }
     schedule();
 }
\ No newline at end of file
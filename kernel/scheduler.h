@@ -2,6 +2,7 @@
 #define SCHEDULER_H
 
 #include "task.h"
+#include "smp.h"
 
 // Scheduler constants inspired by Linux 0.01
 #define HZ 100                    // Timer frequency (100 Hz)
@@ -10,11 +11,72 @@
 #define MAX_PRIORITY 40          // Maximum priority value
 #define MIN_PRIORITY 0           // Minimum priority value
 
+// 8253/8254 PIT channel 0 drives IRQ0
+#define PIT_BASE_FREQUENCY 1193182
+#define PIT_CHANNEL0_PORT 0x40
+#define PIT_COMMAND_PORT 0x43
+#define PIT_DIVISOR (PIT_BASE_FREQUENCY / HZ)
+#define PIT_MODE_PERIODIC 0x36    // Channel 0, lobyte/hibyte, mode 3 (square wave)
+#define PIT_MODE_ONESHOT 0x30     // Channel 0, lobyte/hibyte, mode 0 (one IRQ at zero)
+#define PIT_LATCH_COUNT 0x00      // Channel 0, latch the current count
+#define NOHZ_MAX_TICKS (0xFFFF / PIT_DIVISOR)   // Longest one-shot the 16-bit counter holds
+
 // Time slice constants
 #define DEFAULT_TIME_SLICE 10    // Default time slice in timer ticks
 #define MIN_TIME_SLICE 1         // Minimum time slice
 #define MAX_TIME_SLICE 50        // Maximum time slice
 
+// O(1) run queues: one FIFO per priority level (lower value runs first),
+// a bitmap of non-empty levels found with bsf, and active/expired arrays
+// swapped when the active one drains so slice refills never walk the tasks
+#define PRIO_LEVELS (MAX_PRIORITY - MIN_PRIORITY + 1)
+#define PRIO_BITMAP_WORDS ((PRIO_LEVELS + 31) / 32)
+
+typedef struct prio_array {
+    unsigned int nr_active;                 // Tasks queued in this array
+    uint32_t bitmap[PRIO_BITMAP_WORDS];     // Bit set = level non-empty
+    task_t* queue[PRIO_LEVELS];             // Circular list head per level
+} prio_array_t;
+
+typedef struct {
+    unsigned int nr_running;        // Tasks queued in both arrays
+    prio_array_t* active;           // Tasks with slice left
+    prio_array_t* expired;          // Tasks waiting for the next epoch
+    prio_array_t arrays[2];
+    unsigned int array_swaps;       // Epochs completed
+} runqueue_t;
+
+// Fair scheduling (SCHED_FAIR): each task accrues vruntime, its CPU time
+// in ns scaled by NICE_0_WEIGHT / weight(priority); ready tasks sit in a
+// red-black tree keyed by vruntime and the leftmost one runs next
+#define NSEC_PER_TICK (1000000000u / HZ)
+#define NICE_0_WEIGHT 1024                      // Weight of priority 20
+#define SCHED_LATENCY_NS 60000000ull            // Period every ready task runs in
+#define SCHED_MIN_GRANULARITY_NS 10000000ull    // Shortest slice before preemption
+#define SCHED_WAKEUP_GRANULARITY_NS 10000000ull // vruntime lead a waker needs to preempt
+
+typedef struct {
+    rb_root_t tasks;                // Ready tasks ordered by vruntime
+    rb_node_t* leftmost;            // Cached smallest vruntime (next to run)
+    uint64_t min_vruntime;          // Monotonic floor for placing woken tasks
+    unsigned int nr_running;        // Tasks in the tree
+    uint32_t load;                  // Sum of their weights
+} cfs_rq_t;
+
+// Per-CPU run queues: every CPU picks from its own queues, and an idle
+// CPU pulls a queued task from the busiest one when the loads differ by
+// at least two (moving one task then never just swaps the imbalance)
+#define SCHED_BALANCE_TICKS 10   // Busy CPUs rebalance every 100 ms
+#define SCHED_IMBALANCE 2
+
+typedef struct {
+    runqueue_t rq;                  // Ready tasks (the idle task is never queued)
+    cfs_rq_t cfs;                   // Ready tasks under SCHED_FAIR
+    task_t* idle_task;              // Runs when both are empty
+    unsigned int ticks;             // Local timer ticks
+    unsigned int migrations;        // Tasks pulled onto this CPU
+} cpu_rq_t;
+
 // Scheduler states
 typedef enum {
     SCHED_RUNNING,    // Scheduler is active
@@ -26,14 +88,15 @@ typedef enum {
 typedef enum {
     SCHED_ROUND_ROBIN,  // Round-robin scheduling
     SCHED_PRIORITY,     // Priority-based scheduling
-    SCHED_FIFO          // First-in-first-out
+    SCHED_FIFO,         // First-in-first-out
+    SCHED_FAIR          // vruntime-ordered fair share
 } sched_policy_t;
 
 // Scheduler statistics
 typedef struct {
     unsigned int total_switches;     // Total context switches
-    unsigned int idle_time;          // Time spent in idle
-    unsigned int active_time;        // Time spent running tasks
+    uint64_t idle_time;              // ns spent in idle
+    uint64_t active_time;            // ns spent running tasks
     unsigned int timer_ticks;        // Total timer ticks
     unsigned int preemptions;        // Number of preemptions
     task_t* last_scheduled;          // Last scheduled task
@@ -41,35 +104,65 @@ typedef struct {
 
 // Main scheduler structure
 typedef struct {
-    task_t* current_task;           // Currently running task
-    task_t* idle_task;              // Idle task
     scheduler_state_t state;        // Scheduler state
     sched_policy_t policy;          // Scheduling policy
     unsigned int time_slice;        // Current time slice
     unsigned int ticks_remaining;   // Remaining ticks for current task
     scheduler_stats_t stats;        // Scheduler statistics
+    cpu_rq_t cpu[MAX_CPUS];         // Run queues, indexed like cpus[]
 } scheduler_t;
 
 // Global scheduler instance
 extern scheduler_t scheduler;
 
+// Run queues of the current CPU and of the CPU a task belongs to
+// (call with interrupts disabled)
+static inline cpu_rq_t* this_rq(void) {
+    return &scheduler.cpu[smp_processor_id()];
+}
+
+static inline cpu_rq_t* task_rq(task_t* task) {
+    return &scheduler.cpu[task->cpu];
+}
+
+static inline bool is_idle_task(task_t* task) {
+    return task == task_rq(task)->idle_task;
+}
+
+// Running on its CPU right now (possibly still switching away)
+static inline bool task_running(task_t* task) {
+    return cpus[task->cpu].current == task;
+}
+
 // Core scheduler functions
 void init_scheduler(void);
 void schedule(void);
 void scheduler_tick(void);
 void yield(void);
 
+// Run queue primitives (also driven directly by the benchmark)
+void runqueue_init(runqueue_t* rq);
+void runqueue_enqueue(runqueue_t* rq, task_t* task);
+void runqueue_dequeue(runqueue_t* rq, task_t* task);
+task_t* runqueue_peek(runqueue_t* rq);
+
 // Task management functions
 void add_task_to_scheduler(task_t* task);
 void remove_task_from_scheduler(task_t* task);
 task_t* get_next_task(void);
 void switch_to_task(task_t* task);
 
+// SMP load balancing
+int select_task_cpu(void);
+void set_task_cpu(task_t* task, int cpu);
+bool load_balance(void);
+
 // Priority and time slice management
 void set_task_priority(task_t* task, int priority);
 void adjust_priority(task_t* task);
 void calculate_time_slice(task_t* task);
-void update_task_runtime(task_t* task, unsigned int ticks);
+void update_task_runtime(task_t* task, uint64_t delta_ns);
+void update_curr(void);
 
 // Scheduler control functions
 void start_scheduler(void);
@@ -85,13 +178,11 @@ scheduler_stats_t get_scheduler_stats(void);
 void print_task_queue(void);
 
 // Idle task functions
-void create_idle_task(void);
+task_t* create_idle_task(int cpu);
 void idle_task_function(void);
 
-// Context switching (implemented in assembly)
-extern void switch_context(task_t* from, task_t* to);
-extern void save_context(task_t* task);
-extern void restore_context(task_t* task);
+// Context switching: switch_context() lives in switch_asm.s and is
+// declared in task.h next to switch_to_task()
 
 // Timer integration
 void setup_scheduler_timer(void);
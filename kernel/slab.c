@@ -0,0 +1,349 @@
+#include "slab.h"
+#include "memory.h"
+#include "kernel.h"
+#include "interrupt.h"
+
+// الذاكرة المؤقتة لواصفات الذاكرة المؤقتة نفسها (مثل cache_cache في Linux)
+static kmem_cache_t cache_cache;
+static kmem_cache_t* cache_list = NULL;
+
+// ذواكر فئات أحجام kmalloc
+static kmem_cache_t* kmalloc_caches[KMALLOC_CLASSES];
+static const char* kmalloc_names[KMALLOC_CLASSES] = {
+    "kmalloc-8", "kmalloc-16", "kmalloc-32", "kmalloc-64", "kmalloc-128",
+    "kmalloc-256", "kmalloc-512", "kmalloc-1024", "kmalloc-2048"
+};
+
+// دوال داخلية
+static void cache_setup(kmem_cache_t* cache, const char* name, uint32_t size,
+                        uint32_t align, uint32_t flags, kmem_ctor_t ctor);
+static slab_t* cache_grow(kmem_cache_t* cache);
+static void slab_release(kmem_cache_t* cache, slab_t* slab);
+
+// إضافة slab إلى رأس قائمة
+static void slab_list_add(slab_t** list, slab_t* slab) {
+    slab->prev = NULL;
+    slab->next = *list;
+    if (*list) {
+        (*list)->prev = slab;
+    }
+    *list = slab;
+}
+
+// إزالة slab من قائمة
+static void slab_list_del(slab_t** list, slab_t* slab) {
+    if (slab->prev) {
+        slab->prev->next = slab->next;
+    } else {
+        *list = slab->next;
+    }
+    if (slab->next) {
+        slab->next->prev = slab->prev;
+    }
+    slab->next = NULL;
+    slab->prev = NULL;
+}
+
+// دالة تهيئة مخصص slab
+void init_slab_allocator(void) {
+    uint32_t i;
+    
+    cache_list = NULL;
+    cache_setup(&cache_cache, "kmem_cache", sizeof(kmem_cache_t), 0, SLAB_HWCACHE_ALIGN, NULL);
+    
+    // كل فئة محاذاة لحجمها حتى حد سطر الذاكرة المؤقتة
+    for (i = 0; i < KMALLOC_CLASSES; i++) {
+        uint32_t size = 1u << (i + KMALLOC_MIN_SHIFT);
+        kmalloc_caches[i] = kmem_cache_create(kmalloc_names[i], size,
+                                              size < CACHE_LINE_SIZE ? size : CACHE_LINE_SIZE,
+                                              SLAB_KMALLOC, NULL);
+    }
+    
+    // slabs الفارغة المحتفظ بها أول ما يُسترجع عند ضغط الذاكرة
+    register_reclaim_hook(kmem_cache_reap);
+    
+    print_string("Slab Allocator: تم تهيئة مخصص slab\n");
+}
+
+// حساب تخطيط slab وإضافة الذاكرة المؤقتة إلى القائمة العامة
+static void cache_setup(kmem_cache_t* cache, const char* name, uint32_t size,
+                        uint32_t align, uint32_t flags, kmem_ctor_t ctor) {
+    uint32_t i;
+    uint32_t slab_bytes;
+    
+    for (i = 0; i < KMEM_CACHE_NAME_LEN - 1 && name[i]; i++) {
+        cache->name[i] = name[i];
+    }
+    cache->name[i] = '\0';
+    
+    if (align < sizeof(void*)) {
+        align = sizeof(void*);
+    }
+    if ((flags & SLAB_HWCACHE_ALIGN) && align < CACHE_LINE_SIZE) {
+        align = CACHE_LINE_SIZE;
+    }
+    if (size < sizeof(void*)) {
+        size = sizeof(void*);
+    }
+    
+    cache->object_size = size;
+    cache->align = align;
+    cache->size = align_address(size, align);
+    cache->first_offset = align_address(sizeof(slab_t), align);
+    cache->flags = flags;
+    cache->ctor = ctor;
+    
+    // أصغر رتبة تتسع لـ SLAB_MIN_OBJECTS كائنات
+    for (cache->order = 0; cache->order < SLAB_MAX_ORDER; cache->order++) {
+        slab_bytes = PAGE_SIZE << cache->order;
+        if ((slab_bytes - cache->first_offset) / cache->size >= SLAB_MIN_OBJECTS) {
+            break;
+        }
+    }
+    slab_bytes = PAGE_SIZE << cache->order;
+    cache->objects_per_slab = (slab_bytes > cache->first_offset)
+                              ? (slab_bytes - cache->first_offset) / cache->size : 0;
+    
+    cache->partial = NULL;
+    cache->full = NULL;
+    cache->empty = NULL;
+    memset(&cache->stats, 0, sizeof(kmem_cache_stats_t));
+    
+    cache->next = cache_list;
+    cache_list = cache;
+}
+
+// دالة إنشاء ذاكرة مؤقتة لكائنات بحجم ثابت
+kmem_cache_t* kmem_cache_create(const char* name, uint32_t size, uint32_t align,
+                                uint32_t flags, kmem_ctor_t ctor) {
+    kmem_cache_t* cache;
+    
+    if (name == NULL || size == 0) {
+        return NULL;
+    }
+    
+    cache = (kmem_cache_t*)kmem_cache_alloc(&cache_cache);
+    if (cache == NULL) {
+        return NULL;
+    }
+    
+    cache_setup(cache, name, size, align, flags, ctor);
+    if (cache->objects_per_slab == 0) {
+        // الكائن أكبر من أكبر slab
+        cache_list = cache->next;
+        kmem_cache_free(&cache_cache, cache);
+        return NULL;
+    }
+    
+    return cache;
+}
+
+// إنشاء slab جديد: صفحات من buddy ثم ربط الكائنات في قائمة حرة
+static slab_t* cache_grow(kmem_cache_t* cache) {
+    slab_t* slab = (slab_t*)alloc_pages(cache->order);
+    uint8_t* object;
+    uint32_t i;
+    
+    if (slab == NULL) {
+        return NULL;
+    }
+    
+    slab->next = NULL;
+    slab->prev = NULL;
+    slab->cache = cache;
+    slab->in_use = 0;
+    slab->free_list = NULL;
+    get_page_info(slab)->flags |= PG_SLAB;
+    
+    // ربط الكائنات بترتيب تصاعدي
+    object = (uint8_t*)slab + cache->first_offset + (cache->objects_per_slab - 1) * cache->size;
+    for (i = 0; i < cache->objects_per_slab; i++) {
+        if (cache->ctor) {
+            cache->ctor(object);
+        }
+        *(void**)object = slab->free_list;
+        slab->free_list = object;
+        object -= cache->size;
+    }
+    
+    cache->stats.slabs++;
+    cache->stats.total_objects += cache->objects_per_slab;
+    
+    return slab;
+}
+
+// دالة تخصيص كائن
+void* kmem_cache_alloc(kmem_cache_t* cache) {
+    slab_t* slab;
+    void* object;
+    uint32_t flags;
+    
+    if (cache == NULL) {
+        return NULL;
+    }
+    
+    flags = irq_save();
+    slab = cache->partial;
+    if (slab != NULL) {
+        cache->stats.hits++;
+    } else if (cache->empty != NULL) {
+        slab = cache->empty;
+        cache->empty = NULL;
+        slab_list_add(&cache->partial, slab);
+        cache->stats.hits++;
+    } else {
+        slab = cache_grow(cache);
+        if (slab == NULL) {
+            irq_restore(flags);
+            return NULL; // لا توجد صفحات حرة
+        }
+        slab_list_add(&cache->partial, slab);
+        cache->stats.misses++;
+    }
+    
+    object = slab->free_list;
+    slab->free_list = *(void**)object;
+    slab->in_use++;
+    
+    if (slab->in_use == cache->objects_per_slab) {
+        slab_list_del(&cache->partial, slab);
+        slab_list_add(&cache->full, slab);
+    }
+    
+    cache->stats.allocs++;
+    cache->stats.active_objects++;
+    
+    irq_restore(flags);
+    return object;
+}
+
+// دالة تحرير كائن: رأس slab يُحسب من العنوان لأن كتل buddy محاذاة لحجمها
+void kmem_cache_free(kmem_cache_t* cache, void* object) {
+    slab_t* slab;
+    uint32_t flags;
+    
+    if (cache == NULL || object == NULL) {
+        return;
+    }
+    
+    slab = (slab_t*)((uint32_t)object & ~((PAGE_SIZE << cache->order) - 1));
+    if (slab->cache != cache) {
+        return; // الكائن لا ينتمي لهذه الذاكرة المؤقتة
+    }
+    
+    flags = irq_save();
+    
+    if (slab->in_use == cache->objects_per_slab) {
+        slab_list_del(&cache->full, slab);
+        slab_list_add(&cache->partial, slab);
+    }
+    
+    *(void**)object = slab->free_list;
+    slab->free_list = object;
+    slab->in_use--;
+    
+    cache->stats.frees++;
+    cache->stats.active_objects--;
+    
+    // slab فارغ: يُحتفظ بواحد فقط وتُعاد البقية إلى buddy
+    if (slab->in_use == 0) {
+        slab_list_del(&cache->partial, slab);
+        if (cache->empty == NULL) {
+            cache->empty = slab;
+        } else {
+            slab_release(cache, slab);
+        }
+    }
+    
+    irq_restore(flags);
+}
+
+// إعادة slab فارغ إلى buddy
+static void slab_release(kmem_cache_t* cache, slab_t* slab) {
+    cache->stats.slabs--;
+    cache->stats.total_objects -= cache->objects_per_slab;
+    slab->cache = NULL;
+    get_page_info(slab)->flags &= ~PG_SLAB;
+    free_pages(slab, cache->order);
+}
+
+// دالة استرجاع: تحرير slab الفارغ المحتفظ به في كل ذاكرة مؤقتة
+// تعيد عدد الصفحات المحررة
+uint32_t kmem_cache_reap(uint32_t pages) {
+    kmem_cache_t* cache;
+    uint32_t freed = 0;
+    
+    for (cache = cache_list; cache != NULL && freed < pages; cache = cache->next) {
+        if (cache->empty != NULL) {
+            slab_release(cache, cache->empty);
+            cache->empty = NULL;
+            freed += 1u << cache->order;
+        }
+    }
+    
+    return freed;
+}
+
+// دالة إيجاد الذاكرة المؤقتة المالكة لكائن
+// رأس الكتلة هو أول صفحة محاذاة رتبتها تساوي الرتبة المسجلة فيها
+kmem_cache_t* kmem_cache_of(void* object) {
+    uint32_t address = (uint32_t)object;
+    uint32_t order;
+    page_t* head;
+    
+    for (order = 0; order <= SLAB_MAX_ORDER; order++) {
+        head = get_page_info((void*)(address & ~((PAGE_SIZE << order) - 1)));
+        if (head == NULL) {
+            return NULL;
+        }
+        if (head->order == order) {
+            if (head->status != PAGE_USED || !(head->flags & PG_SLAB)) {
+                return NULL;
+            }
+            return ((slab_t*)(address & ~((PAGE_SIZE << order) - 1)))->cache;
+        }
+    }
+    
+    return NULL;
+}
+
+// دالة اختيار فئة الحجم: أصغر قوة للعدد 2 تتسع للطلب
+kmem_cache_t* kmalloc_cache_for(uint32_t size) {
+    uint32_t shift;
+    
+    if (size == 0 || size > KMALLOC_MAX_SIZE) {
+        return NULL;
+    }
+    
+    shift = (size <= (1u << KMALLOC_MIN_SHIFT)) ? KMALLOC_MIN_SHIFT
+                                                 : bit_scan_reverse(size - 1) + 1;
+    return kmalloc_caches[shift - KMALLOC_MIN_SHIFT];
+}
+
+// دالة الحصول على إحصائيات ذاكرة مؤقتة
+kmem_cache_stats_t* kmem_cache_get_stats(kmem_cache_t* cache) {
+    return cache ? &cache->stats : NULL;
+}
+
+// دالة طباعة معلومات كل الذواكر المؤقتة
+void print_slab_info(void) {
+    kmem_cache_t* cache;
+    
+    print_string("\n=== Slab Caches ===\n");
+    for (cache = cache_list; cache != NULL; cache = cache->next) {
+        print_string(cache->name);
+        print_string(": objs ");
+        print_number(cache->stats.active_objects);
+        print_string("/");
+        print_number(cache->stats.total_objects);
+        print_string(" size ");
+        print_number(cache->size);
+        print_string(" slabs ");
+        print_number(cache->stats.slabs);
+        print_string(" hits ");
+        print_number(cache->stats.hits);
+        print_string(" misses ");
+        print_number(cache->stats.misses);
+        print_string("\n");
+    }
+}
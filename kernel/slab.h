@@ -0,0 +1,79 @@
+#ifndef SLAB_H
+#define SLAB_H
+
+#include "kernel.h"
+
+// ثوابت مخصص slab
+#define CACHE_LINE_SIZE 64          // حجم سطر الذاكرة المؤقتة
+#define SLAB_MIN_OBJECTS 8          // أقل عدد كائنات في slab واحد
+#define SLAB_MAX_ORDER 3            // أكبر slab = 8 صفحات
+#define KMEM_CACHE_NAME_LEN 16
+
+// خيارات إنشاء الذاكرة المؤقتة
+#define SLAB_HWCACHE_ALIGN 0x01     // محاذاة الكائنات على سطر الذاكرة المؤقتة
+#define SLAB_KMALLOC 0x02           // ذاكرة مؤقتة لفئة حجم في kmalloc
+
+// فئات أحجام kmalloc: قوى العدد 2 من 8 إلى 2048 بايت
+#define KMALLOC_MIN_SHIFT 3
+#define KMALLOC_MAX_SHIFT 11
+#define KMALLOC_MAX_SIZE (1 << KMALLOC_MAX_SHIFT)
+#define KMALLOC_CLASSES (KMALLOC_MAX_SHIFT - KMALLOC_MIN_SHIFT + 1)
+
+// نوع دالة تهيئة الكائن (تُستدعى مرة عند إنشاء slab)
+typedef void (*kmem_ctor_t)(void* object);
+
+// رأس slab - يوضع في بداية صفحاته
+typedef struct slab {
+    struct slab* next;          // slab التالي في قائمته
+    struct slab* prev;          // slab السابق في قائمته
+    struct kmem_cache* cache;   // الذاكرة المؤقتة المالكة
+    void* free_list;            // قائمة الكائنات الحرة في هذا slab
+    uint32_t in_use;            // عدد الكائنات المستخدمة
+} slab_t;
+
+// إحصائيات الذاكرة المؤقتة
+typedef struct {
+    uint32_t active_objects;    // الكائنات المستخدمة حالياً
+    uint32_t total_objects;     // سعة كل slabs
+    uint32_t slabs;             // عدد slabs
+    uint32_t allocs;            // إجمالي التخصيصات
+    uint32_t frees;             // إجمالي التحريرات
+    uint32_t hits;              // تخصيصات خُدمت من slab موجود
+    uint32_t misses;            // تخصيصات احتاجت slab جديداً
+} kmem_cache_stats_t;
+
+// الذاكرة المؤقتة للكائنات ذات الحجم الثابت
+typedef struct kmem_cache {
+    char name[KMEM_CACHE_NAME_LEN]; // اسم الذاكرة المؤقتة
+    uint32_t object_size;       // الحجم المطلوب
+    uint32_t size;              // الحجم بعد المحاذاة (المسافة بين الكائنات)
+    uint32_t align;             // محاذاة الكائنات
+    uint32_t order;             // رتبة صفحات كل slab
+    uint32_t objects_per_slab;  // عدد الكائنات في slab
+    uint32_t first_offset;      // موضع أول كائن بعد رأس slab
+    uint32_t flags;             // خيارات الإنشاء
+    kmem_ctor_t ctor;           // دالة التهيئة
+    slab_t* partial;            // slabs فيها كائنات حرة ومستخدمة
+    slab_t* full;               // slabs ممتلئة
+    slab_t* empty;              // slab فارغ واحد محتفظ به
+    kmem_cache_stats_t stats;   // الإحصائيات
+    struct kmem_cache* next;    // الذاكرة المؤقتة التالية في القائمة العامة
+} kmem_cache_t;
+
+// دوال مخصص slab
+void init_slab_allocator(void);
+kmem_cache_t* kmem_cache_create(const char* name, uint32_t size, uint32_t align,
+                                uint32_t flags, kmem_ctor_t ctor);
+void* kmem_cache_alloc(kmem_cache_t* cache);
+void kmem_cache_free(kmem_cache_t* cache, void* object);
+kmem_cache_t* kmem_cache_of(void* object);
+uint32_t kmem_cache_reap(uint32_t pages);
+
+// فئات أحجام kmalloc
+kmem_cache_t* kmalloc_cache_for(uint32_t size);
+
+// دوال المراقبة والإحصائيات
+kmem_cache_stats_t* kmem_cache_get_stats(kmem_cache_t* cache);
+void print_slab_info(void);
+
+#endif // SLAB_H
@@ -0,0 +1,246 @@
+#include "smp.h"
+#include "acpi.h"
+#include "apic.h"
+#include "clock.h"
+#include "interrupt.h"
+#include "memory.h"
+#include "paging.h"
+#include "scheduler.h"
+#include "task.h"
+
+// المعالج 0 هو BSP: يعمل منذ الإقلاع
+cpu_t cpus[MAX_CPUS] = { [0] = { .self = &cpus[0], .id = 0, .online = true } };
+int nr_cpus_online = 1;
+volatile bool smp_active = false;
+spinlock_t kernel_lock;
+
+// رقم LAPIC -> فهرس في cpus (يحتاجه المعالج الإضافي قبل تحميل gs فقط)
+static uint8_t apic_to_cpu[256];
+
+// مؤشر GDT (نفس هيئة idt_ptr_t)
+typedef struct {
+    uint16_t limit;
+    uint32_t base;
+} __attribute__((packed)) gdt_ptr_t;
+
+static uint64_t gdt[GDT_ENTRIES];
+static gdt_ptr_t gdt_ptr;
+
+// شيفرة الوضع الحقيقي في smp_trampoline.s
+extern uint8_t smp_trampoline_start[];
+extern uint8_t smp_trampoline_end[];
+
+// يقرؤها ap_protected قبل أن يكون للمعالج مكدس (معالج واحد يُقلع في كل مرة)
+uint32_t smp_boot_cr0;
+uint32_t smp_boot_cr3;
+uint32_t smp_boot_cr4;
+uint32_t smp_boot_stack;
+
+// سياق الإقلاع لكل معالج إضافي: switch_context يحفظ فيه مكدس الإقلاع ولا يعود إليه
+static task_t ap_boot_task[MAX_CPUS];
+
+// واصف مقطع: limit بالبايت إلا مع G في flags (الوحدة 4KB)
+static uint64_t gdt_descriptor(uint32_t base, uint32_t limit, uint8_t access, uint8_t flags) {
+    return (limit & 0xFFFF) |
+           ((uint64_t)(base & 0xFFFFFF) << 16) |
+           ((uint64_t)access << 40) |
+           ((uint64_t)((limit >> 16) & 0xF) << 48) |
+           ((uint64_t)(flags & 0xF) << 52) |
+           ((uint64_t)(base >> 24) << 56);
+}
+
+// تحميل GDT وإعادة تحميل المقاطع، ثم gs على بيانات المعالج id
+static void load_percpu_segment(int id) {
+    asm volatile("lgdt %0\n\t"
+                 "ljmp %1, $1f\n"
+                 "1:" : : "m" (gdt_ptr), "i" (GDT_KERNEL_CODE) : "memory");
+    asm volatile("movw %w0, %%ds\n\t"
+                 "movw %w0, %%es\n\t"
+                 "movw %w0, %%fs\n\t"
+                 "movw %w0, %%ss" : : "r" (GDT_KERNEL_DATA));
+    asm volatile("movw %w0, %%gs" : : "r" (GDT_PERCPU_SEL(id)) : "memory");
+}
+
+/**
+ * بناء GDT النواة: كود وبيانات مسطحة (4GB) ومقطع صغير لكل معالج
+ * معالجات المقاطعات لا تلمس gs فيبقى صالحاً في كل مسارات النواة
+ */
+void init_percpu(void) {
+    int i;
+    
+    gdt[0] = 0;
+    gdt[GDT_KERNEL_CODE / 8] = gdt_descriptor(0, 0xFFFFF, 0x9A, 0xC);
+    gdt[GDT_KERNEL_DATA / 8] = gdt_descriptor(0, 0xFFFFF, 0x92, 0xC);
+    for (i = 0; i < MAX_CPUS; i++) {
+        cpus[i].self = &cpus[i];
+        gdt[GDT_PERCPU_FIRST + i] = gdt_descriptor((uint32_t)&cpus[i], sizeof(cpu_t) - 1, 0x92, 0x4);
+    }
+    gdt_ptr.limit = sizeof(gdt) - 1;
+    gdt_ptr.base = (uint32_t)&gdt;
+    
+    load_percpu_segment(0);
+}
+
+// انتظار بالـ TSC (المقاطعات قد تكون مفعلة)
+static void smp_delay_us(uint32_t us) {
+    uint64_t wait = div_u64((uint64_t)get_tsc_khz() * us, 1000);
+    uint64_t start = rdtsc();
+    
+    while (rdtsc() - start < wait) {
+        asm volatile("pause");
+    }
+}
+
+// IPI إعادة الجدولة: يكفي أنه أيقظ المعالج من hlt، وحلقة الخمول توازن وتجدول
+static void reschedule_handler(interrupt_context_t* context) {
+    this_cpu()->ipis++;
+}
+
+/**
+ * إيقاظ معالج خامل ليجدول مهمة أضيفت إلى طابوره أو يسرقها
+ */
+void smp_send_reschedule(int cpu) {
+    lapic_send_ipi(cpus[cpu].apic_id, LAPIC_ICR_FIXED | IRQ_RESCHEDULE);
+}
+
+/**
+ * أول شيفرة C على المعالج الإضافي: المقاطعات معطلة والمكدس مكدس الإقلاع
+ */
+void ap_main(void) {
+    cpu_t* cpu;
+    task_t* idle;
+    
+    load_percpu_segment(apic_to_cpu[lapic_id()]);
+    asm volatile("lidt %0" : : "m" (idt_ptr));
+    asm volatile("fninit");
+    kernel_lock_acquire();
+    
+    lapic_init_ap();
+    cpu = this_cpu();
+    idle = scheduler.cpu[cpu->id].idle_task;
+    
+    idle->state = TASK_RUNNING;
+    idle->exec_start = ktime_get_ns();
+    cpu->current = idle;
+    setup_scheduler_timer();
+    
+    cpu->online = true;
+    nr_cpus_online++;
+    
+    // مهمة الخمول تبدأ في task_start التي تفعل المقاطعات (وتحرر القفل)
+    switch_context(&ap_boot_task[cpu->id], idle);
+}
+
+// INIT ثم SIPI مرتين (تسلسل Intel MP)، ثم انتظار ap_main
+static bool smp_boot_cpu(int id, uint8_t apic_id) {
+    cpu_t* cpu = &cpus[id];
+    uint8_t* stack = (uint8_t*)alloc_page();
+    uint64_t start, timeout;
+    
+    if (!stack || !create_idle_task(id)) {
+        if (stack) {
+            free_page(stack);
+        }
+        return false;
+    }
+    
+    cpu->id = id;
+    cpu->apic_id = apic_id;
+    cpu->cr3 = smp_boot_cr3;
+    apic_to_cpu[apic_id] = id;
+    smp_boot_stack = (uint32_t)stack + PAGE_SIZE;
+    
+    lapic_send_ipi(apic_id, LAPIC_ICR_INIT | LAPIC_ICR_ASSERT | LAPIC_ICR_LEVEL);
+    smp_delay_us(SMP_INIT_DELAY_US);
+    for (int i = 0; i < 2 && !cpu->online; i++) {
+        lapic_send_ipi(apic_id, LAPIC_ICR_STARTUP | (SMP_TRAMPOLINE_ADDR >> 12));
+        smp_delay_us(SMP_SIPI_DELAY_US);
+    }
+    
+    timeout = div_u64((uint64_t)get_tsc_khz() * SMP_BOOT_TIMEOUT_US, 1000);
+    start = rdtsc();
+    while (!cpu->online && rdtsc() - start < timeout) {
+        asm volatile("pause");
+    }
+    return cpu->online;
+}
+
+/**
+ * إقلاع كل المعالجات المفعلة في MADT
+ * يتطلب APIC (IPI ومؤقت محلي لكل معالج) ويعمل والمقاطعات مفعلة
+ */
+void smp_boot(void) {
+    const madt_info_t* madt = acpi_get_madt();
+    uint32_t i;
+    
+    if (!apic_enabled() || !madt || madt->cpu_count < 2) {
+        print_string("[SMP] Single CPU\n");
+        return;
+    }
+    
+    cpus[0].apic_id = lapic_id();
+    apic_to_cpu[cpus[0].apic_id] = 0;
+    
+    set_idt_entry(IRQ_RESCHEDULE, (uintptr_t)irq16, 0x08, INTERRUPT_GATE);
+    register_interrupt_handler(IRQ_RESCHEDULE, reschedule_handler);
+    
+    // المعالجات الإضافية تبدأ بإعدادات BSP نفسها (CR0 فيه PG و WP) ودليل النواة
+    memcpy((void*)SMP_TRAMPOLINE_ADDR, smp_trampoline_start, smp_trampoline_end - smp_trampoline_start);
+    asm volatile("mov %%cr0, %0" : "=r" (smp_boot_cr0));
+    asm volatile("mov %%cr4, %0" : "=r" (smp_boot_cr4));
+    smp_boot_cr3 = (uint32_t)kernel_directory;
+    
+    // من الآن كل من يعطل المقاطعات يمسك القفل العام (هنا مفعلة فلا نمسكه)
+    smp_active = true;
+    
+    for (i = 0; i < madt->cpu_count && nr_cpus_online < MAX_CPUS; i++) {
+        uint8_t apic_id = madt->cpu_apic_ids[i];
+    
+        if (apic_id == cpus[0].apic_id) {
+            continue;
+        }
+        if (!smp_boot_cpu(nr_cpus_online, apic_id)) {
+            print_string("[SMP] CPU with APIC ID ");
+            print_number(apic_id);
+            print_string(" did not start\n");
+            break;
+        }
+    }
+    
+    print_string("[SMP] ");
+    print_number(nr_cpus_online);
+    print_string(" CPUs online\n");
+}
+
+/**
+ * طباعة حالة كل معالج: مهمته الحالية وطابوره والمهام المسروقة
+ */
+void print_smp_info(void) {
+    uint32_t flags = irq_save();
+    
+    for (int i = 0; i < MAX_CPUS; i++) {
+        cpu_rq_t* rq = &scheduler.cpu[i];
+    
+        if (!cpus[i].online) {
+            continue;
+        }
+    
+        print_string("CPU ");
+        print_number(i);
+        print_string(" (APIC ");
+        print_number(cpus[i].apic_id);
+        print_string("): ");
+        print_string(cpus[i].current ? cpus[i].current->name : "-");
+        print_string(", queued ");
+        print_number(rq->rq.nr_running + rq->cfs.nr_running);
+        print_string(", ticks ");
+        print_number(rq->ticks);
+        print_string(", migrations ");
+        print_number(rq->migrations);
+        print_string(", IPIs ");
+        print_number(cpus[i].ipis);
+        print_string("\n");
+    }
+    
+    irq_restore(flags);
+}
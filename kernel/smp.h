@@ -0,0 +1,105 @@
+#ifndef SMP_H
+#define SMP_H
+
+#include "kernel.h"
+
+// شيفرة إقلاع المعالجات الإضافية تُنسخ تحت 1MB: متجه SIPI هو الصفحة (0x70 = 0x70000)
+// النواة تبدأ من 0x1000 ويجب أن تبقى صورتها تحت هذا العنوان
+#define SMP_TRAMPOLINE_ADDR 0x70000
+#define SMP_INIT_DELAY_US 10000         // بعد INIT وقبل أول SIPI
+#define SMP_SIPI_DELAY_US 200           // بين رسالتي SIPI
+#define SMP_BOOT_TIMEOUT_US 100000      // أقصى انتظار حتى يعلن المعالج جاهزيته
+
+// GDT النواة: محددات الإقلاع نفسها، ثم مقطع بيانات لكل معالج يحمله gs
+// أساسه cpus[id] فتُقرأ بيانات المعالج بتعليمة واحدة بلا cli ولا MMIO
+#define GDT_KERNEL_CODE 0x08
+#define GDT_KERNEL_DATA 0x10
+#define GDT_PERCPU_FIRST 3
+#define GDT_ENTRIES (GDT_PERCPU_FIRST + MAX_CPUS)
+#define GDT_PERCPU_SEL(id) ((GDT_PERCPU_FIRST + (id)) * 8)
+
+// قفل دوار: test-and-set مع pause أثناء الانتظار
+typedef struct {
+    volatile uint32_t locked;
+} spinlock_t;
+
+static inline void spin_lock(spinlock_t* lock) {
+    while (__sync_lock_test_and_set(&lock->locked, 1)) {
+        while (lock->locked) {
+            asm volatile("pause");
+        }
+    }
+}
+
+static inline void spin_unlock(spinlock_t* lock) {
+    __sync_lock_release(&lock->locked);
+}
+
+struct task_struct;
+
+// بيانات كل معالج: المهمة الحالية وحالة مؤقته المحلي
+typedef struct cpu {
+    struct cpu* self;                   // gs:0 (this_cpu)
+    int id;                             // الفهرس في cpus (0 = المعالج الذي أقلع النواة)
+    uint8_t apic_id;
+    volatile bool online;
+    struct task_struct* current;        // المهمة التي تعمل عليه الآن
+    uint32_t cr3;                       // دليل الصفحات المحمل (switch_page_directory)
+    
+    // النبضة الديناميكية (interrupt.c)
+    volatile bool tick_stopped;
+    uint32_t nohz_ticks;
+    
+    // مؤقت LAPIC (apic.c)
+    bool timer_periodic;
+    uint64_t timer_armed;
+    uint64_t timer_deadline;
+    uint32_t oneshot_count;
+    
+    uint32_t ipis;                      // مقاطعات إعادة جدولة استقبلها
+} cpu_t;
+
+extern cpu_t cpus[MAX_CPUS];
+extern int nr_cpus_online;
+extern volatile bool smp_active;        // المعالجات الإضافية بدأت: القفل العام مطلوب
+
+// قفل النواة العام (كـ global cli في Linux 2.0): المعالج الذي عطل مقاطعاته
+// يمسكه، فكل ما كانت irq_save تحميه على معالج واحد يبقى محمياً على عدة معالجات
+// والمهام التي تعمل بمقاطعات مفعلة (العمل الحسابي) تعمل بالتوازي
+extern spinlock_t kernel_lock;
+
+static inline void kernel_lock_acquire(void) {
+    if (smp_active) {
+        spin_lock(&kernel_lock);
+    }
+}
+
+static inline void kernel_lock_release(void) {
+    if (smp_active) {
+        spin_unlock(&kernel_lock);
+    }
+}
+
+// بيانات المعالج الحالي من مقطع gs الخاص به
+// المهمة قد تنتقل إلى معالج آخر إذا أُزيحت، فالنتيجة صالحة فقط والمقاطعات معطلة
+static inline cpu_t* this_cpu(void) {
+    cpu_t* cpu;
+    
+    asm volatile("movl %%gs:%c1, %0" : "=r" (cpu) : "i" (__builtin_offsetof(cpu_t, self)));
+    return cpu;
+}
+
+static inline int smp_processor_id(void) {
+    return this_cpu()->id;
+}
+
+// تحميل GDT النواة ومقطع gs للمعالج 0، قبل أي استدعاء لـ this_cpu
+void init_percpu(void);
+
+// إقلاع المعالجات الموجودة في MADT بـ INIT-SIPI-SIPI
+// بعد init_scheduler و init_apic، والمقاطعات مفعلة
+void smp_boot(void);
+void smp_send_reschedule(int cpu);
+void print_smp_info(void);
+
+#endif // SMP_H
@@ -0,0 +1,65 @@
+; إقلاع المعالجات الإضافية (AP)
+; smp.c ينسخ ما بين smp_trampoline_start و smp_trampoline_end إلى SMP_TRAMPOLINE_ADDR
+; ثم يرسل SIPI: المعالج يبدأ هناك في الوضع الحقيقي بـ cs = 0x7000 و ip = 0
+
+SMP_TRAMPOLINE equ 0x70000          ; SMP_TRAMPOLINE_ADDR في smp.h
+
+global smp_trampoline_start, smp_trampoline_end
+global ap_protected
+
+extern ap_main
+extern smp_boot_cr0, smp_boot_cr3, smp_boot_cr4, smp_boot_stack
+
+section .text
+
+[BITS 16]
+; كل العناوين هنا نسبية إلى بداية النسخة (ds = cs)
+smp_trampoline_start:
+    cli
+    cld
+    mov ax, cs
+    mov ds, ax
+    lgdt [trampoline_gdt_ptr - smp_trampoline_start]
+
+    mov eax, cr0
+    or eax, 1               ; PE
+    mov cr0, eax
+
+    ; قفزة بعيدة بإزاحة 32 بت إلى شيفرة النواة في مكانها
+    jmp dword 0x08:ap_protected
+
+align 8
+; GDT مسطح بنفس محددات النواة (0x08 كود و 0x10 بيانات)
+; مؤقت: ap_main يحمل GDT النواة (init_percpu) ومقطع gs الخاص بالمعالج
+trampoline_gdt:
+    dq 0
+    dq 0x00CF9A000000FFFF   ; كود 32 بت، أساس 0، حد 4GB
+    dq 0x00CF92000000FFFF   ; بيانات 32 بت، أساس 0، حد 4GB
+trampoline_gdt_ptr:
+    dw trampoline_gdt_ptr - trampoline_gdt - 1
+    dd SMP_TRAMPOLINE + (trampoline_gdt - smp_trampoline_start)
+smp_trampoline_end:
+
+[BITS 32]
+; الوضع المحمي: نفس CR4 و CR0 التي يعمل بها BSP ودليل النواة، ثم مكدس الإقلاع
+ap_protected:
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+
+    mov eax, [smp_boot_cr4] ; PSE/PGE و SSE قبل تفعيل الترقيم
+    mov cr4, eax
+    mov eax, [smp_boot_cr3]
+    mov cr3, eax
+    mov eax, [smp_boot_cr0]
+    mov cr0, eax
+
+    mov esp, [smp_boot_stack]
+    call ap_main            ; لا يعود: ينتقل إلى مهمة الخمول
+.halt:
+    cli
+    hlt
+    jmp .halt
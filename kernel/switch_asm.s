@@ -0,0 +1,32 @@
+; تبديل السياق بين مهام النواة
+; يحفظ فقط السجلات التي يحفظها المستدعى (cdecl)، والباقي حفظه المترجم قبل الاستدعاء
+
+[BITS 32]
+
+global switch_context
+
+; إزاحة esp داخل task_t (TASK_ESP_OFFSET في task.h)
+TASK_ESP equ 12
+
+section .text
+
+; void switch_context(task_t* from, task_t* to)
+; يحفظ مكدس from ويكمل على مكدس to من حيث توقف
+; مهمة جديدة تكمل في task_start لأن إطارها الأول مبني في task.c
+switch_context:
+    mov eax, [esp+4]        ; from
+    mov edx, [esp+8]        ; to
+
+    push ebp
+    push ebx
+    push esi
+    push edi
+
+    mov [eax+TASK_ESP], esp ; حفظ مكدس المهمة الحالية
+    mov esp, [edx+TASK_ESP] ; الانتقال إلى مكدس المهمة الجديدة
+
+    pop edi
+    pop esi
+    pop ebx
+    pop ebp
+    ret
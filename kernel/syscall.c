@@ -1,8 +1,14 @@
 #include "syscall.h"
 #include "task.h"
 #include "memory.h"
+#include "paging.h"
 #include "interrupt.h"
 #include "kernel.h"
+#include "scheduler.h"
+#include "timer.h"
+#include "clock.h"
+
+_Static_assert(sizeof(syscall_frame_t) == 18 * 4, "syscall_asm.s frame");
 
 // جدول معالجات استدعاءات النظام
 syscall_handler_t syscall_table[NR_SYSCALLS];
@@ -13,6 +19,9 @@ static syscall_stats_t syscall_stats = {0};
 // متغير للوقت الحالي (بسيط)
 static unsigned int current_time = 0;
 
+// أطول منبه: الموعد بالـ ticks يبقى ضمن نصف مدى العداد
+#define ALARM_MAX_SECONDS (0x7FFFFFFF / HZ)
+
 // متغير لمعرف المستخدم الحالي
 static unsigned int current_uid = 0;
 
@@ -35,6 +44,7 @@ void init_syscalls(void) {
     register_syscall(SYS_GETUID, sys_getuid);
     register_syscall(SYS_TIME, sys_time);
     register_syscall(SYS_BRK, sys_brk);
+    register_syscall(SYS_ALARM, sys_alarm);
     register_syscall(SYS_PAUSE, sys_pause);
     register_syscall(SYS_KILL, sys_kill);
     
@@ -94,8 +104,9 @@ int handle_syscall(syscall_params_t* params) {
  * إعداد بوابة استدعاء النظام
  */
 void setup_syscall_gate(void) {
-    // تسجيل معالج المقاطعة 0x80 لاستدعاءات النظام
-    register_interrupt_handler(0x80, (interrupt_handler_t)syscall_entry);
+    // syscall_entry يبني إطاره ويعود بـ iret بنفسه، فيُربط بالبوابة مباشرة لا عبر
+    // isr_handler. بوابة فخ لا تغير IF، فقفل النواة يبقى مطابقاً لحالة المستدعي
+    set_idt_entry(0x80, (uintptr_t)syscall_entry, 0x08, TRAP_GATE);
 }
 
 /**
@@ -118,20 +129,15 @@ int sys_exit(syscall_params_t* params) {
 
 /**
  * sys_fork - إنشاء عملية جديدة
+ * المعاملات في أدنى إطار int 0x80، والابن يكمل بعد int بنسخة منه ترى eax = 0
  */
 int sys_fork(syscall_params_t* params) {
-    // تنفيذ مبسط لـ fork
-    // Fork system call (simplified)
-    
-    // في نظام حقيقي، ننشئ نسخة من العملية الحالية
-    // هنا نرجع PID وهمي للاختبار
-    static int next_pid = 100;
-    int child_pid = next_pid++;
-    
-    // Fork: created child PID logged
+    task_t* child = fork_syscall((syscall_frame_t*)params);
     
-    // إرجاع PID الطفل للوالد، 0 للطفل
-    return child_pid;
+    if (!child) {
+        return -1;
+    }
+    return child->pid;
 }
 
 /**
@@ -193,8 +199,8 @@ int sys_getuid(syscall_params_t* params) {
 int sys_time(syscall_params_t* params) {
     unsigned int* time_ptr = (unsigned int*)params->ebx;
     
-    // تحديث الوقت بناءً على timer ticks
-    current_time = get_timer_ticks() / 100; // تقريبي: 100 ticks = 1 ثانية
+    // وقت الحائط: RTC عند الإقلاع + الساعة الرتيبة
+    current_time = get_real_seconds();
     
     if (time_ptr) {
         *time_ptr = current_time;
@@ -204,27 +210,88 @@ int sys_time(syscall_params_t* params) {
 }
 
 /**
- * sys_brk - تغيير حجم الذاكرة
+ * sys_brk - تغيير نهاية كومة العملية
+ * يحجز مساحة عناوين فقط؛ الصفحات تُخصص وتُصفر عند أول لمس
+ * يعيد النهاية الجديدة، أو القديمة إذا كان الطلب غير صالح
  */
 int sys_brk(syscall_params_t* params) {
-    void* new_brk = (void*)params->ebx;
+    uint32_t new_brk = params->ebx;
+    task_t* task = current_task;
+    page_directory_t* dir;
+    
+    if (!task) {
+        return -1;
+    }
+    
+    // brk(0) يعيد النهاية الحالية
+    if (new_brk == 0 || new_brk < task->brk_start || new_brk > USER_SPACE_END) {
+        return (int)task->brk;
+    }
+    
+    dir = get_task_directory(task);
+    if (!dir) {
+        return (int)task->brk;
+    }
     
-    // تنفيذ بسيط - استخدام kmalloc/kfree
-    // BRK system call (simplified)
+    // التقليص يحرر الصفحات التي تم لمسها خارج الحد الجديد
+    if (new_brk < task->brk) {
+        release_user_pages(dir, new_brk, PAGE_ALIGN(task->brk));
+    }
     
-    // في نظام حقيقي، نغير حدود الذاكرة للعملية
+    task->brk = new_brk;
     return (int)new_brk;
 }
 
 /**
- * sys_pause - إيقاف مؤقت للعملية
+ * sys_alarm - منبه بعد عدد من الثواني (0 = إلغاء المنبه)
+ * تعيد الثواني المتبقية من المنبه السابق
+ */
+int sys_alarm(syscall_params_t* params) {
+    unsigned int seconds = params->ebx;
+    task_t* task = current_task;
+    uint32_t flags, now;
+    int remaining = 0;
+    
+    if (!task) {
+        return 0;
+    }
+    if (seconds > ALARM_MAX_SECONDS) {
+        seconds = ALARM_MAX_SECONDS;
+    }
+    
+    flags = irq_save();
+    now = get_timer_ticks();
+    
+    if (del_timer(&task->alarm)) {
+        // منبه معلق أقل من ثانية يُحسب ثانية كاملة
+        remaining = time_after(task->alarm.expires, now) ?
+            (task->alarm.expires - now + HZ - 1) / HZ : 1;
+    }
+    if (seconds) {
+        mod_timer(&task->alarm, now + seconds * HZ);
+    }
+    
+    irq_restore(flags);
+    return remaining;
+}
+
+/**
+ * sys_pause - النوم حتى وصول إشارة
+ * لا توجد معالجات إشارات بعد: الإشارة (مثل SIGALRM) توقظ المهمة وتُستهلك
  */
 int sys_pause(syscall_params_t* params) {
-    // تنفيذ مبسط للإيقاف المؤقت
-    // Process paused
-    // في نظام حقيقي، نغير حالة العملية ونجدول أخرى
-    // schedule();
-    return 0;
+    uint32_t flags = irq_save();
+    
+    while (current_task && !current_task->signal) {
+        current_task->state = TASK_SLEEPING;
+        schedule();
+    }
+    if (current_task) {
+        current_task->signal = 0;
+    }
+    
+    irq_restore(flags);
+    return -1; // مثل Linux: pause تعود دائماً بخطأ EINTR
 }
 
 /**
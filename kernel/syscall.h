@@ -44,6 +44,15 @@ typedef struct {
     unsigned int edi;  // المعامل الخامس
 } syscall_params_t;
 
+// إطار int 0x80 كما يبنيه syscall_entry على المكدس، والمعاملات في أدناه
+typedef struct syscall_frame {
+    syscall_params_t params;    // ما يمرره إلى handle_syscall
+    unsigned int es, ds;        // المقاطع المحفوظة
+    unsigned int ebp, edi, esi, edx, ecx, ebx;
+    unsigned int eax;           // قيمة العودة
+    unsigned int eip, cs, eflags;  // إطار iret (الحلقة نفسها: بلا esp/ss)
+} syscall_frame_t;
+
 // هيكل إحصائيات استدعاءات النظام
 typedef struct {
     unsigned int total_calls;           // إجمالي الاستدعاءات
@@ -74,6 +83,7 @@ int sys_getpid(syscall_params_t* params);
 int sys_getuid(syscall_params_t* params);
 int sys_time(syscall_params_t* params);
 int sys_brk(syscall_params_t* params);
+int sys_alarm(syscall_params_t* params);
 int sys_pause(syscall_params_t* params);
 int sys_kill(syscall_params_t* params);
 
@@ -132,4 +142,12 @@ static inline int read(int fd, void* buf, int count) {
     return SYSCALL3(SYS_READ, fd, (int)buf, count);
 }
 
+static inline unsigned int alarm(unsigned int seconds) {
+    return SYSCALL1(SYS_ALARM, seconds);
+}
+
+static inline int pause(void) {
+    return SYSCALL0(SYS_PAUSE);
+}
+
 #endif // SYSCALL_H
\ No newline at end of file
@@ -5,9 +5,11 @@
 
 section .text
 global syscall_entry
+global syscall_return
 global test_syscalls
 global syscall_print
 extern handle_syscall
+extern strlen
 
 ; System call entry point (interrupt 0x80)
 syscall_entry:
@@ -51,6 +53,8 @@ syscall_entry:
     mov [esp+32], ebx  ; update saved eax
     
     ; Restore registers
+    ; A sys_fork child enters here on its copy of the frame (task.c)
+syscall_return:
     pop es
     pop ds
     pop ebp
@@ -93,17 +97,12 @@ syscall_print:
     push esi
     push edi
     
-    ; calculate text length
-     mov esi, [ebp+8]  ; text address
-     xor edi, edi      ; length counter
+    ; calculate text length (word-at-a-time strlen in memory.c)
+     push dword [ebp+8] ; text address
+     call strlen
+     add esp, 4
+     mov edi, eax      ; length
     
-count_loop:
-    cmp byte [esi + edi], 0
-    je count_done
-    inc edi
-    jmp count_loop
-    
-count_done:
     ; call sys_write
      mov eax, 4       ; SYS_WRITE
      mov ebx, 1       ; stdout
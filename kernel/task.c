@@ -1,30 +1,219 @@
 #include "task.h"
+#include "syscall.h"
+#include "scheduler.h"
+#include "slab.h"
+#include "paging.h"
+#include "interrupt.h"
+#include "clock.h"
 #include <stdint.h>
 
+_Static_assert(__builtin_offsetof(task_t, esp) == TASK_ESP_OFFSET, "switch_asm.s TASK_ESP");
+
 // متغيرات عامة لإدارة المهام
-task_t* current_task = 0;           // المهمة الحالية
 task_t* task_list = 0;              // قائمة المهام
-int next_pid = 1;                   // معرف المهمة التالي
+int last_pid = 0;                   // آخر معرف خُصص
 
-// مصفوفة المهام - مبسطة
-static task_t tasks[MAX_TASKS];
+// ذاكرة slab المؤقتة لهياكل المهام
+static kmem_cache_t* task_cache = 0;
 static int task_count = 0;
+static task_t* task_list_tail = 0;  // للإضافة في O(1)
+
+// المعرفات المستخدمة (بت لكل معرف، 1 = مستخدم) وجدول hash للبحث
+static uint32_t pid_map[PID_MAX / BITS_PER_WORD];
+static uint32_t pid_free = 0;
+static task_t* pid_hash[PID_HASH_SIZE];
+static task_t* zombie_list = 0;     // مهام منفصلة انتهت ولم تُحرر بعد
+
+// تخصيص معرف: أول بت حر بعد last_pid مع الالتفاف إلى البداية
+// المعرفات تُخصص بالتتابع، فالبحث ينتهي عادة في الكلمة الأولى
+static int alloc_pid(void) {
+    uint32_t words = PID_MAX / BITS_PER_WORD;
+    uint32_t start = (uint32_t)(last_pid + 1) % PID_MAX;
+    uint32_t word = start / BITS_PER_WORD;
+    uint32_t free;
+    int pid;
+    
+    if (pid_free == 0) {
+        return INVALID_PID;
+    }
+    
+    // الكلمة الأولى: المعرفات من start فما فوق فقط، والباقي يُفحص بعد الالتفاف
+    free = ~pid_map[word] & (0xFFFFFFFFu << (start % BITS_PER_WORD));
+    while (!free) {
+        word = (word + 1) % words;
+        free = ~pid_map[word];
+    }
+    
+    pid = word * BITS_PER_WORD + bit_scan_forward(free);
+    pid_map[word] |= 1u << (pid % BITS_PER_WORD);
+    pid_free--;
+    last_pid = pid;
+    return pid;
+}
+
+static void free_pid(int pid) {
+    pid_map[pid / BITS_PER_WORD] &= ~(1u << (pid % BITS_PER_WORD));
+    pid_free++;
+}
+
+static void pid_hash_add(task_t* task) {
+    task_t** bucket = &pid_hash[task->pid & (PID_HASH_SIZE - 1)];
+    
+    task->pid_next = *bucket;
+    *bucket = task;
+}
+
+static void pid_hash_del(task_t* task) {
+    task_t** link = &pid_hash[task->pid & (PID_HASH_SIZE - 1)];
+    
+    while (*link && *link != task) {
+        link = &(*link)->pid_next;
+    }
+    if (*link) {
+        *link = task->pid_next;
+    }
+}
+
+// إضافة مهمة إلى نهاية قائمة المهام وحذفها منها
+static void task_list_add(task_t* task) {
+    task->next = 0;
+    task->prev = task_list_tail;
+    if (task_list_tail) {
+        task_list_tail->next = task;
+    } else {
+        task_list = task;
+    }
+    task_list_tail = task;
+}
+
+static void task_list_del(task_t* task) {
+    if (task->prev) {
+        task->prev->next = task->next;
+    } else {
+        task_list = task->next;
+    }
+    if (task->next) {
+        task->next->prev = task->prev;
+    } else {
+        task_list_tail = task->prev;
+    }
+    task->next = 0;
+    task->prev = 0;
+}
+
+// انتهاء المنبه: إشارة SIGALRM وإيقاظ المهمة إن كانت نائمة (sys_pause)
+static void task_alarm(uint32_t data) {
+    task_t* task = (task_t*)data;
+    
+    task->signal |= 1u << (SIGALRM - 1);
+    task_wake(task);
+}
+
+// تهيئة هيكل مهمة عند إنشاء slab جديد
+static void task_ctor(void* object) {
+    task_t* task = (task_t*)object;
+    task->pid = INVALID_PID;
+    task->state = TASK_ZOMBIE;
+    task->kstack = 0;
+    task->run_array = 0;
+    task->on_fair_rq = false;
+    task->next = 0;
+    task->prev = 0;
+}
+
+// أول ما تنفذه مهمة جديدة: switch_context يعود إلى هنا على مكدسها
+// المقاطعات معطلة أثناء التبديل فتُفعل قبل القفز إلى نقطة الدخول
+static void task_start(void) {
+    void (*entry)(void) = (void (*)(void))current_task->eip;
+    
+    enable_interrupts();
+    entry();
+    task_exit(0);
+}
+
+// أول ما ينفذه ابن sys_fork: يعود عبر نسخته من إطار int 0x80 كأن الاستدعاء اكتمل
+// iret يعيد IF كما كانت عند الأب، فيُحرر القفل الممسوك منذ التبديل إن كانت ستُفعل
+static void task_fork_start(syscall_frame_t* frame) {
+    if (frame->eflags & EFLAGS_IF) {
+        kernel_lock_release();
+    }
+    asm volatile("movl %0, %%esp\n\tjmp syscall_return" : : "r" (&frame->es) : "memory");
+    __builtin_unreachable();
+}
+
+// تخصيص مكدس نواة للمهمة وبناء إطار أول يطابق ما يدفعه switch_context
+// الصفحة السفلى تُلغى من الربط حتى يسبب تجاوز المكدس خطأ صفحة بدل إفساد ذاكرة
+static bool task_alloc_stack(task_t* task) {
+    uint8_t* block = alloc_pages(KERNEL_STACK_ORDER);
+    uint32_t* sp;
+    
+    if (!block) {
+        return false;
+    }
+    set_kernel_guard_page(block, true);
+    
+    sp = (uint32_t*)(block + (PAGE_SIZE << KERNEL_STACK_ORDER));
+    *--sp = 0;                      // عنوان عودة وهمي لـ task_start
+    *--sp = (uint32_t)task_start;   // ret في switch_context
+    *--sp = 0;                      // ebp
+    *--sp = 0;                      // ebx
+    *--sp = 0;                      // esi
+    *--sp = 0;                      // edi
+    
+    task->kstack = (uint32_t)block;
+    task->esp = (uint32_t)sp;
+    return true;
+}
+
+// إعادة مكدس النواة إلى المخصص (صفحة الحماية تُربط أولاً لأن buddy يكتب فيها)
+static void task_free_stack(task_t* task) {
+    if (!task->kstack) {
+        return;
+    }
+    set_kernel_guard_page((void*)task->kstack, false);
+    free_pages((void*)task->kstack, KERNEL_STACK_ORDER);
+    task->kstack = 0;
+}
+
+// تهيئة حقول الذاكرة لمهمة جديدة (الكومة فارغة ولا أخطاء صفحات)
+static void task_init_memory(task_t* task) {
+    task->brk_start = USER_HEAP_START;
+    task->brk = USER_HEAP_START;
+    task->next_color = task->pid;   // كل مهمة تبدأ من لون مختلف
+    task->page_faults = 0;
+    task->fault_pages = 0;
+    task->fault_cycles = 0;
+}
 
 // تهيئة مدير المهام
 void init_task_manager() {
-    // مسح جميع المهام
-    for (int i = 0; i < MAX_TASKS; i++) {
-        tasks[i].pid = INVALID_PID;
-        tasks[i].state = TASK_ZOMBIE;
-        tasks[i].next = 0;
+    task_cache = kmem_cache_create("task_t", sizeof(task_t), 0, SLAB_HWCACHE_ALIGN, task_ctor);
+    if (!task_cache) {
+        print_string("[ERROR] Cannot create task cache\n");
+        return;
     }
     
     // إنشاء المهمة الأولى (kernel task)
-    task_t* kernel_task = &tasks[0];
+    task_t* kernel_task = (task_t*)kmem_cache_alloc(task_cache);
+    if (!kernel_task) {
+        print_string("[ERROR] Cannot allocate kernel task\n");
+        return;
+    }
     kernel_task->pid = 0;
     kernel_task->state = TASK_RUNNING;
     kernel_task->priority = 0;
     kernel_task->parent_pid = INVALID_PID;
+    kernel_task->cr3 = (uint32_t)kernel_directory;
+    kernel_task->kstack = 0;        // تستمر على مكدس الإقلاع
+    kernel_task->cpu = 0;
+    kernel_task->vruntime = 0;
+    kernel_task->sum_exec_runtime = 0;
+    kernel_task->slice_start_runtime = 0;
+    kernel_task->exec_start = 0;
+    kernel_task->signal = 0;
+    setup_timer(&kernel_task->alarm, task_alarm, (uint32_t)kernel_task);
+    task_init_memory(kernel_task);
+    calculate_time_slice(kernel_task);
     
     // نسخ اسم المهمة
     const char* kernel_name = "kernel";
@@ -33,40 +222,74 @@ void init_task_manager() {
     }
     kernel_task->name[15] = '\0';
     
-    current_task = kernel_task;
-    task_list = kernel_task;
+    // المعرف 0 محجوز لمهمة النواة
+    pid_map[0] = 1;
+    pid_free = PID_MAX - 1;
+    last_pid = 0;
+    pid_hash_add(kernel_task);
+    task_list_add(kernel_task);
+    
+    this_cpu()->current = kernel_task;
     task_count = 1;
     
     print_string("[TASK] Task manager initialized\n");
 }
 
-// إنشاء مهمة جديدة
-task_t* create_task(const char* name, void* entry_point) {
-    if (task_count >= MAX_TASKS) {
-        print_string("[ERROR] Maximum tasks reached\n");
+// تخصيص مهمة جديدة وإضافتها إلى القائمة دون طابور التشغيل
+// هياكل المهام من slab فلا حد لعددها إلا المعرفات والذاكرة
+// detached: لا منشئ ينتظرها، فتُحرر من reap_zombies بعد task_exit
+static task_t* task_create(const char* name, void* entry_point, bool detached) {
+    uint32_t flags = irq_save();
+    int pid = alloc_pid();
+    
+    irq_restore(flags);
+    if (pid == INVALID_PID) {
+        print_string("[ERROR] No free PID\n");
         return 0;
     }
     
-    // البحث عن مكان فارغ
-    task_t* new_task = 0;
-    for (int i = 0; i < MAX_TASKS; i++) {
-        if (tasks[i].pid == INVALID_PID) {
-            new_task = &tasks[i];
-            break;
-        }
-    }
+    // تخصيص هيكل المهمة من slab
+    task_t* new_task = (task_t*)kmem_cache_alloc(task_cache);
     
     if (!new_task) {
         print_string("[ERROR] No free task slot\n");
+        flags = irq_save();
+        free_pid(pid);
+        irq_restore(flags);
         return 0;
     }
     
     // تهيئة المهمة الجديدة
-    new_task->pid = next_pid++;
+    new_task->pid = pid;
     new_task->state = TASK_READY;
     new_task->priority = 10;  // أولوية افتراضية
     new_task->parent_pid = current_task ? current_task->pid : INVALID_PID;
+    new_task->detached = detached;
+    new_task->zombie_next = 0;
     new_task->eip = (uint32_t)(uintptr_t)entry_point;
+    // مهام النواة تبدأ على دليل النواة بكومة فارغة، ومساحة المستخدم الخاصة
+    // تُنشأ عند أول حجز (get_task_directory) أو تُنسخ في fork_task
+    new_task->cr3 = (uint32_t)kernel_directory;
+    task_init_memory(new_task);
+    
+    new_task->sum_exec_runtime = 0;
+    new_task->slice_start_runtime = 0;
+    new_task->exec_start = 0;
+    
+    // المنبه لا يُورث عند fork
+    new_task->signal = 0;
+    setup_timer(&new_task->alarm, task_alarm, (uint32_t)new_task);
+    
+    if (!task_alloc_stack(new_task)) {
+        print_string("[ERROR] Cannot allocate kernel stack\n");
+        flags = irq_save();
+        free_pid(pid);
+        irq_restore(flags);
+        new_task->pid = INVALID_PID;
+        new_task->state = TASK_ZOMBIE;
+        kmem_cache_free(task_cache, new_task);
+        return 0;
+    }
     
     // نسخ اسم المهمة
     for (int i = 0; i < 15 && name[i]; i++) {
@@ -74,76 +297,333 @@ task_t* create_task(const char* name, void* entry_point) {
     }
     new_task->name[15] = '\0';
     
-    // إضافة المهمة إلى القائمة
-    if (task_list) {
-        task_t* last = task_list;
-        while (last->next) {
-            last = last->next;
-        }
-        last->next = new_task;
-    } else {
-        task_list = new_task;
+    // إضافة المهمة إلى القائمة وجدول المعرفات بشريحة كاملة
+    flags = irq_save();
+    task_list_add(new_task);
+    pid_hash_add(new_task);
+    task_count++;
+    new_task->cpu = smp_processor_id();
+    new_task->vruntime = task_rq(new_task)->cfs.min_vruntime;
+    calculate_time_slice(new_task);
+    irq_restore(flags);
+    
+    return new_task;
+}
+
+// تخصيص مهمة جديدة وإضافتها إلى طابور التشغيل
+static task_t* spawn_task(const char* name, void* entry_point, bool detached) {
+    task_t* new_task = task_create(name, entry_point, detached);
+    uint32_t flags;
+    
+    if (!new_task) {
+        return 0;
     }
     
-    task_count++;
+    // المهمة الجديدة على أقل المعالجات حملاً، وتبدأ عند أصغر vruntime في طابوره
+    // العادل فلا تحتكر المعالج
+    flags = irq_save();
+    set_task_cpu(new_task, select_task_cpu());
+    add_task_to_scheduler(new_task);
+    irq_restore(flags);
     
-    print_string("[TASK] Created task: ");
-    print_string(name);
-    print_string("\n");
+    return new_task;
+}
+
+// مهمة بدون طباعة، والمستدعي يحررها بـ reap_task بعد انتهائها
+task_t* alloc_task(const char* name, void* entry_point) {
+    return spawn_task(name, entry_point, false);
+}
+
+// إنشاء مهمة جديدة منفصلة: تُحرر تلقائياً عند انتهائها
+task_t* create_task(const char* name, void* entry_point) {
+    task_t* new_task = spawn_task(name, entry_point, true);
+    
+    if (new_task) {
+        print_string("[TASK] Created task: ");
+        print_string(name);
+        print_string("\n");
+    }
     
     return new_task;
 }
 
-// جدولة المهام البسيطة - Round Robin
-void schedule() {
-    if (!current_task || !current_task->next) {
+// تحرير مساحة عناوين المستخدم للمهمة والعودة إلى دليل النواة
+// كل دليل غير دليل النواة ملك مهمة واحدة: أنشأته get_task_directory لها
+// أو نسخته fork_task، فلا تحرر مهمة دليل غيرها
+static void task_release_memory(task_t* task) {
+    page_directory_t* dir = (page_directory_t*)task->cr3;
+    
+    if (task->cr3 == 0 || dir == kernel_directory) {
         return;
     }
     
-    // البحث عن المهمة التالية الجاهزة
-    task_t* next_task = current_task->next;
-    while (next_task && next_task->state != TASK_READY && next_task->state != TASK_RUNNING) {
-        next_task = next_task->next;
-        if (!next_task) {
-            next_task = task_list;  // العودة إلى بداية القائمة
+    release_user_pages(dir, USER_SPACE_START, USER_SPACE_END);
+    destroy_page_directory(dir);
+    task->cr3 = (uint32_t)kernel_directory;
+    task->brk = task->brk_start;
+}
+
+// نسخ مكدس الأب من إطار int 0x80 حتى قمته إلى الموضع نفسه من قمة مكدس الابن
+// سلسلة ebp المحفوظة تُزاح إلى النسخة فيعود الابن عبر دوال المستدعي على مكدسه،
+// أما المؤشرات إلى متغيرات محلية فتبقى على مكدس الأب كما في أي نسخ لمكدس نواة
+static bool task_copy_frame(task_t* child, task_t* parent, syscall_frame_t* frame) {
+    uint32_t size = PAGE_SIZE << KERNEL_STACK_ORDER;
+    uint32_t start = (uint32_t)frame;
+    uint32_t top = parent->kstack + size;
+    uint32_t delta = child->kstack + size - top;
+    syscall_frame_t* copy = (syscall_frame_t*)(start + delta);
+    uint32_t* link;
+    uint32_t* sp;
+    
+    // مهمة الإقلاع بلا مكدس خاص، وإطار خارج المكدس لم يأت من int 0x80
+    if (!parent->kstack || start < parent->kstack + PAGE_SIZE || start >= top) {
+        return false;
+    }
+    
+    memcpy(copy, frame, top - start);
+    copy->eax = 0;                  // fork تعيد 0 في الابن
+    
+    // كل ebp محفوظ يشير أعلى من موضعه حتى إطار task_start (ebp = 0)
+    link = &copy->ebp;
+    while (*link >= start && *link < top && *link > (uint32_t)link - delta) {
+        *link += delta;
+        link = (uint32_t*)*link;
+    }
+    
+    sp = (uint32_t*)copy;
+    *--sp = (uint32_t)copy;         // معامل task_fork_start
+    *--sp = 0;                      // عنوان عودة وهمي
+    *--sp = (uint32_t)task_fork_start;  // ret في switch_context
+    *--sp = 0;                      // ebp
+    *--sp = 0;                      // ebx
+    *--sp = 0;                      // esi
+    *--sp = 0;                      // edi
+    child->esp = (uint32_t)sp;
+    return true;
+}
+
+// نسخ مساحة عناوين المهمة الحالية لمهمة جديدة
+// الجداول فقط تُنسخ؛ الإطارات تُشارك وتُنسخ عند أول كتابة
+// الابن يبدأ من entry_point بإطار task_start، أو يكمل بعد int 0x80 إن أُعطي frame
+static task_t* do_fork(void* entry_point, syscall_frame_t* frame) {
+    task_t* parent = current_task;
+    task_t* child;
+    page_directory_t* dir = 0;
+    uint32_t flags;
+    
+    if (!parent) {
+        return 0;
+    }
+    
+    // النسخ قبل إنشاء الابن: إن فشل لا يوجد ابن يحمل دليل الأب
+    // مهام النواة بلا ذاكرة مستخدم تشارك دليل النواة مباشرة
+    // (ref_count للإطارات المشتركة يزداد تحت القفل نفسه الذي يحررها)
+    if (parent->cr3 != (uint32_t)kernel_directory) {
+        flags = irq_save();
+        dir = clone_page_directory((page_directory_t*)parent->cr3);
+        irq_restore(flags);
+        if (!dir) {
+            print_string("[ERROR] Cannot clone address space\n");
+            return 0;
         }
-        if (next_task == current_task) {
-            break;  // تجنب الحلقة اللا نهائية
+    }
+    
+    // الابن خارج طابور التشغيل حتى يكتمل إعداده، فلا يسرقه معالج آخر قبل ذلك
+    // ابن sys_fork لا ينتظره أحد (لا waitpid) فيُحرر تلقائياً عند انتهائه
+    child = task_create(parent->name, entry_point, frame != 0);
+    if (child && frame && !task_copy_frame(child, parent, frame)) {
+        reap_task(child);
+        child = 0;
+    }
+    if (!child) {
+        if (dir) {
+            release_user_pages(dir, USER_SPACE_START, USER_SPACE_END);
+            destroy_page_directory(dir);
         }
+        return 0;
     }
     
-    if (next_task && next_task != current_task) {
-        task_t* prev_task = current_task;
-        current_task = next_task;
-        current_task->state = TASK_RUNNING;
-        
-        if (prev_task->state == TASK_RUNNING) {
-            prev_task->state = TASK_READY;
+    child->brk_start = parent->brk_start;
+    child->brk = parent->brk;
+    if (dir) {
+        child->cr3 = (uint32_t)dir;
+    }
+    
+    // الابن يرث vruntime الأب نسبة إلى طابور المعالج الذي يُوضع عليه
+    flags = irq_save();
+    child->cpu = parent->cpu;
+    child->vruntime = parent->vruntime;
+    set_task_cpu(child, select_task_cpu());
+    set_task_priority(child, parent->priority);
+    add_task_to_scheduler(child);
+    irq_restore(flags);
+    
+    return child;
+}
+
+// ابن يبدأ من entry_point في نسخة COW من ذاكرة المهمة الحالية، ويحرره المستدعي
+task_t* fork_task(void* entry_point) {
+    return do_fork(entry_point, 0);
+}
+
+// ابن sys_fork: يكمل من إطار int 0x80 للمهمة الحالية
+task_t* fork_syscall(syscall_frame_t* frame) {
+    return do_fork(0, frame);
+}
+
+// إزالة مهمة من قائمة المنتهية إن كانت فيها (تحت القفل)
+static void zombie_del(task_t* task) {
+    task_t** link = &zombie_list;
+    
+    while (*link && *link != task) {
+        link = &(*link)->zombie_next;
+    }
+    if (*link) {
+        *link = task->zombie_next;
+        task->zombie_next = 0;
+    }
+}
+
+// إزالة مهمة منتهية من القائمة وتحرير مواردها
+void reap_task(task_t* task) {
+    uint32_t flags;
+    
+    if (!task || task == current_task || task->pid == INVALID_PID) {
+        return;
+    }
+    
+    // مهمة انتهت على معالج آخر قد لا تكون بدلت عن مكدسها بعد
+    while (task_running(task)) {
+        asm volatile("pause" : : : "memory");
+    }
+    
+    del_timer(&task->alarm);
+    
+    flags = irq_save();
+    zombie_del(task);
+    task_list_del(task);
+    pid_hash_del(task);
+    free_pid(task->pid);
+    remove_task_from_scheduler(task);
+    task_count--;
+    irq_restore(flags);
+    
+    task_release_memory(task);
+    task_free_stack(task);
+    task->pid = INVALID_PID;
+    task->state = TASK_ZOMBIE;
+    kmem_cache_free(task_cache, task);
+}
+
+// جدولة المهام - أفضل مهمة من طوابير الأولوية في O(1) (scheduler.c)
+void schedule() {
+    uint32_t flags = irq_save();
+    
+    if (current_task) {
+        update_curr();      // قرار الإزاحة على زمن التشغيل الحالي
+        if (can_preempt_current_task()) {
+            scheduler.stats.total_switches++;
+            switch_to_task(get_next_task());
+        } else {
+            // لا بديل: المهمة تستمر (yield بلا مهام أخرى أو شريحة انتهت)
+            if (current_task->state == TASK_READY) {
+                current_task->state = TASK_RUNNING;
+            }
+            if (current_task->time_slice <= 0) {
+                calculate_time_slice(current_task);
+            }
         }
-        
-        // هنا يمكن إضافة تبديل السياق الفعلي
-        // switch_to_task(current_task);
     }
+    
+    irq_restore(flags);
+}
+
+// تحرير أول مهمة منفصلة منتهية بدلت عن مكدسها، وتعيد false إن لم يوجد عمل
+// المهمة لا تستطيع تحرير المكدس الذي تعمل عليه، فيتولاه الخمول بعدها
+bool reap_zombies(void) {
+    uint32_t flags = irq_save();
+    task_t* task = zombie_list;
+    
+    while (task && task_running(task)) {
+        task = task->zombie_next;
+    }
+    if (task) {
+        zombie_del(task);
+    }
+    irq_restore(flags);
+    
+    if (!task) {
+        return false;
+    }
+    reap_task(task);
+    return true;
 }
 
 // إنهاء المهمة
 void task_exit(int exit_code) {
-    if (current_task) {
-        current_task->state = TASK_ZOMBIE;
+    task_t* task = current_task;
+    
+    // بلا مقاطعات من ZOMBIE حتى التبديل: tick بينهما يبدل عن المهمة ولا يعود
+    // إليها فيضيع دليلها، ولا تُحرر المنفصلة قبل أن تغادر مكدسها
+    irq_save();
+    if (task) {
+        task->state = TASK_ZOMBIE;
+        task_release_memory(task);
         print_string("[TASK] Task ");
-        print_string(current_task->name);
+        print_string(task->name);
         print_string(" exited\n");
+        if (task->detached) {
+            task->zombie_next = zombie_list;
+            zombie_list = task;
+        }
         
-        // جدولة المهمة التالية
+        // جدولة المهمة التالية - لا عودة إلى هنا لأن المهمة المنتهية لا تُختار
         schedule();
     }
+    
+    // لا توجد مهمة جاهزة الآن: المؤقت سيبدل عند استيقاظ إحداها
+    enable_interrupts();
+    for (;;) {
+        asm volatile("hlt");
+    }
+}
+
+// انتهاء مهلة schedule_timeout: إيقاظ المهمة النائمة
+static void task_timeout(uint32_t data) {
+    task_wake((task_t*)data);
+}
+
+// النوم حتى task_wake أو انقضاء ticks، وتعيد الـ ticks المتبقية (0 = انقضت المهلة)
+// المؤقت على المكدس: يُلغى قبل العودة إن أُوقظت المهمة مبكراً
+int schedule_timeout(int ticks) {
+    ktimer_t timer;
+    uint32_t flags, expires;
+    int remaining;
+    
+    if (!current_task || ticks <= 0) {
+        return 0;
+    }
+    
+    flags = irq_save();
+    expires = get_timer_ticks() + ticks;
+    setup_timer(&timer, task_timeout, (uint32_t)current_task);
+    timer.expires = expires;
+    add_timer(&timer);
+    
+    current_task->state = TASK_SLEEPING;
+    schedule();
+    
+    del_timer(&timer);
+    remaining = (int)(expires - get_timer_ticks());
+    irq_restore(flags);
+    
+    return remaining > 0 ? remaining : 0;
 }
 
-// إيقاف المهمة مؤقتاً
+// إيقاف المهمة مؤقتاً لعدد ticks كامل (الإيقاظ المبكر يعيدها إلى النوم)
 void task_sleep(int ticks) {
-    if (current_task) {
-        current_task->state = TASK_SLEEPING;
-        schedule();
+    while (ticks > 0) {
+        ticks = schedule_timeout(ticks);
     }
 }
 
@@ -151,19 +631,23 @@ void task_sleep(int ticks) {
 void task_wake(task_t* task) {
     if (task && task->state == TASK_SLEEPING) {
         task->state = TASK_READY;
+        add_task_to_scheduler(task);
     }
 }
 
-// البحث عن مهمة بالمعرف
+// البحث عن مهمة بالمعرف - سلسلة hash واحدة (المعرفات المتتالية تتوزع على كل الخانات)
 task_t* find_task(int pid) {
-    task_t* task = task_list;
-    while (task) {
-        if (task->pid == pid) {
-            return task;
-        }
-        task = task->next;
+    task_t* task;
+    
+    if (pid < 0 || pid >= PID_MAX) {
+        return 0;
+    }
+    
+    task = pid_hash[pid & (PID_HASH_SIZE - 1)];
+    while (task && task->pid != pid) {
+        task = task->pid_next;
     }
-    return 0;
+    return task;
 }
 
 // طباعة معلومات المهام
@@ -176,18 +660,17 @@ void print_task_info() {
         print_string("None");
     }
     print_string("\n");
+    print_string("Tasks: ");
+    print_number(task_count);
+    print_string(", free PIDs: ");
+    print_number(pid_free);
+    print_string("\n");
     
     print_string("Task list:\n");
     task_t* task = task_list;
     while (task) {
         print_string("  PID: ");
-        // طباعة رقم PID (مبسطة)
-        if (task->pid < 10) {
-            print_char('0' + task->pid);
-        } else {
-            print_char('0' + (task->pid / 10));
-            print_char('0' + (task->pid % 10));
-        }
+        print_number(task->pid);
         
         print_string(" Name: ");
         print_string(task->name);
@@ -249,28 +732,63 @@ void print_task_info_by_pid(int pid) {
             print_string("UNKNOWN");
     }
     print_string("\n");
+    
+    // زمن المعالج الفعلي والافتراضي (SCHED_FAIR)
+    print_string("  cpu: ");
+    print_number((uint32_t)div_u64(task->sum_exec_runtime, 1000000));
+    print_string(" ms, vruntime: ");
+    print_number((uint32_t)div_u64(task->vruntime, 1000000));
+    print_string(" ms\n");
+    
+    // إحصائيات الذاكرة عند الطلب
+    if (task->page_faults) {
+        print_string("  heap: ");
+        print_number((task->brk - task->brk_start) / 1024);
+        print_string(" KB reserved, page faults: ");
+        print_number(task->page_faults);
+        print_string(", pages: ");
+        print_number(task->fault_pages);
+        print_string(", avg cycles: ");
+        print_number((uint32_t)div_u64(task->fault_cycles, task->page_faults));
+        print_string(" (");
+        print_number((uint32_t)div_u64(cycles_to_ns(task->fault_cycles), task->page_faults));
+        print_string(" ns)");
+        print_string("\n");
+    }
 }
 
-// حفظ سياق المهمة (مبسط)
-void save_task_context(task_t* task) {
-    // في تطبيق حقيقي، هنا نحفظ جميع السجلات
-    // __asm__ volatile ("mov %%esp, %0" : "=m" (task->esp));
-    // __asm__ volatile ("mov %%ebp, %0" : "=m" (task->ebp));
-}
-
-// استعادة سياق المهمة (مبسط)
-void restore_task_context(task_t* task) {
-    // في تطبيق حقيقي، هنا نستعيد جميع السجلات
-    // __asm__ volatile ("mov %0, %%esp" : : "m" (task->esp));
-    // __asm__ volatile ("mov %0, %%ebp" : : "m" (task->ebp));
-}
-
-// التبديل إلى مهمة (مبسط)
+// التبديل إلى مهمة: تحميل مساحة عناواينها ثم الانتقال إلى مكدسها
+// تعود الدالة عندما يعيد أحد التبديل إلى المهمة الحالية
 void switch_to_task(task_t* task) {
-    if (current_task) {
-        save_task_context(current_task);
+    uint32_t flags = irq_save();
+    cpu_t* cpu = this_cpu();
+    task_t* prev = cpu->current;
+    
+    if (!task || task == prev) {
+        irq_restore(flags);
+        return;
     }
     
-    current_task = task;
-    restore_task_context(task);
+    // المهمة السابقة تعود إلى الطابور إن بقيت قابلة للتشغيل
+    if (prev->state == TASK_RUNNING) {
+        prev->state = TASK_READY;
+    }
+    if (prev->state == TASK_READY) {
+        add_task_to_scheduler(prev);
+    }
+    remove_task_from_scheduler(task);
+    if (task->cpu != cpu->id) {
+        set_task_cpu(task, cpu->id);
+    }
+    task->state = TASK_RUNNING;
+    
+    // زمن السابقة حتى الآن، والتالية تُحاسب من هذه اللحظة
+    update_curr();
+    task->exec_start = prev->exec_start;
+    cpu->current = task;
+    
+    switch_page_directory(task->cr3);
+    switch_context(prev, task);
+    
+    irq_restore(flags);
 }
\ No newline at end of file
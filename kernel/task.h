@@ -2,6 +2,9 @@
 #define TASK_H
 
 #include "kernel.h"
+#include "rbtree.h"
+#include "timer.h"
+#include "smp.h"
 
 // حالات المهام - مستوحاة من Linux 0.01
 #define TASK_RUNNING     0  // المهمة قيد التشغيل
@@ -9,40 +12,106 @@
 #define TASK_SLEEPING    2  // المهمة نائمة
 #define TASK_ZOMBIE      3  // المهمة منتهية ولكن لم يتم تنظيفها
 
-// معرف المهمة
-#define MAX_TASKS        64
+// معرف المهمة: bitmap للمعرفات المستخدمة، والتخصيص يتقدم بعد آخر معرف
+// ويلتف عند PID_MAX حتى لا يُعاد استخدام معرف مهمة انتهت للتو
+#define PID_MAX          32768
+#define PID_HASH_SIZE    1024       // قوة للعدد 2: find_task في O(1)
 #define INVALID_PID      -1
 
+// الإشارات (bitmap في task->signal كما في Linux 0.01)
+#define SIGALRM          14
+
+// مكدس النواة لكل مهمة: كتلة 2^KERNEL_STACK_ORDER صفحات، أدناها صفحة حماية غير مربوطة
+#define KERNEL_STACK_ORDER 2
+#define TASK_ESP_OFFSET  12         // إزاحة esp في task_t (يستخدمها switch_asm.s)
+
+struct prio_array;
+struct syscall_frame;
+
 // هيكل بيانات المهمة - مبسط من Linux 0.01
 typedef struct task_struct {
     int pid;                    // معرف العملية
     int state;                  // حالة المهمة
     int priority;               // أولوية المهمة
-    uint32_t esp;              // مؤشر المكدس
+    uint32_t esp;              // مؤشر المكدس المحفوظ عند التبديل
     uint32_t ebp;              // مؤشر القاعدة
     uint32_t eip;              // مؤشر التعليمة
     uint32_t cr3;              // سجل صفحات الذاكرة
+    uint32_t kstack;           // كتلة مكدس النواة (0 = مكدس الإقلاع)
+    
+    // مساحة عناوين المستخدم
+    uint32_t brk_start;        // بداية كومة المستخدم
+    uint32_t brk;              // نهاية الكومة (محجوزة فقط حتى أول لمس)
+    uint32_t next_color;       // لون L2 للصفحة التالية عند تفعيل التلوين
+    
+    // إحصائيات أخطاء الصفحات
+    uint32_t page_faults;      // أخطاء الصفحات المعالجة
+    uint32_t fault_pages;      // الصفحات المربوطة عند الطلب
+    uint64_t fault_cycles;     // إجمالي دورات معالجة الأخطاء
     
     // معلومات إضافية
     char name[16];             // اسم المهمة
     int parent_pid;            // معرف المهمة الأب
     uint32_t start_time;       // وقت بداية المهمة
+    bool detached;             // لا أحد ينتظرها: تُحرر تلقائياً بعد task_exit
+    struct task_struct* zombie_next;  // قائمة المنتهية بانتظار التحرير
+    
+    // طابور التشغيل (scheduler.c)
+    int cpu;                            // المعالج الذي تنتظر في طابوره أو تعمل عليه
+    int time_slice;                     // ticks المتبقية من الشريحة الزمنية
+    struct prio_array* run_array;       // المصفوفة التي تحوي المهمة (NULL = خارج الطابور)
+    struct task_struct* run_next;       // حلقة المهام الجاهزة بنفس الأولوية
+    struct task_struct* run_prev;
     
-    // مؤشر للمهمة التالية في القائمة
+    // الجدولة العادلة (SCHED_FAIR): الزمن الافتراضي موزون بالأولوية، والمهام
+    // الجاهزة في شجرة حمراء-سوداء مرتبة به
+    uint64_t vruntime;                  // ns افتراضية (تتقدم أبطأ للأولوية الأعلى)
+    uint64_t sum_exec_runtime;          // إجمالي زمن المعالج الفعلي بالـ ns
+    uint64_t slice_start_runtime;       // sum_exec_runtime عند آخر اختيار للتشغيل
+    uint64_t exec_start;                // ktime_get_ns عند آخر محاسبة لزمن التشغيل
+    rb_node_t run_node;                 // العقدة في شجرة SCHED_FAIR
+    bool on_fair_rq;                    // داخل الشجرة الآن
+    
+    // المنبه (sys_alarm) والإشارات المعلقة
+    ktimer_t alarm;
+    uint32_t signal;
+    
+    // جدول hash للمعرفات
+    struct task_struct* pid_next;
+    
+    // قائمة كل المهام (مزدوجة الربط: إضافة وحذف في O(1))
     struct task_struct* next;
+    struct task_struct* prev;
 } task_t;
 
+// المهمة الحالية: لكل معالج مهمته (cpus[]->current)
+// قراءة واحدة من gs: أياً كان المعالج الذي ينفذها فمهمته الحالية هي المستدعي،
+// فلا حاجة لتعطيل المقاطعات حتى لو انتقلت المهمة (ولا يكتبها إلا معالجها)
+static inline task_t* get_current(void) {
+    task_t* task;
+    
+    asm volatile("movl %%gs:%c1, %0" : "=r" (task) : "i" (__builtin_offsetof(cpu_t, current)));
+    return task;
+}
+
+#define current_task get_current()
+
 // متغيرات عامة لإدارة المهام
-extern task_t* current_task;        // المهمة الحالية
 extern task_t* task_list;           // قائمة المهام
-extern int next_pid;                // معرف المهمة التالي
+extern int last_pid;                // آخر معرف خُصص
 
 // دوال إدارة المهام
 void init_task_manager();           // تهيئة مدير المهام
 task_t* create_task(const char* name, void* entry_point);  // إنشاء مهمة جديدة
+task_t* alloc_task(const char* name, void* entry_point);   // نفسها بدون طباعة
+task_t* fork_task(void* entry_point); // مهمة تبدأ من entry_point في نسخة COW من ذاكرة الحالية
+task_t* fork_syscall(struct syscall_frame* frame);  // ابن sys_fork يكمل بعد int 0x80
+void reap_task(task_t* task);       // تحرير مهمة منتهية
+bool reap_zombies(void);            // تحرير مهمة منفصلة منتهية (من حلقات الخمول)
 void schedule();                    // جدولة المهام
 void task_exit(int exit_code);      // إنهاء المهمة
 void task_sleep(int ticks);         // إيقاف المهمة مؤقتاً
+int schedule_timeout(int ticks);    // نوم حتى الإيقاظ أو انقضاء المهلة
 void task_wake(task_t* task);       // إيقاظ المهمة
 task_t* find_task(int pid);         // البحث عن مهمة بالمعرف
 void print_task_info();             // طباعة معلومات جميع المهام
@@ -50,7 +119,6 @@ void print_task_info_by_pid(int pid); // طباعة معلومات مهمة مح
 
 // دوال مساعدة
 void switch_to_task(task_t* task);  // التبديل إلى مهمة
-void save_task_context(task_t* task); // حفظ سياق المهمة
-void restore_task_context(task_t* task); // استعادة سياق المهمة
+extern void switch_context(task_t* from, task_t* to); // switch_asm.s
 
 #endif
\ No newline at end of file
@@ -0,0 +1,233 @@
+#include "timer.h"
+#include "interrupt.h"
+#include "memory.h"
+
+// العجلة العامة التي تديرها مقاطعة المؤقت
+static timer_base_t timer_base;
+
+// رقم الخانة في المستوى level (0 = أول مستوى بعد tv1) للـ tick المعطى
+#define TVN_INDEX(jiffies, level) \
+    (((jiffies) >> (TVR_BITS + (level) * TVN_BITS)) & TVN_MASK)
+
+// ربط مؤقت في بداية خانة
+static inline void timer_link(ktimer_t** head, ktimer_t* timer) {
+    timer->next = *head;
+    if (*head) {
+        (*head)->pprev = &timer->next;
+    }
+    *head = timer;
+    timer->pprev = head;
+}
+
+// فك مؤقت من خانته أياً كانت - O(1) بفضل pprev
+static inline void timer_unlink(ktimer_t* timer) {
+    *timer->pprev = timer->next;
+    if (timer->next) {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+// اختيار الخانة حسب بعد الموعد عن timer_jiffies
+static void internal_add_timer(timer_base_t* base, ktimer_t* timer) {
+    uint32_t expires = timer->expires;
+    uint32_t delta = expires - base->timer_jiffies;
+    ktimer_t** head;
+    
+    if ((int32_t)delta < 0) {
+        // الموعد فات: يُنفذ في الـ tick التالي
+        head = &base->tv1[base->timer_jiffies & TVR_MASK];
+    } else if (delta < TVR_SIZE) {
+        head = &base->tv1[expires & TVR_MASK];
+    } else if (delta < 1u << (TVR_BITS + TVN_BITS)) {
+        head = &base->tvn[0][TVN_INDEX(expires, 0)];
+    } else if (delta < 1u << (TVR_BITS + 2 * TVN_BITS)) {
+        head = &base->tvn[1][TVN_INDEX(expires, 1)];
+    } else if (delta < 1u << (TVR_BITS + 3 * TVN_BITS)) {
+        head = &base->tvn[2][TVN_INDEX(expires, 2)];
+    } else {
+        // حتى 2^31 tick (الفرق السالب عولج أعلاه)
+        head = &base->tvn[3][TVN_INDEX(expires, 3)];
+    }
+    
+    timer_link(head, timer);
+}
+
+// إعادة توزيع خانة من مستوى أعلى على المستويات الأدق
+// تعيد رقم الخانة: الصفر يعني أن المستوى التالي يحتاج cascade أيضاً
+static uint32_t cascade(timer_base_t* base, int level, uint32_t index) {
+    ktimer_t* timer = base->tvn[level][index];
+    ktimer_t* next;
+    
+    base->tvn[level][index] = NULL;
+    while (timer) {
+        next = timer->next;
+        internal_add_timer(base, timer);
+        timer = next;
+    }
+    
+    return index;
+}
+
+/**
+ * تهيئة عجلة فارغة تبدأ من الـ tick التالي لـ now
+ */
+void timer_base_init(timer_base_t* base, uint32_t now) {
+    memset(base, 0, sizeof(*base));
+    base->timer_jiffies = now + 1;
+}
+
+/**
+ * إضافة مؤقت غير مفعل إلى العجلة
+ */
+void timer_base_add(timer_base_t* base, ktimer_t* timer) {
+    if (timer_pending(timer)) {
+        return;
+    }
+    internal_add_timer(base, timer);
+    base->pending++;
+}
+
+/**
+ * حذف مؤقت مفعل من العجلة
+ */
+void timer_base_del(timer_base_t* base, ktimer_t* timer) {
+    if (!timer_pending(timer)) {
+        return;
+    }
+    timer_unlink(timer);
+    base->pending--;
+}
+
+/**
+ * معالجة كل الـ ticks حتى now وتنفيذ المؤقتات المنتهية
+ * (أكثر من tick بعد تعويض النبضة الديناميكية)
+ * تعيد عدد المؤقتات المنفذة
+ */
+uint32_t timer_base_run(timer_base_t* base, uint32_t now) {
+    ktimer_t* work;
+    ktimer_t* timer;
+    uint32_t index, expired = 0;
+    
+    while (time_after_eq(now, base->timer_jiffies)) {
+        index = base->timer_jiffies & TVR_MASK;
+    
+        // عند التفاف tv1 تنزل الخانة التالية من كل مستوى عند الحاجة
+        if (!index &&
+            !cascade(base, 0, TVN_INDEX(base->timer_jiffies, 0)) &&
+            !cascade(base, 1, TVN_INDEX(base->timer_jiffies, 1)) &&
+            !cascade(base, 2, TVN_INDEX(base->timer_jiffies, 2))) {
+            cascade(base, 3, TVN_INDEX(base->timer_jiffies, 3));
+        }
+        base->timer_jiffies++;
+    
+        // نقل الخانة إلى قائمة عمل: الدالة قد تعيد إضافة مؤقتها إلى نفس الخانة
+        work = base->tv1[index];
+        base->tv1[index] = NULL;
+        if (work) {
+            work->pprev = &work;
+        }
+        while ((timer = work)) {
+            timer_unlink(timer);
+            base->pending--;
+            expired++;
+            timer->function(timer->data);
+        }
+    }
+    
+    return expired;
+}
+
+/**
+ * تهيئة العجلة العامة عند الإقلاع
+ */
+void init_timers(void) {
+    timer_base_init(&timer_base, get_timer_ticks());
+}
+
+/**
+ * تهيئة مؤقت غير مفعل
+ */
+void setup_timer(ktimer_t* timer, timer_fn_t function, uint32_t data) {
+    timer->next = NULL;
+    timer->pprev = NULL;
+    timer->expires = 0;
+    timer->function = function;
+    timer->data = data;
+}
+
+/**
+ * تفعيل مؤقت عند timer->expires
+ */
+void add_timer(ktimer_t* timer) {
+    uint32_t flags = irq_save();
+    
+    timer_base_add(&timer_base, timer);
+    irq_restore(flags);
+}
+
+/**
+ * تغيير موعد مؤقت (وتفعيله إن لم يكن مفعلاً)
+ */
+bool mod_timer(ktimer_t* timer, uint32_t expires) {
+    uint32_t flags = irq_save();
+    bool was_pending = timer_pending(timer);
+    
+    timer_base_del(&timer_base, timer);
+    timer->expires = expires;
+    timer_base_add(&timer_base, timer);
+    
+    irq_restore(flags);
+    return was_pending;
+}
+
+/**
+ * إلغاء مؤقت
+ */
+bool del_timer(ktimer_t* timer) {
+    uint32_t flags = irq_save();
+    bool was_pending = timer_pending(timer);
+    
+    timer_base_del(&timer_base, timer);
+    
+    irq_restore(flags);
+    return was_pending;
+}
+
+/**
+ * تنفيذ المؤقتات المنتهية حتى الـ tick الحالي (من مقاطعة المؤقت)
+ */
+void run_timers(void) {
+    timer_base_run(&timer_base, get_timer_ticks());
+}
+
+/**
+ * عدد الـ ticks حتى أقرب حدث في العجلة، بحد أقصى max_ticks
+ * يكفي فحص خانات tv1 القادمة، مع التوقف عند أول cascade لأن مؤقتات
+ * المستويات الأعلى قد تنزل فيه
+ */
+uint32_t timer_next_event(uint32_t max_ticks) {
+    uint32_t now = get_timer_ticks();
+    uint32_t tick;
+    
+    // ticks مرت ولم تُعالج بعد
+    if (time_before(timer_base.timer_jiffies, now + 1)) {
+        return 1;
+    }
+    
+    for (tick = now + 1; tick != now + 1 + max_ticks; tick++) {
+        if ((tick & TVR_MASK) == 0 || timer_base.tv1[tick & TVR_MASK]) {
+            return tick - now;
+        }
+    }
+    
+    return max_ticks;
+}
+
+/**
+ * عدد المؤقتات المفعلة في العجلة العامة
+ */
+uint32_t get_pending_timers(void) {
+    return timer_base.pending;
+}
@@ -0,0 +1,60 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include "kernel.h"
+
+// مؤقتات النواة: عجلة توقيت هرمية (مثل Linux 2.6 kernel/timer.c)
+// المستوى الأول 256 خانة لكل tick، وأربعة مستويات بـ 64 خانة يغطي كل منها
+// مدى أكبر بـ 64 مرة؛ المؤقت يُنقل إلى مستوى أدق عندما يقترب موعده (cascade)
+// الإضافة والحذف O(1)، وانتهاء الصلاحية O(1) مستهلكة لكل tick
+#define TVR_BITS 8
+#define TVN_BITS 6
+#define TVR_SIZE (1 << TVR_BITS)
+#define TVN_SIZE (1 << TVN_BITS)
+#define TVR_MASK (TVR_SIZE - 1)
+#define TVN_MASK (TVN_SIZE - 1)
+#define TVN_LEVELS 4
+
+// مقارنة مواعيد بالـ ticks مع التفاف العداد
+#define time_after(a, b)     ((int32_t)((b) - (a)) < 0)
+#define time_after_eq(a, b)  ((int32_t)((a) - (b)) >= 0)
+#define time_before(a, b)    time_after(b, a)
+
+typedef void (*timer_fn_t)(uint32_t data);
+
+typedef struct ktimer {
+    struct ktimer* next;        // التالي في الخانة
+    struct ktimer** pprev;      // الرابط الذي يشير إلى هذا المؤقت (NULL = غير مفعل)
+    uint32_t expires;           // tick انتهاء الصلاحية
+    timer_fn_t function;        // تُستدعى من مقاطعة المؤقت والمقاطعات معطلة
+    uint32_t data;
+} ktimer_t;
+
+typedef struct {
+    uint32_t timer_jiffies;                 // الـ tick التالي الذي لم يُعالج بعد
+    ktimer_t* tv1[TVR_SIZE];
+    ktimer_t* tvn[TVN_LEVELS][TVN_SIZE];
+    uint32_t pending;                       // عدد المؤقتات في العجلة
+} timer_base_t;
+
+// عمليات العجلة (يستخدمها الاختبار مباشرة على عجلة خاصة)
+void timer_base_init(timer_base_t* base, uint32_t now);
+void timer_base_add(timer_base_t* base, ktimer_t* timer);
+void timer_base_del(timer_base_t* base, ktimer_t* timer);
+uint32_t timer_base_run(timer_base_t* base, uint32_t now);
+
+// مؤقتات النواة على العجلة العامة (آمنة مع المقاطعات)
+void init_timers(void);
+void setup_timer(ktimer_t* timer, timer_fn_t function, uint32_t data);
+void add_timer(ktimer_t* timer);                    // timer->expires محدد مسبقاً
+bool mod_timer(ktimer_t* timer, uint32_t expires);  // true إذا كان مفعلاً
+bool del_timer(ktimer_t* timer);                    // true إذا كان مفعلاً
+void run_timers(void);                              // من مقاطعة المؤقت
+uint32_t timer_next_event(uint32_t max_ticks);      // ticks حتى أقرب مؤقت (حتى max)
+uint32_t get_pending_timers(void);
+
+static inline bool timer_pending(const ktimer_t* timer) {
+    return timer->pprev != NULL;
+}
+
+#endif // TIMER_H
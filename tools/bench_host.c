@@ -0,0 +1,471 @@
+// اختبار أداء وfuzz لمخصص الذاكرة على المضيف: make bench-host
+//
+// يُترجم memory.c و slab.c كما هما مع CONFIG_HOST كبرنامج لينكس 32 بت مستقل
+// (بدون libc - استدعاءات النظام مباشرة عبر int 0x80، فلا يحتاج إلا gcc -m32).
+// منطقة الذاكرة [MEMORY_START, MEMORY_END) تُحجز بـ mmap في العنوان نفسه
+// فتعمل حسابات PFN والعناوين المطلقة في المخصص دون تعديل.
+//
+//   bench_host              أحمال العمل القياسية: ns/op و peak RSS والتجزئة
+//   bench_host fuzz [n] [s] n عملية عشوائية بالبذرة s مع فحص السلامة بعد كل عملية
+
+#include "kernel.h"
+#include "memory.h"
+#include "slab.h"
+#include "cpu.h"
+
+// استدعاءات نظام لينكس i386
+#define SYS_EXIT 1
+#define SYS_FORK 2
+#define SYS_WRITE 4
+#define SYS_WAITPID 7
+#define SYS_GETRUSAGE 77
+#define SYS_MMAP2 192
+#define SYS_CLOCK_GETTIME 265
+
+#define PROT_READ_WRITE 0x3
+#define MAP_PRIVATE_FIXED_ANON 0x32
+#define CLOCK_MONOTONIC 1
+
+// حجم أحمال العمل
+#define BENCH_OPS 1000000           // عمليات لكل حمل
+#define BENCH_SLOTS 2048            // مؤشرات حية في حمل الأحجام العشوائية
+#define BENCH_QUEUE 512             // عمق طابور المنتج/المستهلك
+#define BENCH_BUFFERS 256           // مخازن حمل نمو krealloc
+#define BENCH_GROW_LIMIT 0x10000    // أقصى حجم مخزن قبل إعادة البدء
+#define FUZZ_DEFAULT_OPS 20000
+#define FUZZ_SLOTS 512
+#define FUZZ_MAX_ORDER 4
+
+// معلومات المعالج: memory.c يختار مسار SSE2 منها، والنظام المضيف فعّل SSE مسبقاً
+cpu_info_t cpu_info;
+
+static inline int32_t syscall3(uint32_t nr, uint32_t a, uint32_t b, uint32_t c) {
+    int32_t ret;
+    asm volatile("int $0x80" : "=a" (ret) : "a" (nr), "b" (a), "c" (b), "d" (c) : "memory");
+    return ret;
+}
+
+static void host_exit(int code) {
+    syscall3(SYS_EXIT, code, 0, 0);
+    for (;;);
+}
+
+// mmap2 يحتاج ستة معاملات فيُستدعى منفصلاً
+static void* host_mmap(uint32_t addr, uint32_t length) {
+    int32_t ret;
+    asm volatile("pushl %%ebp\n\t"
+                 "movl $-1, %%ebp\n\t"      // fd = -1 (MAP_ANONYMOUS)
+                 "int $0x80\n\t"
+                 "popl %%ebp"
+                 : "=a" (ret)
+                 : "a" (SYS_MMAP2), "b" (addr), "c" (length), "d" (PROT_READ_WRITE),
+                   "S" (MAP_PRIVATE_FIXED_ANON), "D" (0)
+                 : "memory");
+    return (void*)ret;
+}
+
+// الزمن الرتيب بالنانوثانية
+static uint64_t host_now_ns(void) {
+    int32_t ts[2];
+    syscall3(SYS_CLOCK_GETTIME, CLOCK_MONOTONIC, (uint32_t)ts, 0);
+    return (uint64_t)ts[0] * 1000000000u + ts[1];
+}
+
+// أقصى RSS للعملية بالكيلوبايت (ru_maxrss بعد ru_utime و ru_stime)
+static uint32_t host_peak_rss_kb(void) {
+    int32_t usage[18];
+    syscall3(SYS_GETRUSAGE, 0, (uint32_t)usage, 0);
+    return usage[4];
+}
+
+// دوال الطباعة التي تستخدمها النواة - إلى stdout
+void print_string(const char* str) {
+    syscall3(SYS_WRITE, 1, (uint32_t)str, strlen(str));
+}
+
+void print_char(char c) {
+    syscall3(SYS_WRITE, 1, (uint32_t)&c, 1);
+}
+
+void print_number(uint32_t value) {
+    char buffer[11];
+    int i = 10;
+
+    buffer[i] = '\0';
+    do {
+        buffer[--i] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    print_string(&buffer[i]);
+}
+
+void print_hex(uint32_t value) {
+    char buffer[9];
+    int i;
+
+    for (i = 7; i >= 0; i--) {
+        buffer[i] = "0123456789ABCDEF"[value & 0xF];
+        value >>= 4;
+    }
+    buffer[8] = '\0';
+    print_string("0x");
+    print_string(buffer);
+}
+
+// مولد عشوائي xorshift32 - البذرة تجعل أي فشل قابلاً للتكرار
+static uint32_t rng_state = 1;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+// حجم طلب عشوائي: أغلبها صغيرة (slab) مع ذيل من الطلبات الكبيرة (الكتل المتغيرة)
+static uint32_t random_size(void) {
+    uint32_t r = rng() % 100;
+
+    if (r < 75) {
+        return 8 + rng() % 249;
+    }
+    if (r < 95) {
+        return 257 + rng() % 1792;
+    }
+    return 2049 + rng() % 14336;
+}
+
+// تحويل نص عشري إلى عدد
+static uint32_t parse_number(const char* str) {
+    uint32_t value = 0;
+
+    while (*str >= '0' && *str <= '9') {
+        value = value * 10 + (*str++ - '0');
+    }
+    return value;
+}
+
+static bool str_equal(const char* a, const char* b) {
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+/**
+ * حجز منطقة الذاكرة وتهيئة المخصص عليها
+ * boot_memory_map يشير إلى خريطة فارغة فيُستخدم MEMORY_END كنهاية للذاكرة
+ */
+static void host_init_memory(void) {
+    static e820_map_t empty_map;
+    uint32_t eax, ebx, ecx, edx;
+
+    if (host_mmap(MEMORY_START, MEMORY_END - MEMORY_START) != (void*)MEMORY_START) {
+        print_string("bench_host: cannot map arena at ");
+        print_hex(MEMORY_START);
+        print_string("\n");
+        host_exit(2);
+    }
+
+    cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+    cpu_info.features_edx = edx;
+    cpu_info.sse_enabled = (edx & CPUID_EDX_SSE2) != 0;
+
+    boot_memory_map = &empty_map;
+    init_memory_manager();
+    init_slab_allocator();
+}
+
+/**
+ * طباعة نتيجة حمل عمل: الزمن لكل عملية وأقصى RSS وأقصى مخصص والتجزئة
+ */
+static void bench_host_report(const char* name, uint64_t ns, uint32_t ops, uint32_t fragmentation) {
+    uint32_t tenths = (uint32_t)div_u64(ns * 10, ops);
+    memory_stats_t* stats = get_memory_stats();
+
+    print_string("  ");
+    print_string(name);
+    print_string(": ");
+    print_number(tenths / 10);
+    print_char('.');
+    print_number(tenths % 10);
+    print_string(" ns/op, peak RSS ");
+    print_number(host_peak_rss_kb());
+    print_string(" KB, peak allocated ");
+    print_number(stats->peak_allocated / 1024);
+    print_string(" KB, fragmentation ");
+    print_number(fragmentation);
+    print_string("%\n");
+}
+
+/**
+ * أحجام عشوائية: تخصيص أو تحرير خانة عشوائية
+ */
+static void workload_random(void) {
+    static void* slots[BENCH_SLOTS];
+    uint32_t fragmentation;
+    uint64_t start;
+    uint32_t i, slot;
+
+    start = host_now_ns();
+    for (i = 0; i < BENCH_OPS; i++) {
+        slot = rng() % BENCH_SLOTS;
+        if (slots[slot]) {
+            kfree(slots[slot]);
+            slots[slot] = NULL;
+        } else {
+            slots[slot] = kmalloc(random_size());
+        }
+    }
+    start = host_now_ns() - start;
+
+    fragmentation = calculate_fragmentation();
+    for (i = 0; i < BENCH_SLOTS; i++) {
+        kfree(slots[i]);
+    }
+    bench_host_report("random sizes", start, BENCH_OPS, fragmentation);
+}
+
+/**
+ * منتج/مستهلك: الرسائل تُخصص في رأس الطابور وتُحرر من ذيله (FIFO)
+ */
+static void workload_producer_consumer(void) {
+    static void* queue[BENCH_QUEUE];
+    uint32_t head = 0, tail = 0, depth = 0;
+    uint32_t fragmentation;
+    uint64_t start;
+    uint32_t i;
+
+    start = host_now_ns();
+    for (i = 0; i < BENCH_OPS / 2; i++) {
+        if (depth == BENCH_QUEUE || (depth > 0 && rng() % 2)) {
+            kfree(queue[tail]);
+            tail = (tail + 1) % BENCH_QUEUE;
+            depth--;
+        }
+        queue[head] = kmalloc(16 + rng() % 1009);
+        head = (head + 1) % BENCH_QUEUE;
+        depth++;
+    }
+    start = host_now_ns() - start;
+
+    fragmentation = calculate_fragmentation();
+    while (depth--) {
+        kfree(queue[tail]);
+        tail = (tail + 1) % BENCH_QUEUE;
+    }
+    bench_host_report("producer/consumer", start, BENCH_OPS, fragmentation);
+}
+
+/**
+ * نمو krealloc: مخازن تنمو بمعامل 1.5 حتى BENCH_GROW_LIMIT ثم تُحرر
+ */
+static void workload_realloc_growth(void) {
+    static void* buffers[BENCH_BUFFERS];
+    static uint32_t sizes[BENCH_BUFFERS];
+    memory_stats_t* stats;
+    uint32_t fragmentation;
+    uint64_t start;
+    uint32_t i, b;
+    void* grown;
+
+    start = host_now_ns();
+    for (i = 0; i < BENCH_OPS; i++) {
+        b = rng() % BENCH_BUFFERS;
+        if (sizes[b] >= BENCH_GROW_LIMIT) {
+            kfree(buffers[b]);
+            buffers[b] = NULL;
+            sizes[b] = 0;
+            continue;
+        }
+        sizes[b] = sizes[b] + sizes[b] / 2 + 16;
+        grown = krealloc(buffers[b], sizes[b]);
+        if (grown == NULL) {
+            kfree(buffers[b]);
+            sizes[b] = 0;
+        }
+        buffers[b] = grown;
+    }
+    start = host_now_ns() - start;
+
+    fragmentation = calculate_fragmentation();
+    for (i = 0; i < BENCH_BUFFERS; i++) {
+        kfree(buffers[i]);
+    }
+    bench_host_report("realloc growth", start, BENCH_OPS, fragmentation);
+
+    stats = get_memory_stats();
+    print_string("    in-place/copied: ");
+    print_number(stats->realloc_in_place);
+    print_string("/");
+    print_number(stats->realloc_copied);
+    print_string("\n");
+}
+
+// كل حمل في عملية مستقلة: منطقة جديدة ومخصص جديد و RSS خاص به
+static int run_isolated(void (*workload)(void)) {
+    int32_t status = 0;
+    int32_t pid = syscall3(SYS_FORK, 0, 0, 0);
+
+    if (pid == 0) {
+        host_init_memory();
+        workload();
+        host_exit(0);
+    }
+    syscall3(SYS_WAITPID, pid, (uint32_t)&status, 0);
+    return status;
+}
+
+// خانة في حمل fuzz: الكتلة وحجمها والبايت الذي مُلئت به
+typedef struct {
+    uint8_t* ptr;
+    uint32_t size;
+    uint8_t fill;
+    uint8_t order;              // FUZZ_PAGES_NONE لكتل kmalloc
+} fuzz_slot_t;
+
+#define FUZZ_PAGES_NONE 0xFF
+
+static fuzz_slot_t fuzz_slots[FUZZ_SLOTS];
+
+static void fuzz_fail(const char* what, uint32_t op, uint32_t seed) {
+    print_string("FUZZ FAIL: ");
+    print_string(what);
+    print_string(" at op ");
+    print_number(op);
+    print_string(", seed ");
+    print_number(seed);
+    print_string("\n");
+    host_exit(1);
+}
+
+// التحقق من أن الكتلة لم يكتب فوقها تخصيص آخر
+static bool fuzz_intact(fuzz_slot_t* slot, uint32_t length) {
+    uint32_t i;
+
+    for (i = 0; i < length; i++) {
+        if (slot->ptr[i] != slot->fill) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * fuzz: عمليات عشوائية على kmalloc/kcalloc/krealloc/kfree و alloc_pages/free_pages
+ * كل كتلة تُملأ ببايت خاص بها ويُتحقق منه عند التحرير، وتُفحص السلامة بعد كل عملية
+ */
+static void fuzz(uint32_t ops, uint32_t seed) {
+    fuzz_slot_t* slot;
+    uint32_t op, size, old_size, i;
+    uint8_t* ptr;
+
+    rng_state = seed ? seed : 1;
+    host_init_memory();
+
+    for (op = 0; op < ops; op++) {
+        slot = &fuzz_slots[rng() % FUZZ_SLOTS];
+
+        if (slot->ptr) {
+            if (!fuzz_intact(slot, slot->size)) {
+                fuzz_fail("block corrupted", op, seed);
+            }
+            if (slot->order == FUZZ_PAGES_NONE && rng() % 2) {
+                // krealloc: المحتوى القديم يجب أن يبقى حتى الأصغر من الحجمين
+                old_size = slot->size;
+                size = (rng() % 8 == 0) ? 1 + rng() % 65536 : 1 + rng() % 2048;
+                ptr = krealloc(slot->ptr, size);
+                if (ptr == NULL) {
+                    continue; // لا ذاكرة كافية: الكتلة القديمة باقية
+                }
+                slot->ptr = ptr;
+                slot->size = size;
+                if (!fuzz_intact(slot, old_size < size ? old_size : size)) {
+                    fuzz_fail("krealloc lost data", op, seed);
+                }
+                memset(slot->ptr, slot->fill, size);
+            } else {
+                if (slot->order == FUZZ_PAGES_NONE) {
+                    kfree(slot->ptr);
+                } else {
+                    free_pages(slot->ptr, slot->order);
+                }
+                slot->ptr = NULL;
+            }
+        } else {
+            slot->fill = (uint8_t)(op * 31 + 1);
+            slot->order = FUZZ_PAGES_NONE;
+            switch (rng() % 4) {
+            case 0:
+                slot->order = rng() % (FUZZ_MAX_ORDER + 1);
+                slot->size = PAGE_SIZE << slot->order;
+                slot->ptr = alloc_pages(slot->order);
+                break;
+            case 1:
+                slot->size = 1 + rng() % 4096;
+                slot->ptr = kcalloc(1, slot->size);
+                for (i = 0; slot->ptr && i < slot->size; i++) {
+                    if (slot->ptr[i] != 0) {
+                        fuzz_fail("kcalloc not zeroed", op, seed);
+                    }
+                }
+                break;
+            default:
+                slot->size = (rng() % 8 == 0) ? 1 + rng() % 65536 : 1 + rng() % 2048;
+                slot->ptr = kmalloc(slot->size);
+                break;
+            }
+            if (slot->ptr) {
+                memset(slot->ptr, slot->fill, slot->size);
+            }
+        }
+
+        if (check_memory_integrity() != 0) {
+            fuzz_fail("heap invariant broken", op, seed);
+        }
+    }
+
+    print_string("fuzz: ");
+    print_number(ops);
+    print_string(" ops, seed ");
+    print_number(seed);
+    print_string(": OK\n");
+    host_exit(0);
+}
+
+void bench_host_main(uint32_t* stack) {
+    uint32_t argc = stack[0];
+    char** argv = (char**)&stack[1];
+    int status = 0;
+
+    if (argc > 1 && str_equal(argv[1], "fuzz")) {
+        fuzz(argc > 2 ? parse_number(argv[2]) : FUZZ_DEFAULT_OPS,
+             argc > 3 ? parse_number(argv[3]) : 1);
+    }
+
+    print_string("=== Host allocator benchmark ===\n");
+    print_string("arena ");
+    print_hex(MEMORY_START);
+    print_string(" - ");
+    print_hex(MEMORY_END);
+    print_string(", ");
+    print_number(BENCH_OPS);
+    print_string(" ops per workload\n");
+
+    status |= run_isolated(workload_random);
+    status |= run_isolated(workload_producer_consumer);
+    status |= run_isolated(workload_realloc_growth);
+    host_exit(status ? 1 : 0);
+}
+
+// نقطة الدخول: المكدس يحوي argc ثم argv
+asm(".globl _start\n"
+    "_start:\n\t"
+    "xorl %ebp, %ebp\n\t"
+    "movl %esp, %eax\n\t"
+    "andl $-16, %esp\n\t"
+    "subl $12, %esp\n\t"
+    "pushl %eax\n\t"
+    "call bench_host_main\n\t"
+    "hlt");